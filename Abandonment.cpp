@@ -0,0 +1,75 @@
+#include "Abandonment.hpp"
+#include <cmath>
+
+// Check a patience spec before it is turned into a sampler
+bool validatePatienceSpec(const PatienceSpec& spec, std::string& error) {
+    if (!spec.enabled) {
+        return true;
+    }
+    if (spec.time.batchSize != 1) {
+        error = "patience cannot be batched";
+        return false;
+    }
+    return validateServiceSpec(spec.time, error);
+}
+
+bool validateRetrySpec(const RetrySpec& spec, std::string& error) {
+    if (spec.maxAttempts < 1) {
+        error = "max_attempts must be at least 1";
+        return false;
+    }
+    if (!(spec.probability >= 0.0 && spec.probability <= 1.0)) {
+        error = "the retry probability must be in [0, 1]";
+        return false;
+    }
+    if (!(spec.backoffHours >= 0.0) || !(spec.backoffFactor >= 1.0)) {
+        error = "expected backoff_minutes >= 0 and backoff_factor >= 1";
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Abandonment class
+//------------------------------------------------------------------------------
+Abandonment::Abandonment(const PatienceSpec (&patience)[PATIENCE_PRIORITIES], const RetrySpec& retry,
+    std::uint64_t seed, bool antithetic)
+    : retry_(retry),
+    seed_(seed),
+    antithetic_(antithetic)
+{
+    models_.reserve(PATIENCE_PRIORITIES);
+    for (int p = 0; p < PATIENCE_PRIORITIES; ++p) {
+        model_[p] = -1;
+        if (patience[p].enabled) {
+            model_[p] = static_cast<int>(models_.size());
+            models_.emplace_back(patience[p].time);
+        }
+    }
+}
+
+// Patience of an attempt of a request, hours
+double Abandonment::patience(int priority, int requestId, int attempt) const {
+    double u = keyedUniform(seed_, streamId(StreamKind::PATIENCE, requestId, attempt), antithetic_);
+    return models_[model_[priority]].quantile(u);
+}
+
+// Whether the lost attempt comes back
+bool Abandonment::retries(int requestId, int attempt) const {
+    if (attempt + 1 >= retry_.maxAttempts) {
+        return false;
+    }
+    return retry_.probability >= 1.0
+        || keyedUniform(seed_, streamId(StreamKind::RETRY, requestId, attempt), antithetic_) < retry_.probability;
+}
+
+// Full-jitter backoff before the next attempt
+double Abandonment::backoff(int requestId, int attempt) const {
+    double u = keyedUniform(seed_, streamId(StreamKind::BACKOFF, requestId, attempt), antithetic_);
+    return 2.0 * u * retry_.backoffHours * std::pow(retry_.backoffFactor, attempt);
+}
+
+// Key later draws by another seed
+void Abandonment::reseed(std::uint64_t seed) {
+    seed_ = seed;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ServiceModel.hpp"
+
+//------------------------------------------------------------------------------
+// Abandonment: patience in the buffer and retries of the requests turned away
+//------------------------------------------------------------------------------
+//
+// A request of a priority with patience schedules a RENEGE event when it
+// enters the buffer and leaves unserved if that fires first. A rejected,
+// evicted or reneged request may come back after a backoff, through the
+// arrival path of the Controller. Every draw is the uniform keyed by (seed, request id,
+// attempt), so configs compared on one seed draw the same patience and
+// backoff for the same request, whatever happened to the others.
+
+// Priorities patience is given for (checked against PRIORITY_COUNT)
+static const int PATIENCE_PRIORITIES = 3;
+
+// Time a request of one priority waits in the buffer before it reneges
+struct PatienceSpec {
+    bool enabled = false; // false: waits until served or evicted
+    ServiceSpec time;     // distribution of the patience (hours; batching unused)
+};
+
+// What a rejected, evicted or reneged request does next
+struct RetrySpec {
+    int maxAttempts = 1;       // arrivals per request, the first included; 1: no retries
+    double probability = 1.0;  // share of the lost attempts that retry
+    double backoffHours = 5.0 / 60.0; // mean backoff after the first attempt ...
+    double backoffFactor = 2.0;       // ... times this per further attempt
+};
+
+// Check the specs before they are turned into an Abandonment
+bool validatePatienceSpec(const PatienceSpec& spec, std::string& error);
+bool validateRetrySpec(const RetrySpec& spec, std::string& error);
+
+// The samplers of the patience of each priority and the retry decisions
+class Abandonment {
+private:
+    std::vector<ServiceModel> models_;   // one per priority with patience
+    int model_[PATIENCE_PRIORITIES];     // index into models_, -1: none
+    RetrySpec retry_;
+    std::uint64_t seed_;
+    bool antithetic_;
+
+public:
+    Abandonment(const PatienceSpec (&patience)[PATIENCE_PRIORITIES], const RetrySpec& retry,
+        std::uint64_t seed, bool antithetic);
+
+    // Requests of the priority renege / of any priority
+    bool hasPatience(int priority) const { return model_[priority] >= 0; }
+    bool anyPatience() const { return !models_.empty(); }
+    // Lost attempts may come back
+    bool anyRetries() const { return retry_.maxAttempts > 1 && retry_.probability > 0.0; }
+
+    // Patience of an attempt of a request, hours; the priority has patience
+    double patience(int priority, int requestId, int attempt) const;
+    // Whether the lost attempt comes back (attempt counts from 0)
+    bool retries(int requestId, int attempt) const;
+    // Full-jitter backoff before the next attempt: uniform on [0, 2 b),
+    // b = backoffHours * backoffFactor^attempt (Brooker, 2015)
+    double backoff(int requestId, int attempt) const;
+
+    // Key later draws by another seed
+    void reseed(std::uint64_t seed);
+};
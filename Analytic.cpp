@@ -0,0 +1,227 @@
+#include "Analytic.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// Rescale the running sums of solveMMcK before they overflow
+const double SCALE_LIMIT = 1e200;
+
+// Share of time a birth-death chain with ratio r on 0..places is at places
+double truncatedGeometricTop(double ratio, int places) {
+    if (std::fabs(ratio - 1.0) < 1e-12) {
+        return 1.0 / (places + 1);
+    }
+    return std::pow(ratio, places) * (1.0 - ratio) / (1.0 - std::pow(ratio, places + 1));
+}
+
+// Arrival rate of one source of a priority at time t, as ArrivalProfile draws it
+double specRate(const ArrivalSpec& spec, double timeHours) {
+    if (spec.rates.empty()) {
+        return spec.sinusoid(timeHours);
+    }
+    double cycles = timeHours / spec.sinusoid.periodHours;
+    std::size_t bin = static_cast<std::size_t>((cycles - std::floor(cycles)) * spec.rates.size());
+    return spec.rates[std::min(bin, spec.rates.size() - 1)];
+}
+
+bool constantRate(const ArrivalSpec& spec) {
+    if (spec.rates.empty()) {
+        return spec.sinusoid.amplitude == 0.0;
+    }
+    return std::all_of(spec.rates.begin(), spec.rates.end(),
+        [&spec](double rate) { return rate == spec.rates.front(); });
+}
+
+} // namespace
+
+// Solve M/M/c/K for arrival rate lambda and service rate mu per server
+QueueMetrics solveMMcK(double lambda, double mu, int servers, int waitingPlaces) {
+    QueueMetrics metrics;
+    if (servers <= 0 || mu <= 0.0) {
+        metrics.blocking = 1.0;
+        return metrics;
+    }
+    // Unnormalized p_n = a^n / n! up to c, then times (a / c) per waiting place
+    double load = lambda / mu;
+    double term = 1.0;
+    double total = 1.0;
+    double busy = 0.0;
+    double queued = 0.0;
+    double saturated = 0.0; // states with every server busy
+    for (int n = 1; n <= servers + waitingPlaces; ++n) {
+        int serving = std::min(n, servers);
+        term *= load / serving;
+        total += term;
+        busy += serving * term;
+        if (n > servers) {
+            queued += (n - servers) * term;
+        }
+        if (n >= servers) {
+            saturated += term;
+        }
+        if (term > SCALE_LIMIT) {
+            term /= SCALE_LIMIT;
+            total /= SCALE_LIMIT;
+            busy /= SCALE_LIMIT;
+            queued /= SCALE_LIMIT;
+            saturated /= SCALE_LIMIT;
+        }
+    }
+    metrics.blocking = term / total;
+    metrics.meanQueue = queued / total;
+    metrics.utilization = busy / total / servers;
+    metrics.allBusy = saturated / total;
+    double admitted = lambda * (1.0 - metrics.blocking);
+    metrics.meanWait = (admitted > 0.0) ? metrics.meanQueue / admitted : 0.0;
+    return metrics;
+}
+
+// Erlang C by the stable Erlang B recursion
+double erlangC(int servers, double offeredLoad) {
+    if (offeredLoad >= servers) {
+        return 1.0;
+    }
+    double blocking = 1.0;
+    for (int n = 1; n <= servers; ++n) {
+        blocking = offeredLoad * blocking / (n + offeredLoad * blocking);
+    }
+    return servers * blocking / (servers - offeredLoad * (1.0 - blocking));
+}
+
+// Cobham's mean wait per class of a non-preemptive priority M/M/c queue
+void priorityWaitMMc(const double (&lambda)[PRIORITY_COUNT], double mu, int servers,
+    double (&wait)[PRIORITY_COUNT]) {
+    double capacity = servers * mu;
+    double total = 0.0;
+    for (double rate : lambda) {
+        total += rate;
+    }
+    double base = (capacity > 0.0) ? erlangC(servers, total / mu) / capacity : 0.0;
+    double above = 0.0; // load of the higher priorities
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        double upTo = above + lambda[p] / capacity;
+        wait[p] = (capacity > 0.0 && upTo < 1.0)
+            ? base / ((1.0 - above) * (1.0 - upTo))
+            : std::numeric_limits<double>::infinity();
+        above = upTo;
+    }
+}
+
+//------------------------------------------------------------------------------
+// AnalyticEstimate struct
+//------------------------------------------------------------------------------
+
+// The M/M/c/K steady state is the actual model of the config
+bool AnalyticEstimate::exact() const {
+    return exponential && stationary;
+}
+
+// Estimate the metrics of config (microseconds, no simulation)
+AnalyticEstimate analyzeConfig(const SimulationConfig& config) {
+    AnalyticEstimate estimate;
+    const int servers = config.numDevices;
+    const int places = config.bufferCapacity;
+
+    // Fleet service rate: the mean of the device rates
+    ServiceSpec fallback = exponentialService(1.0 / SERVICE_RATE);
+    const ServiceSpec& first = config.deviceClasses.empty()
+        ? fallback : config.deviceClasses[config.deviceClassOf(0)].service;
+    double rateSum = 0.0;
+    estimate.exponential = true;
+    for (int i = 0; i < servers; ++i) {
+        const ServiceSpec& service = config.deviceClasses.empty()
+            ? fallback : config.deviceClasses[config.deviceClassOf(i)].service;
+        double mean = (service.kind == ServiceKind::EMPIRICAL) ? ServiceModel(service).getMean() : service.meanHours;
+        rateSum += (mean > 0.0) ? 1.0 / mean : 0.0;
+        estimate.exponential = estimate.exponential && service.kind == ServiceKind::EXPONENTIAL
+            && service.meanHours == first.meanHours && service.batchSize == 1;
+    }
+    double mu = (servers > 0) ? rateSum / servers : 0.0;
+    estimate.serviceRate = mu;
+
+    const int sources[PRIORITY_COUNT] = { config.numCorporate, config.numPremium, config.numFree };
+    double period = 0.0;
+    estimate.stationary = true;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (sources[p] > 0) {
+            period = std::max(period, config.arrivals[p].sinusoid.periodHours);
+            estimate.stationary = estimate.stationary && constantRate(config.arrivals[p]);
+        }
+    }
+    const int points = estimate.stationary ? 1 : ANALYTIC_TIME_POINTS;
+
+    // Sums over the time points, each an instant of its own steady state
+    double arrivals = 0.0;
+    double lost = 0.0;
+    double queued = 0.0;
+    double admitted = 0.0;
+    double busy = 0.0;
+    double arrivalsBy[PRIORITY_COUNT] = {};
+    double lostBy[PRIORITY_COUNT] = {};
+    double waitBy[PRIORITY_COUNT] = {};
+    for (int k = 0; k < points; ++k) {
+        double t = (k + 0.5) * period / points;
+        double lambda[PRIORITY_COUNT];
+        double total = 0.0;
+        for (int p = 0; p < PRIORITY_COUNT; ++p) {
+            lambda[p] = sources[p] * specRate(config.arrivals[p], t);
+            total += lambda[p];
+        }
+
+        QueueMetrics all = solveMMcK(total, mu, servers, places);
+        arrivals += total;
+        lost += total * all.blocking;
+        queued += all.meanQueue;
+        admitted += total * (1.0 - all.blocking);
+        busy += all.utilization;
+
+        // Priorities 0..p lose what their own chain loses beyond 0..p-1
+        double upTo = 0.0;
+        double lostAbove = 0.0;
+        for (int p = 0; p < PRIORITY_COUNT; ++p) {
+            upTo += lambda[p];
+            double lostUpTo = (p == PRIORITY_COUNT - 1) ? total * all.blocking
+                : upTo * all.allBusy * truncatedGeometricTop(upTo / (servers * mu), places);
+            arrivalsBy[p] += lambda[p];
+            lostBy[p] += std::max(0.0, lostUpTo - lostAbove);
+            lostAbove = std::max(lostAbove, lostUpTo);
+        }
+        double wait[PRIORITY_COUNT];
+        priorityWaitMMc(lambda, mu, servers, wait);
+        for (int p = 0; p < PRIORITY_COUNT; ++p) {
+            waitBy[p] += (lambda[p] > 0.0) ? lambda[p] * wait[p] : 0.0;
+        }
+    }
+
+    estimate.arrivalRate = arrivals / points;
+    estimate.rejectionRate = (arrivals > 0.0) ? lost / arrivals : 0.0;
+    estimate.averageWaitTime = (admitted > 0.0) ? queued / admitted : 0.0;
+    estimate.utilization = busy / points;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        estimate.rejectionByPriority[p] = (arrivalsBy[p] > 0.0) ? lostBy[p] / arrivalsBy[p] : 0.0;
+        estimate.waitByPriority[p] = (arrivalsBy[p] > 0.0) ? waitBy[p] / arrivalsBy[p] : 0.0;
+    }
+    return estimate;
+}
+
+// Print an AnalyticEstimate in the layout of Controller::printStatistics
+void printAnalyticEstimate(const AnalyticEstimate& estimate) {
+    std::cout << "\n--- Analytic estimate ("
+        << (estimate.stationary ? "M/M/c/K" : "pointwise stationary M/M/c/K")
+        << (estimate.exponential ? "" : ", fleet taken as exponential") << ") ---\n";
+    std::cout << "Arrival rate:   " << estimate.arrivalRate << " per hour\n";
+    std::cout << "Service rate:   " << estimate.serviceRate << " per hour and device\n";
+    std::cout << "Rejection rate: " << (estimate.rejectionRate * 100.0) << " %\n";
+    std::cout << "Rejected Corporate: " << (estimate.rejectionByPriority[static_cast<int>(Priority::CORPORATE)] * 100.0) << " %\n";
+    std::cout << "Rejected Premium:   " << (estimate.rejectionByPriority[static_cast<int>(Priority::PREMIUM)] * 100.0) << " %\n";
+    std::cout << "Rejected Free:      " << (estimate.rejectionByPriority[static_cast<int>(Priority::FREE)] * 100.0) << " %\n";
+    std::cout << "Average waiting time (hours): " << estimate.averageWaitTime
+        << " (~" << (estimate.averageWaitTime * 60.0) << " min)\n";
+    std::cout << "Wait by priority (unbounded buffer, min): "
+        << (estimate.waitByPriority[0] * 60.0) << " / " << (estimate.waitByPriority[1] * 60.0)
+        << " / " << (estimate.waitByPriority[2] * 60.0) << "\n";
+    std::cout << "Devices utilization: " << (estimate.utilization * 100.0) << " %\n";
+}
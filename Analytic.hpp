@@ -0,0 +1,65 @@
+#pragma once
+#include "Simulation.hpp"
+
+//------------------------------------------------------------------------------
+// Closed-form queueing models: M/M/c/K and non-preemptive priority M/M/c
+//------------------------------------------------------------------------------
+
+// Time points per period at which a varying arrival rate is evaluated
+static const int ANALYTIC_TIME_POINTS = 288;
+
+// Steady state of an M/M/c/K queue (c servers, K waiting places)
+struct QueueMetrics {
+    double blocking = 0.0;    // share of arrivals that find the system full
+    double meanQueue = 0.0;   // mean number waiting (Lq)
+    double meanWait = 0.0;    // hours waited per admitted request (Little)
+    double utilization = 0.0; // busy share of one server
+    double allBusy = 0.0;     // probability that every server is busy
+};
+
+// Solve M/M/c/K for arrival rate lambda and service rate mu per server.
+// O(c + K), scaled as it goes, so large fleets do not overflow.
+QueueMetrics solveMMcK(double lambda, double mu, int servers, int waitingPlaces);
+
+// Erlang C: probability of waiting in M/M/c with offered load a = lambda/mu
+// (1 when a >= c)
+double erlangC(int servers, double offeredLoad);
+
+// Cobham's mean wait per class of a non-preemptive priority M/M/c queue with
+// an unbounded buffer, class 0 first; infinity for a class that is saturated
+void priorityWaitMMc(const double (&lambda)[PRIORITY_COUNT], double mu, int servers,
+    double (&wait)[PRIORITY_COUNT]);
+
+// Model estimate of the printStatistics metrics of a config. Arrivals that
+// vary over time are treated by the pointwise stationary approximation: the
+// models are solved at ANALYTIC_TIME_POINTS instants of the period and
+// averaged weighted by arrivals. Totals come from M/M/c/K on the sum of all
+// priorities; since eviction swaps one request for another, this is exact
+// for the total loss when the model applies. Per priority, the requests of
+// priorities 0..p waiting while every device is busy are taken as a
+// birth-death chain of rate lambda(0..p) against c * mu, truncated at the
+// buffer size (lower priorities never displace them, and each completion
+// serves them first); the last priority takes the rest of the exact total.
+// Waits per priority come from Cobham's formula. Both are approximations.
+struct AnalyticEstimate {
+    bool exponential = false; // every device exponential with one mean
+    bool stationary = false;  // constant arrival rates
+    double arrivalRate = 0.0; // per hour, all sources, averaged over time
+    double serviceRate = 0.0; // per hour and device
+    double rejectionRate = 0.0;
+    double averageWaitTime = 0.0; // hours
+    double utilization = 0.0;
+    double rejectionByPriority[PRIORITY_COUNT] = {}; // share of each priority's arrivals
+    double waitByPriority[PRIORITY_COUNT] = {};      // hours
+
+    // The M/M/c/K steady state is the actual model of the config
+    bool exact() const;
+};
+
+// Estimate the metrics of config (microseconds, no simulation). With any
+// non-exponential, mixed or batching device class, the fleet is taken as
+// exponential at its mean single-request rate and exponential stays false.
+AnalyticEstimate analyzeConfig(const SimulationConfig& config);
+
+// Print an AnalyticEstimate in the layout of Controller::printStatistics
+void printAnalyticEstimate(const AnalyticEstimate& estimate);
@@ -0,0 +1,208 @@
+#include "ArrivalProfile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Rate samples per bin used to bound an analytic rate
+const int ENVELOPE_SAMPLES = 8;
+
+const double PI = 3.14159265358979323846;
+
+} // namespace
+
+// Rate at time t; the phase is taken within one period so that the curve
+// repeats exactly and matches the precomputed envelope at any time
+double SinusoidRate::operator()(double timeHours) const {
+    double cycles = timeHours / periodHours;
+    double phase = 2.0 * PI * (cycles - std::floor(cycles));
+    double rate = mean + amplitude * std::sin(phase);
+
+    // Ensure it's positive
+    if (rate <= 0) {
+        rate = 0.01;
+    }
+    return rate;
+}
+
+//------------------------------------------------------------------------------
+// ArrivalProfile class
+//------------------------------------------------------------------------------
+ArrivalProfile::ArrivalProfile()
+    : ArrivalProfile(SinusoidRate())
+{
+}
+
+// Bound a sinusoid on `bins` bins per period. Each bin is sampled at
+// ENVELOPE_SAMPLES + 1 points and widened by the largest step between
+// adjacent samples, which covers the variation between samples of a smooth rate.
+ArrivalProfile::ArrivalProfile(const SinusoidRate& sinusoid, int bins)
+    : period_(sinusoid.periodHours),
+    invPeriod_(1.0 / sinusoid.periodHours),
+    binWidth_(sinusoid.periodHours / bins),
+    invBinWidth_(bins / sinusoid.periodHours),
+    upper_(bins),
+    lower_(bins),
+    sinusoid_(sinusoid),
+    analytic_(true)
+{
+    double step = binWidth_ / ENVELOPE_SAMPLES;
+    for (int i = 0; i < bins; ++i) {
+        double start = i * binWidth_;
+        double prev = sinusoid_(start);
+        double hi = prev;
+        double lo = prev;
+        double slack = 0.0;
+        for (int k = 1; k <= ENVELOPE_SAMPLES; ++k) {
+            double r = sinusoid_(start + k * step);
+            hi = std::max(hi, r);
+            lo = std::min(lo, r);
+            slack = std::max(slack, std::fabs(r - prev));
+            prev = r;
+        }
+        upper_[i] = hi + slack;
+        lower_[i] = std::max(0.0, lo - slack);
+    }
+    buildCumulative();
+}
+
+// Piecewise-constant rates: envelope and squeeze coincide, nothing is thinned
+ArrivalProfile::ArrivalProfile(const std::vector<double>& rates, double periodHours)
+    : period_(periodHours),
+    invPeriod_(1.0 / periodHours),
+    binWidth_(periodHours / rates.size()),
+    invBinWidth_(rates.size() / periodHours),
+    upper_(rates),
+    analytic_(false)
+{
+    for (double& r : upper_) {
+        r = std::max(0.0, r);
+    }
+    lower_ = upper_;
+    buildCumulative();
+}
+
+// Whichever of the two the spec describes
+ArrivalProfile::ArrivalProfile(const ArrivalSpec& spec)
+    : ArrivalProfile(spec.rates.empty()
+        ? ArrivalProfile(spec.sinusoid)
+        : ArrivalProfile(spec.rates, spec.sinusoid.periodHours))
+{
+}
+
+void ArrivalProfile::buildCumulative() {
+    cumulative_.assign(upper_.size() + 1, 0.0);
+    invUpper_.assign(upper_.size(), 0.0);
+    for (std::size_t i = 0; i < upper_.size(); ++i) {
+        cumulative_[i + 1] = cumulative_[i] + upper_[i] * binWidth_;
+        if (upper_[i] > 0.0) {
+            invUpper_[i] = 1.0 / upper_[i];
+        }
+    }
+
+    // guide_[g] = last bin whose integral starts at or below slice g
+    const int bins = getBins();
+    const double total = cumulative_[bins];
+    guide_.assign(bins, 0);
+    int k = 0;
+    for (int g = 0; g < bins; ++g) {
+        double level = total * g / bins;
+        while (k + 1 < bins && cumulative_[k + 1] <= level) {
+            ++k;
+        }
+        guide_[g] = k;
+    }
+}
+
+// Exact rate at time t (hours)
+double ArrivalProfile::rate(double timeHours) const {
+    if (analytic_) {
+        return sinusoid_(timeHours);
+    }
+    double phase = timeHours - std::floor(timeHours * invPeriod_) * period_;
+    int bin = std::min(static_cast<int>(phase * invBinWidth_), getBins() - 1);
+    return upper_[bin];
+}
+
+// Time of the next arrival after t. A unit exponential is mapped through the
+// inverse of the envelope's cumulative integral (wrapping over whole periods),
+// then the candidate is thinned with probability rate / envelope.
+double ArrivalProfile::nextArrival(double timeHours, VariateStream& rng) const {
+    const int bins = getBins();
+    const double total = cumulative_[bins];
+    if (total <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double invTotal = 1.0 / total;
+
+    double t = timeHours;
+    for (;;) {
+        double cycleStart = std::floor(t * invPeriod_) * period_;
+        double phase = t - cycleStart;
+        int bin = std::min(static_cast<int>(phase * invBinWidth_), bins - 1);
+
+        double target = cumulative_[bin] + upper_[bin] * (phase - bin * binWidth_)
+            + rng.exponential(1.0);
+        double cycles = std::floor(target * invTotal);
+        target -= cycles * total;
+
+        int k = guide_[std::min(static_cast<int>(target * invTotal * bins), bins - 1)];
+        while (k + 1 < bins && cumulative_[k + 1] <= target) {
+            ++k;
+        }
+        double local = k * binWidth_ + (target - cumulative_[k]) * invUpper_[k];
+        t = cycleStart + cycles * period_ + local;
+
+        if (lower_[k] >= upper_[k]) {
+            return t;
+        }
+        // 32 bits are plenty to resolve the acceptance ratio
+        double u = rng() * (1.0 / 4294967296.0) * upper_[k];
+        if (u < lower_[k] || u < rate(t)) {
+            return t;
+        }
+    }
+}
+
+double ArrivalProfile::getPeriod() const {
+    return period_;
+}
+
+int ArrivalProfile::getBins() const {
+    return static_cast<int>(upper_.size());
+}
+
+// Read whitespace-separated rates ('#' starts a comment); false on error
+bool loadRateProfile(const std::string& path, std::vector<double>& rates) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::vector<double> values;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream fields(line);
+        double value;
+        while (fields >> value) {
+            if (value < 0.0) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        if (!fields.eof()) {
+            return false;
+        }
+    }
+    if (values.empty()) {
+        return false;
+    }
+    rates = values;
+    return true;
+}
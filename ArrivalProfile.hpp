@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Random.hpp"
+
+//------------------------------------------------------------------------------
+// Non-homogeneous Poisson arrivals by thinning (Lewis-Shedler)
+//------------------------------------------------------------------------------
+
+// Number of envelope bins over one period of an analytic rate (one per minute)
+static const int ARRIVAL_ENVELOPE_BINS = 1440;
+
+// Day/night curve: mean + amplitude * sin(2 pi t / period), floored at 0.01
+struct SinusoidRate {
+    double mean = 0.45;      // requests per hour per source
+    double amplitude = 0.25;
+    double periodHours = 24.0;
+
+    double operator()(double timeHours) const;
+};
+
+// Arrival rate of one priority: measured rates if given, else the sinusoid
+struct ArrivalSpec {
+    SinusoidRate sinusoid;
+    std::vector<double> rates; // spread evenly over sinusoid.periodHours
+};
+
+// Periodic arrival rate with a piecewise-constant upper envelope and lower
+// squeeze per bin. Candidates are drawn from the envelope by inverting its
+// cumulative integral through a guide table, so a single exponential crosses
+// any number of bins with a short scan; a candidate below the squeeze is
+// accepted without evaluating the rate.
+class ArrivalProfile {
+private:
+    double period_;
+    double invPeriod_;
+    double binWidth_;
+    double invBinWidth_;
+    std::vector<double> upper_;      // envelope rate of each bin
+    std::vector<double> invUpper_;   // 1 / upper_ (0 for empty bins)
+    std::vector<double> lower_;      // squeeze rate of each bin
+    std::vector<double> cumulative_; // integral of the envelope up to each bin
+    std::vector<int> guide_;         // first bin of each equal slice of the integral
+    SinusoidRate sinusoid_;
+    bool analytic_;                  // false: the bins are the exact rate
+
+    void buildCumulative();
+
+public:
+    // The built-in day/night curve of getArrivalRate
+    ArrivalProfile();
+    // Bound a sinusoid on `bins` bins per period
+    explicit ArrivalProfile(const SinusoidRate& sinusoid, int bins = ARRIVAL_ENVELOPE_BINS);
+    // Piecewise-constant rates, e.g. one per hour of measured traffic
+    explicit ArrivalProfile(const std::vector<double>& rates, double periodHours = 24.0);
+    // Whichever of the two the spec describes
+    explicit ArrivalProfile(const ArrivalSpec& spec);
+
+    // Exact rate at time t (hours)
+    double rate(double timeHours) const;
+    // Time of the next arrival after t
+    double nextArrival(double timeHours, VariateStream& rng) const;
+
+    double getPeriod() const;
+    int getBins() const;
+};
+
+// Read whitespace-separated rates ('#' starts a comment); false on error
+bool loadRateProfile(const std::string& path, std::vector<double>& rates);
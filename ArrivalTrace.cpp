@@ -0,0 +1,174 @@
+#include "ArrivalTrace.hpp"
+#include <cstring>
+
+namespace {
+
+const char TRACE_MAGIC[8] = { 'M', 'S', 'S', 'A', 'R', 'R', '1', '\0' };
+const std::uint64_t TRACE_HEADER_SIZE = sizeof(TRACE_MAGIC) + 2 * sizeof(std::uint64_t);
+
+// Bytes of the priority column with its padding
+std::uint64_t priorityBytes(std::uint64_t rows) {
+    return (rows + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+// Size of the file of a trace with `rows` rows
+std::uint64_t traceSize(std::uint64_t rows) {
+    return TRACE_HEADER_SIZE + 2 * rows * sizeof(double) + priorityBytes(rows);
+}
+
+// Buffer of each column stream of ArrivalTraceWriter
+const std::size_t COLUMN_BUFFER_BYTES = 1 << 20;
+
+// 64-bit seek: a trace of a few hundred million rows is past 2 GB
+bool seekTo(std::FILE* file, std::uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// ArrivalTrace class
+//------------------------------------------------------------------------------
+ArrivalTrace::ArrivalTrace()
+    : rows_(0),
+    time_(nullptr),
+    demand_(nullptr),
+    priority_(nullptr)
+{
+}
+
+// Map the file and check its header and size
+bool ArrivalTrace::open(const std::string& path, std::string& error) {
+    rows_ = 0;
+    time_ = nullptr;
+    if (!file_.open(path)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    const char* data = static_cast<const char*>(file_.data());
+    const std::size_t size = file_.size();
+    if (size < TRACE_HEADER_SIZE || std::memcmp(data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        error = path + ": not an arrival trace";
+        return false;
+    }
+    std::uint64_t rows = 0;
+    std::memcpy(&rows, data + sizeof(TRACE_MAGIC), sizeof(rows));
+    if (rows > (size - TRACE_HEADER_SIZE) / (2 * sizeof(double)) || traceSize(rows) != size) {
+        error = path + ": truncated arrival trace";
+        return false;
+    }
+    rows_ = rows;
+    time_ = reinterpret_cast<const double*>(data + TRACE_HEADER_SIZE);
+    demand_ = time_ + rows;
+    priority_ = reinterpret_cast<const std::uint8_t*>(demand_ + rows);
+    file_.adviseSequential();
+    return true;
+}
+
+bool ArrivalTrace::isOpen() const {
+    return time_ != nullptr;
+}
+
+std::uint64_t ArrivalTrace::getRowCount() const {
+    return rows_;
+}
+
+const double* ArrivalTrace::getTimes() const {
+    return time_;
+}
+
+const double* ArrivalTrace::getDemands() const {
+    return demand_;
+}
+
+const std::uint8_t* ArrivalTrace::getPriorities() const {
+    return priority_;
+}
+
+//------------------------------------------------------------------------------
+// ArrivalTraceWriter class
+//------------------------------------------------------------------------------
+ArrivalTraceWriter::ArrivalTraceWriter()
+    : columns_{ nullptr, nullptr, nullptr },
+    rows_(0),
+    written_(0),
+    failed_(false)
+{
+}
+
+ArrivalTraceWriter::~ArrivalTraceWriter() {
+    close();
+}
+
+// Create the file for exactly `rows` rows
+bool ArrivalTraceWriter::open(const std::string& path, std::uint64_t rows) {
+    close();
+    rows_ = rows;
+    written_ = 0;
+    failed_ = false;
+
+    std::FILE* header = std::fopen(path.c_str(), "wb");
+    if (!header) {
+        return false;
+    }
+    std::uint64_t layout[2] = { rows, 0 };
+    bool ok = std::fwrite(TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, header) == 1
+        && std::fwrite(layout, sizeof(layout), 1, header) == 1;
+    ok = (std::fclose(header) == 0) && ok;
+
+    // One stream per column, each seeked to where its column starts
+    const std::uint64_t offsets[3] = {
+        TRACE_HEADER_SIZE,
+        TRACE_HEADER_SIZE + rows * sizeof(double),
+        TRACE_HEADER_SIZE + 2 * rows * sizeof(double)
+    };
+    for (int c = 0; ok && c < 3; ++c) {
+        columns_[c] = std::fopen(path.c_str(), "r+b");
+        ok = columns_[c] && std::setvbuf(columns_[c], nullptr, _IOFBF, COLUMN_BUFFER_BYTES) == 0
+            && seekTo(columns_[c], offsets[c]);
+    }
+    if (!ok) {
+        failed_ = true;
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Append one row
+void ArrivalTraceWriter::append(double timeHours, int priority, double demandHours) {
+    if (written_ == rows_) {
+        failed_ = true;
+        return;
+    }
+    std::uint8_t level = static_cast<std::uint8_t>(priority);
+    failed_ = failed_ || std::fwrite(&timeHours, sizeof(timeHours), 1, columns_[0]) != 1
+        || std::fwrite(&demandHours, sizeof(demandHours), 1, columns_[1]) != 1
+        || std::fwrite(&level, sizeof(level), 1, columns_[2]) != 1;
+    ++written_;
+}
+
+// Pad and close
+bool ArrivalTraceWriter::close() {
+    if (!columns_[0] && !columns_[1] && !columns_[2]) {
+        return !failed_;
+    }
+    bool ok = !failed_ && written_ == rows_;
+    if (ok && columns_[2]) {
+        static const std::uint8_t zeros[8] = {};
+        std::size_t padding = static_cast<std::size_t>(priorityBytes(rows_) - rows_);
+        ok = std::fwrite(zeros, 1, padding, columns_[2]) == padding;
+    }
+    for (std::FILE*& column : columns_) {
+        if (column) {
+            ok = (std::fclose(column) == 0) && ok;
+            column = nullptr;
+        }
+    }
+    failed_ = !ok;
+    return ok;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "Snapshot.hpp"
+
+//------------------------------------------------------------------------------
+// Arrival traces: recorded (time, priority, demand) rows, replayed in place
+//------------------------------------------------------------------------------
+
+// A trace holds one row per arrival in three flat columns:
+//
+//   header:  "MSSARR1\0", uint64 rows, uint64 0
+//   columns: f64 time[rows]     hours since the start, non-decreasing
+//            f64 demand[rows]   service hours; 0: drawn by the device
+//            u8 priority[rows]  Priority, zero-padded to a multiple of 8 bytes
+//
+// The row count fixes every column's offset, so opening a trace is a
+// mapping and a size check whatever its length, and the columns are
+// aligned for their type inside the mapping. Values are in host byte order.
+class ArrivalTrace {
+private:
+    MappedFile file_;
+    std::uint64_t rows_;
+    const double* time_;
+    const double* demand_;
+    const std::uint8_t* priority_;
+
+public:
+    ArrivalTrace();
+
+    // Map the file and check its header and size; false with a message on a
+    // bad file. Nothing is read beyond the header until rows are asked for.
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const;
+
+    std::uint64_t getRowCount() const;
+    double getTime(std::uint64_t row) const { return time_[row]; }
+    double getDemand(std::uint64_t row) const { return demand_[row]; }
+    int getPriority(std::uint64_t row) const { return priority_[row]; }
+
+    // The columns inside the mapping
+    const double* getTimes() const;
+    const double* getDemands() const;
+    const std::uint8_t* getPriorities() const;
+};
+
+// Writes a trace of a row count known up front in a single pass: each
+// column has its own stream positioned at its offset, so rows go straight
+// to the file and a trace of any size needs no memory of its own.
+class ArrivalTraceWriter {
+private:
+    std::FILE* columns_[3]; // time, demand, priority
+    std::uint64_t rows_;
+    std::uint64_t written_;
+    bool failed_;
+
+public:
+    ArrivalTraceWriter();
+    ~ArrivalTraceWriter();
+    ArrivalTraceWriter(const ArrivalTraceWriter&) = delete;
+    ArrivalTraceWriter& operator=(const ArrivalTraceWriter&) = delete;
+
+    // Create the file for exactly `rows` rows; false if it cannot be created
+    bool open(const std::string& path, std::uint64_t rows);
+    // Append one row (hours; demand 0 lets the device draw it)
+    void append(double timeHours, int priority, double demandHours);
+    // Pad and close; false if a write failed or fewer rows were appended
+    bool close();
+};
@@ -0,0 +1,68 @@
+#include "BufferPolicy.hpp"
+
+bool parseBufferPolicyKind(const std::string& text, BufferPolicyKind& kind) {
+    if (text == "priority") {
+        kind = BufferPolicyKind::PRIORITY;
+    }
+    else if (text == "fifo") {
+        kind = BufferPolicyKind::FIFO;
+    }
+    else if (text == "edf") {
+        kind = BufferPolicyKind::DEADLINE;
+    }
+    else if (text == "wfq") {
+        kind = BufferPolicyKind::WEIGHTED_FAIR;
+    }
+    else if (text == "quota") {
+        kind = BufferPolicyKind::QUOTA;
+    }
+    else if (text == "early-drop") {
+        kind = BufferPolicyKind::EARLY_DROP;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* bufferPolicyKindName(BufferPolicyKind kind) {
+    switch (kind) {
+    case BufferPolicyKind::FIFO: return "fifo";
+    case BufferPolicyKind::DEADLINE: return "edf";
+    case BufferPolicyKind::WEIGHTED_FAIR: return "wfq";
+    case BufferPolicyKind::QUOTA: return "quota";
+    case BufferPolicyKind::EARLY_DROP: return "early-drop";
+    default: return "priority";
+    }
+}
+
+// Check that the parameters are in range
+bool validateBufferPolicySpec(const BufferPolicySpec& spec, std::string& error) {
+    for (int p = 0; p < POLICY_PRIORITIES; ++p) {
+        if (!(spec.deadlineHours[p] >= 0.0)) {
+            error = "deadlines must not be negative";
+            return false;
+        }
+        if (!(spec.weights[p] > 0.0)) {
+            error = "weights must be positive";
+            return false;
+        }
+        if (!(spec.quotaShare[p] > 0.0 && spec.quotaShare[p] <= 1.0)) {
+            error = "quota shares must be in (0, 1]";
+            return false;
+        }
+        if (!(spec.dropProbability[p] >= 0.0 && spec.dropProbability[p] <= 1.0)) {
+            error = "drop probabilities must be in [0, 1]";
+            return false;
+        }
+    }
+    if (!(spec.dropStart >= 0.0 && spec.dropStart < spec.dropFull && spec.dropFull <= 1.0)) {
+        error = "expected 0 <= drop_start < drop_full <= 1";
+        return false;
+    }
+    if (!(spec.dropAveraging > 0.0 && spec.dropAveraging <= 1.0)) {
+        error = "drop_averaging must be in (0, 1]";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+
+//------------------------------------------------------------------------------
+// Buffer policies: admission, eviction and service order of the buffer
+//------------------------------------------------------------------------------
+//
+// The policies themselves are template parameters of BasicBuffer (see
+// Simulation.hpp), so each combination compiles to its own event loop with
+// no per-event dispatch. This header holds what a config names and sets.
+
+// Priorities the policy parameters are given for (checked against PRIORITY_COUNT)
+static const int POLICY_PRIORITIES = 3;
+
+// The shipped combinations; every one keeps one FIFO ring per priority
+enum class BufferPolicyKind {
+    PRIORITY,       // admit all, evict the lowest priority, strict priority order (default)
+    FIFO,           // admit all, no eviction, arrival order (plain tail drop)
+    DEADLINE,       // earliest deadline first: arrival time + the priority's deadline
+    WEIGHTED_FAIR,  // the priorities share the devices by weight (stride scheduling)
+    QUOTA,          // a priority may hold at most its share of the places
+    EARLY_DROP      // drop arrivals at random as the average occupancy grows
+};
+
+// Parse "priority" / "fifo" / "edf" / "wfq" / "quota" / "early-drop";
+// returns false on unknown text
+bool parseBufferPolicyKind(const std::string& text, BufferPolicyKind& kind);
+const char* bufferPolicyKindName(BufferPolicyKind kind);
+
+// Parameters of the policies, by priority; each kind reads only its own
+struct BufferPolicySpec {
+    BufferPolicyKind kind = BufferPolicyKind::PRIORITY;
+    double deadlineHours[POLICY_PRIORITIES] = { 0.5, 2.0, 8.0 }; // DEADLINE
+    double weights[POLICY_PRIORITIES] = { 4.0, 2.0, 1.0 };       // WEIGHTED_FAIR
+    double quotaShare[POLICY_PRIORITIES] = { 1.0, 1.0, 1.0 };    // QUOTA: share of the capacity
+    // EARLY_DROP: the drop probability grows linearly from 0 at dropStart
+    // to dropProbability at dropFull of the capacity, averaged over the
+    // arrivals with weight dropAveraging (RED, Floyd and Jacobson, 1993)
+    double dropStart = 0.5;
+    double dropFull = 1.0;
+    double dropProbability[POLICY_PRIORITIES] = { 0.0, 0.05, 0.2 };
+    double dropAveraging = 0.2;
+};
+
+// Check that the parameters are in range; false with a message otherwise
+bool validateBufferPolicySpec(const BufferPolicySpec& spec, std::string& error);
@@ -0,0 +1,206 @@
+// C ABI of mss.h over the embedding API of Library.hpp
+
+#include "mss.h"
+#include "Config.hpp"
+#include "Library.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+struct mss_config {
+    SimulationConfig config;
+};
+
+namespace {
+
+// Copy the printStatistics figures into the C layout
+mss_results toC(const SimulationResults& results) {
+    mss_results out;
+    std::memset(&out, 0, sizeof(out));
+    out.precision_reached = results.precisionReached ? 1 : 0;
+    out.generated = results.generatedRequests;
+    out.served = results.servedRequests;
+    out.rejected = results.rejectedRequests;
+    out.rejection_rate = results.rejectionRate();
+    out.average_wait_hours = results.averageWaitTime;
+    out.simulation_hours = results.simulationTime;
+    out.mean_utilization = results.meanUtilization();
+    out.peak_utilization = results.peakUtilization;
+    out.peak_rejection_rate = results.peakRejectionRate;
+    out.steady_wait_hours = results.steadyWait.mean;
+    out.steady_wait_half_width = results.steadyWait.halfWidth;
+    for (int p = 0; p < MSS_PRIORITIES; ++p) {
+        const LatencyStats& latency = results.latency[p];
+        out.rejected_by_priority[p] = results.rejectedByPriority[p];
+        out.wait_p50_hours[p] = latency.wait.percentile(50.0);
+        out.wait_p95_hours[p] = latency.wait.percentile(95.0);
+        out.wait_p99_hours[p] = latency.wait.percentile(99.0);
+        out.sojourn_mean_hours[p] = latency.sojourn.getStats().mean();
+        out.sojourn_p95_hours[p] = latency.sojourn.percentile(95.0);
+    }
+    return out;
+}
+
+// Fill no more of the caller's struct than it says it has
+void copyResults(const SimulationResults& results, mss_results* target) {
+    mss_results out = toC(results);
+    std::uint32_t size = target->struct_size;
+    out.struct_size = size;
+    std::memcpy(target, &out, std::min<std::size_t>(size, sizeof(out)));
+}
+
+// Message of the calling thread's last failed run, for mss_last_error
+thread_local std::string lastError;
+
+int fail(const std::string& message) {
+    lastError = message;
+    return -1;
+}
+
+static_assert(MSS_PRIORITIES == PRIORITY_COUNT, "the C ABI reports every priority");
+
+} // namespace
+
+extern "C" {
+
+MSS_API std::uint32_t mss_abi_version(void) {
+    return MSS_ABI_VERSION;
+}
+
+MSS_API mss_config* mss_config_create(void) {
+    mss_config* config = new (std::nothrow) mss_config;
+    if (config) {
+        config->config.traceLevel = TraceLevel::OFF;
+    }
+    return config;
+}
+
+MSS_API mss_config* mss_config_clone(const mss_config* config) {
+    return config ? new (std::nothrow) mss_config(*config) : nullptr;
+}
+
+MSS_API void mss_config_destroy(mss_config* config) {
+    delete config;
+}
+
+MSS_API int mss_config_apply(mss_config* config, const char* toml, char* error, std::size_t error_size) {
+    if (!config || !toml) {
+        return -1;
+    }
+    // Parse into a copy: a failed apply leaves the config unchanged
+    SimulationConfig parsed = config->config;
+    std::string message;
+    bool ok = false;
+    try {
+        ok = parseConfig(toml, parsed, message);
+    }
+    catch (...) {
+        message = "out of memory";
+    }
+    if (!ok) {
+        if (error && error_size > 0) {
+            std::size_t length = std::min(message.size(), error_size - 1);
+            std::memcpy(error, message.data(), length);
+            error[length] = '\0';
+        }
+        return -1;
+    }
+    config->config = parsed;
+    return 0;
+}
+
+MSS_API int mss_config_set_int(mss_config* config, const char* key, std::int64_t value) {
+    if (!config || !key) {
+        return -1;
+    }
+    SimulationConfig& c = config->config;
+    std::string name = key;
+    if (name == "seed") {
+        c.seed = static_cast<std::uint64_t>(value);
+        return 0;
+    }
+    if (value < 0 || value > 1000000000) {
+        return -1;
+    }
+    int number = static_cast<int>(value);
+    if (name == "corporate") {
+        c.numCorporate = number;
+    }
+    else if (name == "premium") {
+        c.numPremium = number;
+    }
+    else if (name == "free") {
+        c.numFree = number;
+    }
+    else if (name == "devices" && number > 0) {
+        c.numDevices = number;
+    }
+    else if (name == "buffer" && number > 0) {
+        c.bufferCapacity = number;
+    }
+    else if (name == "max_requests" && number > 0) {
+        c.maxRequests = number;
+    }
+    else if ((name == "crn" || name == "antithetic") && number <= 1) {
+        (name == "crn" ? c.commonRandomNumbers : c.antithetic) = (number == 1);
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
+
+MSS_API int mss_run(const mss_config* config, mss_results* results) {
+    if (!config || !results) {
+        return fail("NULL argument");
+    }
+    // No C++ exception may cross the ABI
+    try {
+        SimulationResults out;
+        std::string error;
+        if (!runSimulation(config->config, out, error)) {
+            return fail(error);
+        }
+        copyResults(out, results);
+    }
+    catch (...) {
+        return fail("out of memory");
+    }
+    return 0;
+}
+
+MSS_API int mss_run_batch(const mss_config* const* configs, std::size_t count, int threads, mss_results* results) {
+    if ((!configs || !results) && count > 0) {
+        return fail("NULL argument");
+    }
+    try {
+        std::vector<SimulationConfig> batch;
+        batch.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!configs[i]) {
+                return fail("NULL argument");
+            }
+            batch.push_back(configs[i]->config);
+        }
+        std::vector<SimulationResults> out;
+        std::string error;
+        if (!runSimulations(batch, threads, out, error)) {
+            return fail(error);
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            copyResults(out[i], &results[i]);
+        }
+    }
+    catch (...) {
+        return fail("out of memory");
+    }
+    return 0;
+}
+
+MSS_API const char* mss_last_error(void) {
+    return lastError.c_str();
+}
+
+} // extern "C"
@@ -0,0 +1,676 @@
+#include "Config.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// A parsed right-hand side
+struct ConfigValue {
+    enum class Kind { NUMBER, STRING, ARRAY };
+    Kind kind = Kind::NUMBER;
+    double number = 0.0;
+    std::string text;
+    std::vector<double> numbers;
+};
+
+// Strip a '#' comment that is not inside a string
+std::string stripComment(const std::string& line) {
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == '"') {
+            quoted = !quoted;
+        }
+        else if (line[i] == '#' && !quoted) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+std::string trim(const std::string& text) {
+    std::size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    std::size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size();
+}
+
+// Number, "string" or [number, ...]
+bool parseValue(const std::string& text, ConfigValue& value, std::string& error) {
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+        value.kind = ConfigValue::Kind::STRING;
+        value.text = text.substr(1, text.size() - 2);
+        return true;
+    }
+    if (!text.empty() && text.front() == '[') {
+        if (text.back() != ']') {
+            error = "unterminated array";
+            return false;
+        }
+        value.kind = ConfigValue::Kind::ARRAY;
+        std::stringstream items(text.substr(1, text.size() - 2));
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            item = trim(item);
+            if (item.empty()) {
+                continue; // trailing comma
+            }
+            double number;
+            if (!parseNumber(item, number)) {
+                error = "array items must be numbers";
+                return false;
+            }
+            value.numbers.push_back(number);
+        }
+        return true;
+    }
+    value.kind = ConfigValue::Kind::NUMBER;
+    if (!parseNumber(text, value.number)) {
+        error = "expected a number, a \"string\" or an [array]";
+        return false;
+    }
+    return true;
+}
+
+// Applies key/value pairs of the current section to a SimulationConfig
+class ConfigBuilder {
+private:
+    SimulationConfig& config_;
+    std::string section_;
+    bool devicesListed_;
+
+    bool wantNumber(const ConfigValue& value, std::string& error) const {
+        if (value.kind != ConfigValue::Kind::NUMBER) {
+            error = "expected a number";
+            return false;
+        }
+        return true;
+    }
+
+    bool wantCount(const ConfigValue& value, int minimum, int& out, std::string& error) const {
+        if (!wantNumber(value, error)) {
+            return false;
+        }
+        // Range-check before the cast: converting an out-of-range double is undefined
+        if (!(value.number >= minimum && value.number <= std::numeric_limits<int>::max())
+            || value.number != std::floor(value.number)) {
+            error = "expected an integer >= " + std::to_string(minimum);
+            return false;
+        }
+        out = static_cast<int>(value.number);
+        return true;
+    }
+
+    bool wantPositive(const ConfigValue& value, double& out, std::string& error) const {
+        if (!wantNumber(value, error)) {
+            return false;
+        }
+        if (!(value.number > 0.0)) {
+            error = "expected a positive number";
+            return false;
+        }
+        out = value.number;
+        return true;
+    }
+
+    bool wantString(const ConfigValue& value, std::string& error) const {
+        if (value.kind != ConfigValue::Kind::STRING) {
+            error = "expected a \"string\"";
+            return false;
+        }
+        return true;
+    }
+
+    bool applyTop(const std::string& key, const ConfigValue& value, std::string& error) {
+        if (key == "seed") {
+            if (!wantNumber(value, error) || value.number < 0) {
+                error = "expected a non-negative integer";
+                return false;
+            }
+            config_.seed = static_cast<std::uint64_t>(value.number);
+            config_.seedGiven = true;
+            return true;
+        }
+        if (key == "trace" || key == "queue" || key == "dispatch") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            bool ok = (key == "trace") ? parseTraceLevel(value.text, config_.traceLevel)
+                : (key == "queue") ? parseEventQueueKind(value.text, config_.queueKind)
+                : parseDispatchPolicy(value.text, config_.dispatchPolicy);
+            if (!ok) {
+                error = "unknown " + key + " \"" + value.text + "\"";
+            }
+            return ok;
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    bool applySources(const std::string& key, const ConfigValue& value, std::string& error) {
+        if (key == "replay") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            // Checked here so that a bad trace fails the config, not the run
+            ArrivalTrace trace;
+            if (!trace.open(value.text, error)) {
+                return false;
+            }
+            config_.replayFile = value.text;
+            return true;
+        }
+        int* target = (key == "corporate") ? &config_.numCorporate
+            : (key == "premium") ? &config_.numPremium
+            : (key == "free") ? &config_.numFree
+            : nullptr;
+        if (!target) {
+            error = "unknown key \"" + key + "\"";
+            return false;
+        }
+        return wantCount(value, 0, *target, error);
+    }
+
+    bool applyArrival(ArrivalSpec& spec, const std::string& key, const ConfigValue& value, std::string& error) {
+        if (key == "mean" || key == "amplitude") {
+            if (!wantNumber(value, error)) {
+                return false;
+            }
+            (key == "mean" ? spec.sinusoid.mean : spec.sinusoid.amplitude) = value.number;
+            spec.rates.clear();
+            return true;
+        }
+        if (key == "period_hours") {
+            return wantPositive(value, spec.sinusoid.periodHours, error);
+        }
+        if (key == "rates") {
+            if (value.kind != ConfigValue::Kind::ARRAY || value.numbers.empty()) {
+                error = "expected a non-empty [array] of rates";
+                return false;
+            }
+            for (double rate : value.numbers) {
+                if (rate < 0.0) {
+                    error = "rates must not be negative";
+                    return false;
+                }
+            }
+            spec.rates = value.numbers;
+            return true;
+        }
+        if (key == "file") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            if (!loadRateProfile(value.text, spec.rates)) {
+                error = "cannot read rates from \"" + value.text + "\"";
+                return false;
+            }
+            return true;
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    bool applyDevice(const std::string& key, const ConfigValue& value, std::string& error) {
+        DeviceClass& device = config_.deviceClasses.back();
+        ServiceSpec& service = device.service;
+        if (key == "count") {
+            if (!wantCount(value, 1, device.count, error)) {
+                return false;
+            }
+            syncDeviceCount();
+            return true;
+        }
+        if (key == "service") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            if (!parseServiceKind(value.text, service.kind)) {
+                error = "unknown service model \"" + value.text + "\"";
+                return false;
+            }
+            return true;
+        }
+        if (key == "service_minutes") {
+            double minutes;
+            if (!wantPositive(value, minutes, error)) {
+                return false;
+            }
+            service.meanHours = minutes / 60.0;
+            return true;
+        }
+        if (key == "service_rate") {
+            double rate;
+            if (!wantPositive(value, rate, error)) {
+                return false;
+            }
+            service.meanHours = 1.0 / rate;
+            return true;
+        }
+        if (key == "erlang_k") {
+            return wantCount(value, 1, service.erlangK, error);
+        }
+        if (key == "batch_size") {
+            return wantCount(value, 1, service.batchSize, error);
+        }
+        if (key == "batch_exponent") {
+            if (!wantNumber(value, error)) {
+                return false;
+            }
+            service.batchExponent = value.number;
+            service.batchScale.clear();
+            return true;
+        }
+        if (key == "batch_scale") {
+            if (value.kind != ConfigValue::Kind::ARRAY || value.numbers.empty()) {
+                error = "expected a non-empty [array] of factors";
+                return false;
+            }
+            service.batchScale = value.numbers;
+            return true;
+        }
+        if (key == "batch_wait_minutes") {
+            if (!wantNumber(value, error) || value.number < 0.0) {
+                error = "expected a non-negative number";
+                return false;
+            }
+            service.batchWaitHours = value.number / 60.0;
+            return true;
+        }
+        if (key == "cv") {
+            return wantPositive(value, service.lognormalCv, error);
+        }
+        if (key == "histogram_minutes" || key == "histogram_weights") {
+            if (value.kind != ConfigValue::Kind::ARRAY) {
+                error = "expected an [array]";
+                return false;
+            }
+            if (key == "histogram_weights") {
+                service.binWeights = value.numbers;
+                return true;
+            }
+            service.binEdges.clear();
+            for (double minutes : value.numbers) {
+                service.binEdges.push_back(minutes / 60.0);
+            }
+            return true;
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    // One value per priority, corporate first
+    bool wantPerPriority(const ConfigValue& value, double (&out)[POLICY_PRIORITIES], double scale, std::string& error) const {
+        if (value.kind != ConfigValue::Kind::ARRAY || value.numbers.size() != POLICY_PRIORITIES) {
+            error = "expected an [array] of " + std::to_string(POLICY_PRIORITIES) + " numbers, one per priority";
+            return false;
+        }
+        for (int p = 0; p < POLICY_PRIORITIES; ++p) {
+            out[p] = value.numbers[p] * scale;
+        }
+        return true;
+    }
+
+    bool applyBuffer(const std::string& key, const ConfigValue& value, std::string& error) {
+        BufferPolicySpec& policy = config_.bufferPolicy;
+        if (key == "capacity") {
+            return wantCount(value, 1, config_.bufferCapacity, error);
+        }
+        if (key == "policy") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            if (!parseBufferPolicyKind(value.text, policy.kind)) {
+                error = "unknown policy \"" + value.text + "\"";
+                return false;
+            }
+            return true;
+        }
+        if (key == "deadline_minutes") {
+            return wantPerPriority(value, policy.deadlineHours, 1.0 / 60.0, error);
+        }
+        if (key == "weights") {
+            return wantPerPriority(value, policy.weights, 1.0, error);
+        }
+        if (key == "quota") {
+            return wantPerPriority(value, policy.quotaShare, 1.0, error);
+        }
+        if (key == "drop_probability") {
+            return wantPerPriority(value, policy.dropProbability, 1.0, error);
+        }
+        double* target = (key == "drop_start") ? &policy.dropStart
+            : (key == "drop_full") ? &policy.dropFull
+            : (key == "drop_averaging") ? &policy.dropAveraging
+            : nullptr;
+        if (!target) {
+            error = "unknown key \"" + key + "\"";
+            return false;
+        }
+        if (!wantNumber(value, error)) {
+            return false;
+        }
+        *target = value.number;
+        return true;
+    }
+
+    bool applyPatience(PatienceSpec& spec, const std::string& key, const ConfigValue& value, std::string& error) {
+        ServiceSpec& time = spec.time;
+        if (key == "distribution") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            if (!parseServiceKind(value.text, time.kind)) {
+                error = "unknown distribution \"" + value.text + "\"";
+                return false;
+            }
+            return true;
+        }
+        if (key == "mean_minutes") {
+            if (!wantNumber(value, error) || value.number < 0.0) {
+                error = "expected a non-negative number (0: no patience limit)";
+                return false;
+            }
+            spec.enabled = value.number > 0.0;
+            time.meanHours = spec.enabled ? value.number / 60.0 : time.meanHours;
+            return true;
+        }
+        if (key == "cv") {
+            return wantPositive(value, time.lognormalCv, error);
+        }
+        if (key == "erlang_k") {
+            return wantCount(value, 1, time.erlangK, error);
+        }
+        if (key == "histogram_minutes" || key == "histogram_weights") {
+            if (value.kind != ConfigValue::Kind::ARRAY) {
+                error = "expected an [array]";
+                return false;
+            }
+            if (key == "histogram_weights") {
+                time.binWeights = value.numbers;
+                return true;
+            }
+            time.binEdges.clear();
+            for (double minutes : value.numbers) {
+                time.binEdges.push_back(minutes / 60.0);
+            }
+            spec.enabled = true;
+            return true;
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    bool applyRetry(const std::string& key, const ConfigValue& value, std::string& error) {
+        RetrySpec& retry = config_.retry;
+        if (key == "max_attempts") {
+            return wantCount(value, 1, retry.maxAttempts, error);
+        }
+        if (key == "backoff_minutes") {
+            if (!wantNumber(value, error) || value.number < 0.0) {
+                error = "expected a non-negative number";
+                return false;
+            }
+            retry.backoffHours = value.number / 60.0;
+            return true;
+        }
+        double* target = (key == "probability") ? &retry.probability
+            : (key == "backoff_factor") ? &retry.backoffFactor
+            : nullptr;
+        if (!target) {
+            error = "unknown key \"" + key + "\"";
+            return false;
+        }
+        if (!wantNumber(value, error)) {
+            return false;
+        }
+        *target = value.number;
+        return true;
+    }
+
+    bool applyStop(const std::string& key, const ConfigValue& value, std::string& error) {
+        if (key == "max_requests") {
+            return wantCount(value, 1, config_.maxRequests, error);
+        }
+        if (key == "max_hours") {
+            return wantPositive(value, config_.maxTimeHours, error);
+        }
+        if (key == "precision") {
+            return wantPositive(value, config_.targetPrecision, error);
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    bool applyOutput(const std::string& key, const ConfigValue& value, std::string& error) {
+        if (key == "window_hours") {
+            return wantPositive(value, config_.windowHours, error);
+        }
+        if (key == "window_file") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            config_.windowFile = value.text;
+            return true;
+        }
+        if (key == "event_log") {
+            if (!wantString(value, error)) {
+                return false;
+            }
+            config_.eventLogFile = value.text;
+            return true;
+        }
+        error = "unknown key \"" + key + "\"";
+        return false;
+    }
+
+    // numDevices follows the listed device classes
+    void syncDeviceCount() {
+        int total = 0;
+        for (const DeviceClass& device : config_.deviceClasses) {
+            total += device.count;
+        }
+        config_.numDevices = total;
+    }
+
+public:
+    explicit ConfigBuilder(SimulationConfig& config)
+        : config_(config),
+        devicesListed_(false)
+    {
+    }
+
+    // Enter [name] or, with array = true, a new [[name]] table
+    bool beginSection(const std::string& name, bool array, std::string& error) {
+        if (array) {
+            if (name != "devices") {
+                error = "unknown table array [[" + name + "]]";
+                return false;
+            }
+            if (!devicesListed_) {
+                config_.deviceClasses.clear(); // the file replaces any earlier classes
+                devicesListed_ = true;
+            }
+            config_.deviceClasses.push_back(DeviceClass());
+            syncDeviceCount();
+        }
+        else if (name != "sources" && name != "arrivals" && name != "arrivals.corporate"
+            && name != "arrivals.premium" && name != "arrivals.free"
+            && name != "buffer" && name != "patience" && name != "patience.corporate"
+            && name != "patience.premium" && name != "patience.free" && name != "retry"
+            && name != "stop" && name != "output") {
+            error = "unknown section [" + name + "]";
+            return false;
+        }
+        section_ = name;
+        return true;
+    }
+
+    bool apply(const std::string& key, const ConfigValue& value, std::string& error) {
+        if (section_.empty()) {
+            return applyTop(key, value, error);
+        }
+        if (section_ == "sources") {
+            return applySources(key, value, error);
+        }
+        if (section_ == "arrivals") {
+            for (ArrivalSpec& spec : config_.arrivals) {
+                if (!applyArrival(spec, key, value, error)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (section_.compare(0, 9, "arrivals.") == 0) {
+            const std::string name = section_.substr(9);
+            Priority priority = (name == "corporate") ? Priority::CORPORATE
+                : (name == "premium") ? Priority::PREMIUM
+                : Priority::FREE;
+            return applyArrival(config_.arrivals[static_cast<int>(priority)], key, value, error);
+        }
+        if (section_ == "devices") {
+            return applyDevice(key, value, error);
+        }
+        if (section_ == "buffer") {
+            return applyBuffer(key, value, error);
+        }
+        if (section_ == "patience") {
+            for (PatienceSpec& spec : config_.patience) {
+                if (!applyPatience(spec, key, value, error)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (section_.compare(0, 9, "patience.") == 0) {
+            const std::string name = section_.substr(9);
+            Priority priority = (name == "corporate") ? Priority::CORPORATE
+                : (name == "premium") ? Priority::PREMIUM
+                : Priority::FREE;
+            return applyPatience(config_.patience[static_cast<int>(priority)], key, value, error);
+        }
+        if (section_ == "retry") {
+            return applyRetry(key, value, error);
+        }
+        if (section_ == "stop") {
+            return applyStop(key, value, error);
+        }
+        return applyOutput(key, value, error);
+    }
+};
+
+} // namespace
+
+// Apply scenario text to config; on failure error holds "line N: message"
+bool parseConfig(const std::string& text, SimulationConfig& config, std::string& error) {
+    SimulationConfig result = config;
+    ConfigBuilder builder(result);
+    std::istringstream in(text);
+    std::string raw;
+    int lineNumber = 0;
+
+    auto fail = [&error, &lineNumber](const std::string& message) {
+        error = "line " + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+
+    while (std::getline(in, raw)) {
+        lineNumber++;
+        std::string line = trim(stripComment(raw));
+        if (line.empty()) {
+            continue;
+        }
+
+        std::string message;
+        if (line.front() == '[') {
+            bool array = line.compare(0, 2, "[[") == 0;
+            std::size_t open = array ? 2 : 1;
+            std::size_t close = line.find(array ? "]]" : "]");
+            if (close == std::string::npos || trim(line.substr(close + open)) != "") {
+                return fail("malformed section header");
+            }
+            if (!builder.beginSection(trim(line.substr(open, close - open)), array, message)) {
+                return fail(message);
+            }
+            continue;
+        }
+
+        std::size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            return fail("expected key = value");
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string valueText = trim(line.substr(equals + 1));
+
+        // Arrays may continue over several lines
+        if (!valueText.empty() && valueText.front() == '[') {
+            while (valueText.back() != ']' && std::getline(in, raw)) {
+                lineNumber++;
+                valueText += " " + trim(stripComment(raw));
+            }
+        }
+
+        ConfigValue value;
+        if (key.empty()) {
+            return fail("missing key");
+        }
+        if (!parseValue(valueText, value, message) || !builder.apply(key, value, message)) {
+            return fail(key + ": " + message);
+        }
+    }
+
+    for (std::size_t c = 0; c < result.deviceClasses.size(); ++c) {
+        std::string message;
+        if (!validateServiceSpec(result.deviceClasses[c].service, message)) {
+            error = "line " + std::to_string(lineNumber) + ": [[devices]] #" + std::to_string(c + 1) + ": " + message;
+            return false;
+        }
+    }
+    std::string message;
+    if (!validateBufferPolicySpec(result.bufferPolicy, message)) {
+        error = "line " + std::to_string(lineNumber) + ": [buffer]: " + message;
+        return false;
+    }
+    const char* sections[PRIORITY_COUNT] = { "corporate", "premium", "free" };
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (!validatePatienceSpec(result.patience[p], message)) {
+            error = "line " + std::to_string(lineNumber) + ": [patience." + sections[p] + "]: " + message;
+            return false;
+        }
+    }
+    if (!validateRetrySpec(result.retry, message)) {
+        error = "line " + std::to_string(lineNumber) + ": [retry]: " + message;
+        return false;
+    }
+
+    config = result;
+    return true;
+}
+
+// Apply a scenario file to config; on failure error holds "file:line: message"
+bool loadConfigFile(const std::string& path, SimulationConfig& config, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = path + ": cannot open file";
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    if (!parseConfig(text.str(), config, error)) {
+        error = path + ":" + error.substr(5); // "line N: ..." -> "path:N: ..."
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include "Simulation.hpp"
+
+//------------------------------------------------------------------------------
+// Scenario files: a TOML subset parsed once into a SimulationConfig
+//------------------------------------------------------------------------------
+//
+//   seed = 7
+//   trace = "off"                 # also queue = "...", dispatch = "..."
+//
+//   [sources]                     # sources per priority
+//   corporate = 2
+//   premium = 4
+//   free = 6
+//   replay = "arrivals.trace"     # ArrivalTrace replayed instead of the above
+//
+//   [arrivals]                    # every priority; [arrivals.free] etc. for one
+//   mean = 0.45                   # sinusoid per source and hour ...
+//   amplitude = 0.25
+//   period_hours = 24
+//   rates = [0.2, 0.3, 0.5]       # ... or measured rates over the period
+//   file = "hourly.txt"           # ... or rates read with loadRateProfile
+//
+//   [[devices]]                   # one table per device class, in id order
+//   count = 3
+//   service = "lognormal"         # exponential (default), erlang, lognormal,
+//                                 # deterministic or empirical
+//   service_minutes = 40          # mean; or service_rate (per hour)
+//   cv = 0.8                      # lognormal: standard deviation / mean
+//   erlang_k = 3                  # erlang: number of phases
+//   histogram_minutes = [10, 20, 40, 90]  # empirical: bin edges
+//   histogram_weights = [5, 3, 1]         # empirical: relative bin counts
+//   batch_size = 8                # serve up to 8 requests in one service
+//   batch_exponent = 0.5          # a batch of b takes b^0.5 service times ...
+//   batch_scale = [1, 1.2, 1.4]   # ... or these factors, one per size
+//   batch_wait_minutes = 2        # hold a partial batch this long for more
+//
+//   [buffer]
+//   capacity = 8
+//   policy = "edf"                # priority (default), fifo, edf, wfq, quota
+//                                 # or early-drop; arrays are per priority:
+//   deadline_minutes = [30, 120, 480]  # edf: due this long after arrival
+//   weights = [4, 2, 1]           # wfq: shares of the service
+//   quota = [1, 0.75, 0.5]        # quota: most of the capacity a priority holds
+//   drop_probability = [0, 0.05, 0.2]  # early-drop: reached at drop_full,
+//   drop_start = 0.5              # rising from 0 at drop_start (shares of
+//   drop_full = 1.0               # the capacity, against the occupancy
+//   drop_averaging = 0.2          # averaged with this weight per arrival)
+//
+//   [patience]                    # every priority; [patience.free] etc. for one
+//   mean_minutes = 30             # renege after waiting this long on average;
+//                                 # 0 (default): wait until served
+//   distribution = "lognormal"    # as service above, with cv, erlang_k and
+//                                 # histogram_minutes / histogram_weights
+//
+//   [retry]                       # rejected, evicted, reneged requests come back
+//   max_attempts = 3              # arrivals per request; 1 (default): none
+//   probability = 0.8             # share of the lost attempts that retry
+//   backoff_minutes = 5           # mean backoff after the first attempt,
+//   backoff_factor = 2            # times this per further one (full jitter)
+//
+//   [stop]
+//   max_requests = 5000
+//   max_hours = 1000
+//   precision = 0.05
+//
+//   [output]
+//   window_hours = 1
+//   window_file = "windows.bin"
+//   event_log = "events.bin"      # one row per request event (EventLog.hpp)
+//
+// Keys not in the file keep the values already in the config, and later
+// lines override earlier ones. Unknown sections and keys are errors.
+
+// Apply a scenario file to config; on failure error holds "file:line: message"
+bool loadConfigFile(const std::string& path, SimulationConfig& config, std::string& error);
+
+// Apply scenario text to config; on failure error holds "line N: message"
+bool parseConfig(const std::string& text, SimulationConfig& config, std::string& error);
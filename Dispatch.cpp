@@ -0,0 +1,212 @@
+#include "Dispatch.hpp"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include "Snapshot.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Index of the lowest set bit; bits must be non-zero
+int lowestSetBit(std::uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Number of set bits
+int popCount(std::uint64_t bits) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(bits));
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// Bits at positions >= from (from < 64)
+std::uint64_t maskFrom(int from) {
+    return ~std::uint64_t(0) << from;
+}
+
+} // namespace
+
+bool parseDispatchPolicy(const std::string& text, DispatchPolicy& policy) {
+    if (text == "lowest") {
+        policy = DispatchPolicy::LOWEST_ID;
+    }
+    else if (text == "round-robin") {
+        policy = DispatchPolicy::ROUND_ROBIN;
+    }
+    else if (text == "least-utilized") {
+        policy = DispatchPolicy::LEAST_UTILIZED;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// IdleDeviceSet class
+//------------------------------------------------------------------------------
+IdleDeviceSet::IdleDeviceSet(int numDevices, DispatchPolicy policy)
+    : policy_(policy),
+    numDevices_(numDevices),
+    count_(0),
+    words_((numDevices + 63) / 64, 0),
+    summary_((words_.size() + 63) / 64, 0),
+    cursor_(0)
+{
+    for (int i = 0; i < numDevices; ++i) {
+        release(i, 0.0);
+    }
+}
+
+void IdleDeviceSet::set(int index) {
+    std::size_t w = static_cast<std::size_t>(index) >> 6;
+    words_[w] |= std::uint64_t(1) << (index & 63);
+    summary_[w >> 6] |= std::uint64_t(1) << (w & 63);
+}
+
+void IdleDeviceSet::clear(int index) {
+    std::size_t w = static_cast<std::size_t>(index) >> 6;
+    words_[w] &= ~(std::uint64_t(1) << (index & 63));
+    if (words_[w] == 0) {
+        summary_[w >> 6] &= ~(std::uint64_t(1) << (w & 63));
+    }
+}
+
+// First idle device with index >= start, or -1
+int IdleDeviceSet::findFrom(int start) const {
+    if (start >= numDevices_) {
+        return -1;
+    }
+    std::size_t w = static_cast<std::size_t>(start) >> 6;
+    std::uint64_t bits = words_[w] & maskFrom(start & 63);
+    if (bits != 0) {
+        return static_cast<int>(w * 64) + lowestSetBit(bits);
+    }
+
+    // Next non-empty word via the summary level
+    std::size_t next = w + 1;
+    for (std::size_t s = next >> 6; s < summary_.size(); ++s) {
+        std::uint64_t words = summary_[s];
+        if (s == (next >> 6)) {
+            words &= (next & 63) ? maskFrom(static_cast<int>(next & 63)) : ~std::uint64_t(0);
+        }
+        if (words != 0) {
+            std::size_t found = s * 64 + lowestSetBit(words);
+            return static_cast<int>(found * 64) + lowestSetBit(words_[found]);
+        }
+    }
+    return -1;
+}
+
+// Take an idle device according to the policy; -1 if all are busy
+int IdleDeviceSet::acquire() {
+    if (count_ == 0) {
+        return -1;
+    }
+
+    int index = -1;
+    switch (policy_) {
+    case DispatchPolicy::LOWEST_ID:
+        index = findFrom(0);
+        break;
+    case DispatchPolicy::ROUND_ROBIN:
+        index = findFrom(cursor_);
+        if (index < 0) {
+            index = findFrom(0);
+        }
+        cursor_ = index + 1;
+        break;
+    case DispatchPolicy::LEAST_UTILIZED:
+        std::pop_heap(byBusyTime_.begin(), byBusyTime_.end(), std::greater<>());
+        index = byBusyTime_.back().second;
+        byBusyTime_.pop_back();
+        break;
+    }
+
+    assert(index >= 0 && isIdle(index));
+    clear(index);
+    --count_;
+    return index;
+}
+
+// Mark a device idle again (busyTotalTime feeds LEAST_UTILIZED)
+void IdleDeviceSet::release(int index, double busyTotalTime) {
+    assert(!isIdle(index));
+    set(index);
+    ++count_;
+    if (policy_ == DispatchPolicy::LEAST_UTILIZED) {
+        // Ties go to the lower index, like LOWEST_ID
+        byBusyTime_.emplace_back(busyTotalTime, index);
+        std::push_heap(byBusyTime_.begin(), byBusyTime_.end(), std::greater<>());
+    }
+}
+
+bool IdleDeviceSet::isIdle(int index) const {
+    return (words_[static_cast<std::size_t>(index) >> 6] >> (index & 63)) & 1;
+}
+
+bool IdleDeviceSet::empty() const {
+    return count_ == 0;
+}
+
+int IdleDeviceSet::size() const {
+    return count_;
+}
+
+DispatchPolicy IdleDeviceSet::getPolicy() const {
+    return policy_;
+}
+
+// Write the set to a snapshot
+void IdleDeviceSet::save(SnapshotWriter& out) const {
+    out.write(policy_);
+    out.write(numDevices_);
+    out.writeVector(words_);
+    out.write(cursor_);
+    out.write(static_cast<std::uint64_t>(byBusyTime_.size()));
+    for (const auto& entry : byBusyTime_) {
+        out.write(entry.first);
+        out.write(entry.second);
+    }
+}
+
+// Read a set saved with the same size and policy; the summary level and
+// the count follow from the words
+bool IdleDeviceSet::load(SnapshotReader& in) {
+    DispatchPolicy policy = policy_;
+    int numDevices = 0;
+    std::uint64_t heapSize = 0;
+    if (!in.read(policy) || !in.read(numDevices) || policy != policy_ || numDevices != numDevices_
+        || !in.readVector(words_, static_cast<long long>(words_.size())) || !in.read(cursor_)
+        || !in.read(heapSize) || heapSize > static_cast<std::uint64_t>(numDevices_)) {
+        return false;
+    }
+
+    count_ = 0;
+    std::fill(summary_.begin(), summary_.end(), 0);
+    for (std::size_t w = 0; w < words_.size(); ++w) {
+        if (words_[w] != 0) {
+            summary_[w >> 6] |= std::uint64_t(1) << (w & 63);
+        }
+        count_ += popCount(words_[w]);
+    }
+
+    byBusyTime_.resize(static_cast<std::size_t>(heapSize));
+    for (auto& entry : byBusyTime_) {
+        if (!in.read(entry.first) || !in.read(entry.second)
+            || entry.second < 0 || entry.second >= numDevices_ || !isIdle(entry.second)) {
+            return false;
+        }
+    }
+    return cursor_ >= 0 && cursor_ <= numDevices_;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Idle-device tracking and dispatch policies
+//------------------------------------------------------------------------------
+
+// Which idle device receives the next request from the buffer
+enum class DispatchPolicy {
+    LOWEST_ID,     // the idle device with the smallest id
+    ROUND_ROBIN,   // the next idle device after the one chosen last
+    LEAST_UTILIZED // the idle device with the smallest accumulated busy time
+};
+
+// Parse "lowest" / "round-robin" / "least-utilized"; returns false on unknown text
+bool parseDispatchPolicy(const std::string& text, DispatchPolicy& policy);
+
+// Set of idle devices (0-based indices). Backed by a two-level bitset, so
+// finding the first or next idle device costs a few find-first-set
+// instructions instead of a pass over all devices.
+class IdleDeviceSet {
+private:
+    DispatchPolicy policy_;
+    int numDevices_;
+    int count_;
+    std::vector<std::uint64_t> words_;   // bit i: device i is idle
+    std::vector<std::uint64_t> summary_; // bit w: words_[w] is non-zero
+    int cursor_;                         // ROUND_ROBIN: where the next search starts
+    std::vector<std::pair<double, int>> byBusyTime_; // LEAST_UTILIZED: min-heap
+
+    void set(int index);
+    void clear(int index);
+    // First idle device with index >= start, or -1
+    int findFrom(int start) const;
+
+public:
+    // All devices start idle
+    IdleDeviceSet(int numDevices, DispatchPolicy policy);
+
+    // Take an idle device according to the policy; -1 if all are busy
+    int acquire();
+    // Mark a device idle again (busyTotalTime feeds LEAST_UTILIZED)
+    void release(int index, double busyTotalTime);
+
+    bool isIdle(int index) const;
+    bool empty() const;
+    int size() const;
+    DispatchPolicy getPolicy() const;
+
+    // Write the set to a snapshot / read it back into a set of the same
+    // size and policy
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
@@ -0,0 +1,233 @@
+#include "EventLog.hpp"
+#include <cstring>
+
+namespace {
+
+enum class ColumnType : std::uint8_t { F64 = 0, U32 = 1, U8 = 2 };
+
+struct ColumnInfo {
+    const char* name;
+    ColumnType type;
+};
+
+// In block order: widest first, so every column stays aligned
+const ColumnInfo LOG_COLUMNS[] = {
+    { "time_hours", ColumnType::F64 },
+    { "wait_hours", ColumnType::F64 },
+    { "request", ColumnType::U32 },
+    { "device", ColumnType::U32 },
+    { "type", ColumnType::U8 },
+    { "priority", ColumnType::U8 },
+};
+const std::uint32_t LOG_COLUMN_COUNT = sizeof(LOG_COLUMNS) / sizeof(LOG_COLUMNS[0]);
+
+const char LOG_MAGIC[8] = { 'M', 'S', 'S', 'L', 'O', 'G', '1', '\0' };
+const std::size_t LOG_HEADER_SIZE = sizeof(LOG_MAGIC) + 4 * sizeof(std::uint32_t) + LOG_COLUMN_COUNT * 32;
+
+// Bytes of a block with `rows` rows after its 8-byte row header
+std::size_t blockPayload(std::uint32_t rows) {
+    std::size_t bytes = rows * (2 * sizeof(double) + 2 * sizeof(std::uint32_t) + 2 * sizeof(std::uint8_t));
+    return (bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// EventLogWriter class
+//------------------------------------------------------------------------------
+EventLogWriter::EventLogWriter()
+    : out_(nullptr),
+    pending_(false),
+    closing_(false),
+    records_(0)
+{
+}
+
+EventLogWriter::~EventLogWriter() {
+    close();
+}
+
+// Create the file and start the writer thread
+bool EventLogWriter::open(const std::string& path, int numDevices) {
+    close();
+    out_ = std::fopen(path.c_str(), "wb");
+    if (!out_) {
+        return false;
+    }
+    std::fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), out_);
+    std::uint32_t layout[4] = { LOG_COLUMN_COUNT, EVENT_LOG_BLOCK_ROWS, static_cast<std::uint32_t>(numDevices), 0 };
+    std::fwrite(layout, sizeof(layout), 1, out_);
+    for (const ColumnInfo& column : LOG_COLUMNS) {
+        char name[31] = {};
+        std::strncpy(name, column.name, sizeof(name) - 1);
+        std::fwrite(name, 1, sizeof(name), out_);
+        std::fputc(static_cast<int>(column.type), out_);
+    }
+
+    front_ = std::make_unique<EventLogBlock>();
+    back_ = std::make_unique<EventLogBlock>();
+    pending_ = false;
+    closing_ = false;
+    records_ = 0;
+    thread_ = std::thread(&EventLogWriter::writerLoop, this);
+    return true;
+}
+
+// Write the last partial block, stop the thread and close the file
+void EventLogWriter::close() {
+    if (!out_) {
+        return;
+    }
+    if (front_->rows > 0) {
+        handOff();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    std::fclose(out_);
+    out_ = nullptr;
+}
+
+// Hand the front block to the writer thread (waits for the previous one)
+void EventLogWriter::handOff() {
+    records_ += front_->rows;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return !pending_; });
+        std::swap(front_, back_);
+        pending_ = true;
+    }
+    changed_.notify_all();
+    front_->rows = 0;
+}
+
+void EventLogWriter::writerLoop() {
+    static const char padding[8] = {};
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return pending_ || closing_; });
+        if (!pending_) {
+            return; // closing, nothing left to write
+        }
+        lock.unlock();
+
+        // back_ is ours until pending_ is cleared
+        const EventLogBlock& block = *back_;
+        std::uint32_t header[2] = { block.rows, 0 };
+        std::fwrite(header, sizeof(header), 1, out_);
+        std::fwrite(block.time, sizeof(block.time[0]), block.rows, out_);
+        std::fwrite(block.wait, sizeof(block.wait[0]), block.rows, out_);
+        std::fwrite(block.request, sizeof(block.request[0]), block.rows, out_);
+        std::fwrite(block.device, sizeof(block.device[0]), block.rows, out_);
+        std::fwrite(block.type, sizeof(block.type[0]), block.rows, out_);
+        std::fwrite(block.priority, sizeof(block.priority[0]), block.rows, out_);
+        std::size_t written = block.rows * (2 * sizeof(double) + 2 * sizeof(std::uint32_t) + 2);
+        std::fwrite(padding, 1, blockPayload(block.rows) - written, out_);
+
+        lock.lock();
+        pending_ = false;
+        lock.unlock();
+        changed_.notify_all();
+    }
+}
+
+// Rows recorded so far
+std::uint64_t EventLogWriter::getRecordCount() const {
+    return records_ + (front_ ? front_->rows : 0);
+}
+
+//------------------------------------------------------------------------------
+// EventLogReader class
+//------------------------------------------------------------------------------
+EventLogReader::EventLogReader()
+    : records_(0),
+    numDevices_(0)
+{
+}
+
+// Map the file and index its blocks
+bool EventLogReader::open(const std::string& path, std::string& error) {
+    blocks_.clear();
+    records_ = 0;
+    if (!file_.open(path)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    const char* data = static_cast<const char*>(file_.data());
+    const std::size_t size = file_.size();
+
+    if (size < LOG_HEADER_SIZE || std::memcmp(data, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        error = path + ": not an event log";
+        return false;
+    }
+    std::uint32_t layout[4];
+    std::memcpy(layout, data + sizeof(LOG_MAGIC), sizeof(layout));
+    std::uint32_t columns = layout[0];
+    numDevices_ = static_cast<int>(layout[2]);
+    for (std::uint32_t c = 0; c < LOG_COLUMN_COUNT && columns == LOG_COLUMN_COUNT; ++c) {
+        const char* entry = data + sizeof(LOG_MAGIC) + sizeof(layout) + c * 32;
+        if (std::strncmp(entry, LOG_COLUMNS[c].name, 31) != 0
+            || static_cast<std::uint8_t>(entry[31]) != static_cast<std::uint8_t>(LOG_COLUMNS[c].type)) {
+            columns = 0;
+        }
+    }
+    if (columns != LOG_COLUMN_COUNT) {
+        error = path + ": unknown event log columns";
+        return false;
+    }
+
+    std::size_t offset = LOG_HEADER_SIZE;
+    while (offset < size) {
+        std::uint32_t rows = 0;
+        if (size - offset < 8) {
+            break;
+        }
+        std::memcpy(&rows, data + offset, sizeof(rows));
+        std::size_t payload = blockPayload(rows);
+        if (rows == 0 || rows > static_cast<std::uint32_t>(EVENT_LOG_BLOCK_ROWS) || size - offset - 8 < payload) {
+            break;
+        }
+        const char* column = data + offset + 8;
+        EventLogColumns block;
+        block.rows = rows;
+        block.time = reinterpret_cast<const double*>(column);
+        column += rows * sizeof(double);
+        block.wait = reinterpret_cast<const double*>(column);
+        column += rows * sizeof(double);
+        block.request = reinterpret_cast<const std::uint32_t*>(column);
+        column += rows * sizeof(std::uint32_t);
+        block.device = reinterpret_cast<const std::uint32_t*>(column);
+        column += rows * sizeof(std::uint32_t);
+        block.type = reinterpret_cast<const std::uint8_t*>(column);
+        column += rows;
+        block.priority = reinterpret_cast<const std::uint8_t*>(column);
+        blocks_.push_back(block);
+        records_ += rows;
+        offset += 8 + payload;
+    }
+    if (offset != size) {
+        error = path + ": truncated event log";
+        return false;
+    }
+    return true;
+}
+
+int EventLogReader::getBlockCount() const {
+    return static_cast<int>(blocks_.size());
+}
+
+const EventLogColumns& EventLogReader::getBlock(int index) const {
+    return blocks_[index];
+}
+
+std::uint64_t EventLogReader::getRecordCount() const {
+    return records_;
+}
+
+// Devices of the run that wrote the log
+int EventLogReader::getNumDevices() const {
+    return numDevices_;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Snapshot.hpp"
+
+//------------------------------------------------------------------------------
+// Per-request event log: a columnar file written by a background thread
+//------------------------------------------------------------------------------
+
+// Rows per block of the event log
+static const int EVENT_LOG_BLOCK_ROWS = 32768;
+
+// What happened to a request
+enum class LogEventType : std::uint8_t {
+    ARRIVAL,       // generated by its source
+    REJECTED,      // the buffer was full and nothing could be evicted
+    EVICTED,       // pushed out of the buffer by a higher priority
+    SERVICE_START, // loaded onto a device; wait holds the hours buffered
+    SERVICE_END,   // the device finished it
+    RENEGED,       // left the buffer when its patience ran out
+    RETRY          // the rejected, evicted or reneged attempt will come back (not lost)
+};
+
+// Columns of one block, each stored contiguously
+struct EventLogBlock {
+    std::uint32_t rows = 0;
+    double time[EVENT_LOG_BLOCK_ROWS];            // hours
+    double wait[EVENT_LOG_BLOCK_ROWS];            // SERVICE_START: hours, else 0
+    std::uint32_t request[EVENT_LOG_BLOCK_ROWS];  // request id
+    std::uint32_t device[EVENT_LOG_BLOCK_ROWS];   // 1-based device id, 0: none
+    std::uint8_t type[EVENT_LOG_BLOCK_ROWS];      // LogEventType
+    std::uint8_t priority[EVENT_LOG_BLOCK_ROWS];  // Priority
+};
+
+// Records one row per request event into a columnar file:
+//
+//   header: "MSSLOG1\0", uint32 columns, uint32 rows per full block,
+//           uint32 devices, uint32 0, then per column char name[31] and
+//           uint8 type (0 = f64, 1 = u32, 2 = u8)
+//   blocks: uint32 rows, uint32 0, then each column's `rows` values in
+//           header order, zero-padded to a multiple of 8 bytes
+//
+// The columns are ordered by width, so inside a mapped file every column
+// is aligned for its type. Values are in host byte order. The event loop
+// only fills the front block; when it is full, a background thread writes
+// it while the loop fills the other one, so logging costs the loop a few
+// stores per event and never waits on the disk unless the disk falls a
+// whole block behind.
+class EventLogWriter {
+private:
+    std::FILE* out_;
+    std::unique_ptr<EventLogBlock> front_; // being filled by the event loop
+    std::unique_ptr<EventLogBlock> back_;  // being written by thread_
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool pending_;  // back_ holds a block to write
+    bool closing_;
+    std::uint64_t records_;
+
+    // Hand the front block to the writer thread (waits for the previous one)
+    void handOff();
+    void writerLoop();
+
+public:
+    EventLogWriter();
+    ~EventLogWriter();
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    // Create the file and start the writer thread; false if it cannot be created
+    bool open(const std::string& path, int numDevices);
+    // Write the last partial block, stop the thread and close the file
+    void close();
+    bool isOpen() const { return out_ != nullptr; }
+
+    // Append one row; times are in hours, deviceId 0 means none
+    void record(double timeHours, LogEventType type, int requestId, int priority,
+        int deviceId = 0, double waitHours = 0.0) {
+        EventLogBlock& block = *front_;
+        std::uint32_t row = block.rows++;
+        block.time[row] = timeHours;
+        block.wait[row] = waitHours;
+        block.request[row] = static_cast<std::uint32_t>(requestId);
+        block.device[row] = static_cast<std::uint32_t>(deviceId);
+        block.type[row] = static_cast<std::uint8_t>(type);
+        block.priority[row] = static_cast<std::uint8_t>(priority);
+        if (block.rows == static_cast<std::uint32_t>(EVENT_LOG_BLOCK_ROWS)) {
+            handOff();
+        }
+    }
+
+    // Rows recorded so far
+    std::uint64_t getRecordCount() const;
+};
+
+// One block of a mapped log; the pointers address the mapping directly
+struct EventLogColumns {
+    std::uint32_t rows = 0;
+    const double* time = nullptr;
+    const double* wait = nullptr;
+    const std::uint32_t* request = nullptr;
+    const std::uint32_t* device = nullptr;
+    const std::uint8_t* type = nullptr;
+    const std::uint8_t* priority = nullptr;
+};
+
+// Read-only view of an event log through a memory mapping: opening it
+// only walks the block headers, and a pass over one column touches only
+// that column's pages.
+class EventLogReader {
+private:
+    MappedFile file_;
+    std::vector<EventLogColumns> blocks_;
+    std::uint64_t records_;
+    int numDevices_;
+
+public:
+    EventLogReader();
+
+    // Map the file and index its blocks; false with a message on a bad file
+    bool open(const std::string& path, std::string& error);
+
+    int getBlockCount() const;
+    const EventLogColumns& getBlock(int index) const;
+    std::uint64_t getRecordCount() const;
+    // Devices of the run that wrote the log
+    int getNumDevices() const;
+};
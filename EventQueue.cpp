@@ -0,0 +1,405 @@
+#include "EventQueue.hpp"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+
+// Ordering used by the sorted buckets: later events first, earliest at back()
+bool laterThan(const Event& a, const Event& b) {
+    return a.time > b.time;
+}
+
+// Insert keeping descending order; equal times are popped in arrival order
+void insertSortedDescending(std::vector<Event>& events, const Event& ev) {
+    auto it = std::lower_bound(events.begin(), events.end(), ev, laterThan);
+    events.insert(it, ev);
+}
+
+// Ladder queue tuning (values from the original paper)
+const std::size_t LADDER_BUCKET_THRESHOLD = 50;
+const std::size_t LADDER_MAX_RUNGS = 8;
+
+} // namespace
+
+bool parseEventQueueKind(const std::string& text, EventQueueKind& kind) {
+    if (text == "binary") {
+        kind = EventQueueKind::BINARY_HEAP;
+    }
+    else if (text == "heap4") {
+        kind = EventQueueKind::QUAD_HEAP;
+    }
+    else if (text == "calendar") {
+        kind = EventQueueKind::CALENDAR;
+    }
+    else if (text == "ladder") {
+        kind = EventQueueKind::LADDER;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* eventQueueKindName(EventQueueKind kind) {
+    switch (kind) {
+    case EventQueueKind::BINARY_HEAP: return "binary";
+    case EventQueueKind::QUAD_HEAP:   return "heap4";
+    case EventQueueKind::CALENDAR:    return "calendar";
+    case EventQueueKind::LADDER:      return "ladder";
+    }
+    return "unknown";
+}
+
+std::unique_ptr<EventQueue> makeEventQueue(EventQueueKind kind) {
+    switch (kind) {
+    case EventQueueKind::BINARY_HEAP: return std::make_unique<BinaryHeapQueue>();
+    case EventQueueKind::QUAD_HEAP:   return std::make_unique<QuadHeapQueue>();
+    case EventQueueKind::CALENDAR:    return std::make_unique<CalendarQueue>();
+    case EventQueueKind::LADDER:      return std::make_unique<LadderQueue>();
+    }
+    return std::make_unique<QuadHeapQueue>();
+}
+
+//------------------------------------------------------------------------------
+// BinaryHeapQueue class
+//------------------------------------------------------------------------------
+void BinaryHeapQueue::push(const Event& ev) {
+    heap_.push(ev);
+}
+
+Event BinaryHeapQueue::pop() {
+    Event top = heap_.top();
+    heap_.pop();
+    return top;
+}
+
+bool BinaryHeapQueue::empty() const {
+    return heap_.empty();
+}
+
+std::size_t BinaryHeapQueue::size() const {
+    return heap_.size();
+}
+
+//------------------------------------------------------------------------------
+// QuadHeapQueue class
+//------------------------------------------------------------------------------
+void QuadHeapQueue::push(const Event& ev) {
+    // Sift up: move parents down until the new event's slot is found
+    std::size_t i = heap_.size();
+    heap_.push_back(ev);
+    while (i > 0) {
+        std::size_t parent = (i - 1) / 4;
+        if (heap_[parent].time <= ev.time) {
+            break;
+        }
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = ev;
+}
+
+Event QuadHeapQueue::pop() {
+    assert(!heap_.empty());
+    Event top = heap_.front();
+    Event last = heap_.back();
+    heap_.pop_back();
+
+    std::size_t n = heap_.size();
+    if (n == 0) {
+        return top;
+    }
+
+    // Floyd's variant: walk the hole down to a leaf along the smaller
+    // children without comparing against the moved element, then sift that
+    // element up from the leaf (it usually belongs near the bottom anyway)
+    std::size_t i = 0;
+    for (;;) {
+        std::size_t first = 4 * i + 1;
+        if (first >= n) {
+            break;
+        }
+        std::size_t best = first;
+        if (first + 4 <= n) {
+            // Full group of four: pairwise minimum, which compiles to conditional moves
+            std::size_t left = first + (heap_[first + 1].time < heap_[first].time);
+            std::size_t right = first + 2 + (heap_[first + 3].time < heap_[first + 2].time);
+            best = heap_[right].time < heap_[left].time ? right : left;
+        }
+        else {
+            for (std::size_t c = first + 1; c < n; ++c) {
+                if (heap_[c].time < heap_[best].time) {
+                    best = c;
+                }
+            }
+        }
+        heap_[i] = heap_[best];
+        i = best;
+    }
+    while (i > 0) {
+        std::size_t parent = (i - 1) / 4;
+        if (heap_[parent].time <= last.time) {
+            break;
+        }
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = last;
+    return top;
+}
+
+bool QuadHeapQueue::empty() const {
+    return heap_.empty();
+}
+
+std::size_t QuadHeapQueue::size() const {
+    return heap_.size();
+}
+
+//------------------------------------------------------------------------------
+// CalendarQueue class
+//------------------------------------------------------------------------------
+CalendarQueue::CalendarQueue()
+    : buckets_(2),
+    width_(1.0),
+    invWidth_(1.0),
+    size_(0),
+    currentDay_(0),
+    lastTime_(0.0)
+{
+}
+
+std::uint64_t CalendarQueue::dayOf(double time) const {
+    return static_cast<std::uint64_t>(time * invWidth_);
+}
+
+void CalendarQueue::insert(const Event& ev) {
+    std::size_t mask = buckets_.size() - 1;
+    insertSortedDescending(buckets_[dayOf(ev.time) & mask], ev);
+}
+
+void CalendarQueue::push(const Event& ev) {
+    insert(ev);
+    ++size_;
+    if (size_ > 2 * buckets_.size()) {
+        resize(2 * buckets_.size());
+    }
+}
+
+Event CalendarQueue::pop() {
+    assert(size_ > 0);
+    std::size_t mask = buckets_.size() - 1;
+    Event ev{};
+    bool found = false;
+
+    // Walk at most one year of days starting from the current one
+    for (std::size_t k = 0; k < buckets_.size(); ++k) {
+        std::vector<Event>& bucket = buckets_[currentDay_ & mask];
+        if (!bucket.empty() && dayOf(bucket.back().time) <= currentDay_) {
+            ev = bucket.back();
+            bucket.pop_back();
+            found = true;
+            break;
+        }
+        ++currentDay_;
+    }
+
+    if (!found) {
+        // Sparse calendar: jump straight to the earliest event
+        std::vector<Event>* best = nullptr;
+        for (auto& bucket : buckets_) {
+            if (!bucket.empty() && (!best || bucket.back().time < best->back().time)) {
+                best = &bucket;
+            }
+        }
+        ev = best->back();
+        best->pop_back();
+        currentDay_ = dayOf(ev.time);
+    }
+
+    --size_;
+    lastTime_ = ev.time;
+    if (buckets_.size() > 2 && size_ < buckets_.size() / 2) {
+        resize(buckets_.size() / 2);
+    }
+    return ev;
+}
+
+// Rebuild with a new bucket count, re-estimating the bucket width
+void CalendarQueue::resize(std::size_t bucketCount) {
+    std::vector<Event> all;
+    all.reserve(size_);
+    for (auto& bucket : buckets_) {
+        all.insert(all.end(), bucket.begin(), bucket.end());
+        bucket.clear();
+    }
+
+    // Width = 3x the average gap between the earliest events, ignoring
+    // gaps more than twice the plain average (Brown's estimate)
+    const std::size_t samples = std::min<std::size_t>(all.size(), 25);
+    if (samples >= 2) {
+        std::vector<double> times(all.size());
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            times[i] = all[i].time;
+        }
+        std::partial_sort(times.begin(), times.begin() + samples, times.end());
+        double average = (times[samples - 1] - times[0]) / (samples - 1);
+        double sum = 0.0;
+        std::size_t count = 0;
+        for (std::size_t i = 1; i < samples; ++i) {
+            double gap = times[i] - times[i - 1];
+            if (gap <= 2.0 * average) {
+                sum += gap;
+                ++count;
+            }
+        }
+        if (count > 0 && sum > 0.0) {
+            width_ = 3.0 * sum / count;
+            invWidth_ = 1.0 / width_;
+        }
+    }
+
+    buckets_.resize(bucketCount);
+    for (const Event& ev : all) {
+        insert(ev);
+    }
+    currentDay_ = dayOf(lastTime_);
+}
+
+bool CalendarQueue::empty() const {
+    return size_ == 0;
+}
+
+std::size_t CalendarQueue::size() const {
+    return size_;
+}
+
+//------------------------------------------------------------------------------
+// LadderQueue class
+//------------------------------------------------------------------------------
+LadderQueue::LadderQueue()
+    : topMin_(std::numeric_limits<double>::infinity()),
+    topMax_(-std::numeric_limits<double>::infinity()),
+    topStart_(0.0),
+    activeRungs_(0),
+    size_(0)
+{
+}
+
+void LadderQueue::push(const Event& ev) {
+    ++size_;
+    if (ev.time >= topStart_) {
+        top_.push_back(ev);
+        topMin_ = std::min(topMin_, ev.time);
+        topMax_ = std::max(topMax_, ev.time);
+        return;
+    }
+
+    // The coarsest rung whose unconsumed range covers the event takes it
+    for (std::size_t r = 0; r < activeRungs_; ++r) {
+        Rung& rung = rungs_[r];
+        if (rung.current < rung.buckets.size()
+            && ev.time >= rung.start + rung.current * rung.width) {
+            std::size_t b = static_cast<std::size_t>((ev.time - rung.start) / rung.width);
+            b = std::min(std::max(b, rung.current), rung.buckets.size() - 1);
+            rung.buckets[b].push_back(ev);
+            return;
+        }
+    }
+
+    insertBottom(ev);
+}
+
+Event LadderQueue::pop() {
+    assert(size_ > 0);
+    if (bottom_.empty()) {
+        refillBottom();
+    }
+    Event ev = bottom_.back();
+    bottom_.pop_back();
+    --size_;
+    return ev;
+}
+
+void LadderQueue::insertBottom(const Event& ev) {
+    insertSortedDescending(bottom_, ev);
+}
+
+void LadderQueue::spawnRung(std::vector<Event>& events, double start, double width) {
+    if (rungs_.size() == activeRungs_) {
+        rungs_.emplace_back();
+    }
+    Rung& rung = rungs_[activeRungs_++];
+    rung.start = start;
+    rung.width = width;
+    rung.current = 0;
+
+    std::size_t count = events.size() + 1;
+    for (auto& bucket : rung.buckets) {
+        bucket.clear();
+    }
+    rung.buckets.resize(count);
+    for (const Event& ev : events) {
+        std::size_t b = static_cast<std::size_t>((ev.time - start) / width);
+        rung.buckets[std::min(b, count - 1)].push_back(ev);
+    }
+}
+
+// Move the next batch of events down into Bottom
+void LadderQueue::refillBottom() {
+    while (bottom_.empty()) {
+        if (activeRungs_ == 0) {
+            // Start a new epoch from the Top list
+            assert(!top_.empty());
+            double spread = topMax_ - topMin_;
+            if (top_.size() <= LADDER_BUCKET_THRESHOLD || spread <= 0.0) {
+                bottom_.swap(top_);
+                std::sort(bottom_.begin(), bottom_.end(), laterThan);
+            }
+            else {
+                spawnRung(top_, topMin_, spread / top_.size());
+            }
+            top_.clear();
+            topStart_ = topMax_;
+            topMin_ = std::numeric_limits<double>::infinity();
+            topMax_ = -std::numeric_limits<double>::infinity();
+            continue;
+        }
+
+        Rung& rung = rungs_[activeRungs_ - 1];
+        while (rung.current < rung.buckets.size() && rung.buckets[rung.current].empty()) {
+            ++rung.current;
+        }
+        if (rung.current == rung.buckets.size()) {
+            --activeRungs_;
+            continue;
+        }
+
+        std::vector<Event>& bucket = rung.buckets[rung.current];
+        double bucketStart = rung.start + rung.current * rung.width;
+        double childWidth = rung.width / bucket.size();
+        ++rung.current;
+
+        if (bucket.size() <= LADDER_BUCKET_THRESHOLD
+            || activeRungs_ >= LADDER_MAX_RUNGS
+            || bucketStart + childWidth <= bucketStart) {
+            bottom_.swap(bucket);
+            std::sort(bottom_.begin(), bottom_.end(), laterThan);
+        }
+        else {
+            // Too many events for one sorted list: refine into a new rung
+            std::vector<Event> events;
+            events.swap(bucket);
+            spawnRung(events, bucketStart, childWidth);
+        }
+    }
+}
+
+bool LadderQueue::empty() const {
+    return size_ == 0;
+}
+
+std::size_t LadderQueue::size() const {
+    return size_;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Events and the event-queue backends of the controller
+//------------------------------------------------------------------------------
+
+// 32-bit index of a request slot inside the RequestPool
+using RequestHandle = std::uint32_t;
+static const RequestHandle INVALID_REQUEST = 0xFFFFFFFFu;
+
+// Event types in the controller
+enum class EventType : std::uint32_t {
+    REQUEST_GENERATED, // A new request arrived (generated)
+    REQUEST_SERVED,    // A request finished service
+    BATCH_TIMEOUT,     // A device stops holding its partial batch
+    RENEGE,            // A request's patience runs out (stale once it left the buffer)
+    REQUEST_RETRY      // A rejected, evicted or reneged request comes back
+};
+
+// Event structure: plain 16-byte value, copied around the queues with memcpy
+struct Event {
+    double time;
+    RequestHandle request;
+    EventType type : 8;
+    std::int32_t deviceId : 24; // REQUEST_SERVED / BATCH_TIMEOUT: which device
+
+    bool operator<(const Event& other) const {
+        // We want the earliest event first, so invert comparison
+        return time > other.time;
+    }
+};
+
+static_assert(sizeof(Event) == 16, "Event must stay 16 bytes");
+static_assert(std::is_trivially_copyable<Event>::value, "Event must be trivially copyable");
+
+// Available event-queue backends
+enum class EventQueueKind {
+    BINARY_HEAP, // std::priority_queue (the original implementation)
+    QUAD_HEAP,   // 4-ary implicit heap
+    CALENDAR,    // calendar queue (Brown, 1988)
+    LADDER       // ladder queue (Tang, Goh, Thng, 2005)
+};
+
+// Parse "binary" / "heap4" / "calendar" / "ladder"; returns false on unknown text
+bool parseEventQueueKind(const std::string& text, EventQueueKind& kind);
+const char* eventQueueKindName(EventQueueKind kind);
+
+// Interface of a future-event list ordered by Event::time
+class EventQueue {
+public:
+    virtual ~EventQueue() = default;
+
+    virtual void push(const Event& ev) = 0;
+    // Remove and return the earliest event; the queue must not be empty
+    virtual Event pop() = 0;
+    virtual bool empty() const = 0;
+    virtual std::size_t size() const = 0;
+};
+
+// Create an empty queue of the given kind
+std::unique_ptr<EventQueue> makeEventQueue(EventQueueKind kind);
+
+//------------------------------------------------------------------------------
+// Binary heap (std::priority_queue), kept as the reference backend
+//------------------------------------------------------------------------------
+
+class BinaryHeapQueue : public EventQueue {
+private:
+    std::priority_queue<Event> heap_;
+
+public:
+    void push(const Event& ev) override;
+    Event pop() override;
+    bool empty() const override;
+    std::size_t size() const override;
+};
+
+//------------------------------------------------------------------------------
+// 4-ary implicit heap: shallower than a binary heap, and the four children of
+// a node are adjacent, so a sift-down touches one or two cache lines per level
+//------------------------------------------------------------------------------
+
+class QuadHeapQueue : public EventQueue {
+private:
+    std::vector<Event> heap_;
+
+public:
+    void push(const Event& ev) override;
+    Event pop() override;
+    bool empty() const override;
+    std::size_t size() const override;
+};
+
+//------------------------------------------------------------------------------
+// Calendar queue: events hashed by time into "days" of a circular year;
+// O(1) expected push/pop when the bucket width matches the event spacing
+//------------------------------------------------------------------------------
+
+class CalendarQueue : public EventQueue {
+private:
+    // Each bucket is kept sorted by descending time, so its earliest event is at back()
+    std::vector<std::vector<Event>> buckets_;
+    double width_;
+    double invWidth_;
+    std::size_t size_;
+    std::uint64_t currentDay_; // absolute index of the day being dequeued
+    double lastTime_;          // time of the last dequeued event
+
+    std::uint64_t dayOf(double time) const;
+    void insert(const Event& ev);
+    // Rebuild with a new bucket count, re-estimating the bucket width
+    void resize(std::size_t bucketCount);
+
+public:
+    CalendarQueue();
+
+    void push(const Event& ev) override;
+    Event pop() override;
+    bool empty() const override;
+    std::size_t size() const override;
+};
+
+//------------------------------------------------------------------------------
+// Ladder queue: unsorted Top list, rungs of buckets refined on demand and a
+// short sorted Bottom list; O(1) amortized and insensitive to the time spread
+//------------------------------------------------------------------------------
+
+class LadderQueue : public EventQueue {
+private:
+    struct Rung {
+        std::vector<std::vector<Event>> buckets;
+        double start;
+        double width;
+        std::size_t current; // first bucket not yet moved down
+    };
+
+    std::vector<Event> top_;
+    double topMin_;
+    double topMax_;
+    double topStart_; // events at or after this time go to Top
+    std::vector<Rung> rungs_;   // [0] is the coarsest; storage is reused
+    std::size_t activeRungs_;
+    std::vector<Event> bottom_; // sorted by descending time
+    std::size_t size_;
+
+    void insertBottom(const Event& ev);
+    // Move the next batch of events down into Bottom
+    void refillBottom();
+    void spawnRung(std::vector<Event>& events, double start, double width);
+
+public:
+    LadderQueue();
+
+    void push(const Event& ev) override;
+    Event pop() override;
+    bool empty() const override;
+    std::size_t size() const override;
+};
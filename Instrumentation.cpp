@@ -0,0 +1,356 @@
+#include "Instrumentation.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include "Snapshot.hpp"
+
+namespace {
+
+const char* PRIORITY_LABELS[INSTRUMENT_PRIORITIES] = { "corporate", "premium", "free" };
+
+// Totals of the loops that have finished
+struct FinishedRuns {
+    int runs = 0;
+    std::uint64_t events = 0;
+    std::uint64_t generated = 0;
+    std::uint64_t served = 0;
+    std::uint64_t lost = 0;
+};
+
+// The loops being sampled; LiveCounters add and remove themselves
+struct Registry {
+    std::mutex mutex;
+    std::vector<const LiveCounters*> live;
+    FinishedRuns finished;
+    int nextId = 0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// One figure of a loop, as it is written
+struct RunFigures {
+    std::string run;
+    LiveSample gauges;
+    double eventsPerSecond = 0.0;
+    std::uint64_t generated = 0;
+    std::uint64_t served = 0;
+    std::uint64_t lost = 0;
+};
+
+// Append printf-style text
+void appendLine(std::string& text, const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) {
+        text.append(line, std::min(static_cast<std::size_t>(length), sizeof(line) - 1));
+    }
+}
+
+// Prometheus text exposition format: each metric's HELP and TYPE, then one
+// sample per run; the finished runs have no gauges
+std::string prometheusText(const std::vector<RunFigures>& runs, int finishedRuns) {
+    std::string text;
+    struct Metric {
+        const char* name;
+        const char* type;
+        const char* help;
+    };
+    const Metric metrics[] = {
+        { "mss_events_total", "counter", "Events handled by the event loop" },
+        { "mss_events_per_second", "gauge", "Events handled per wall-clock second since the previous sample" },
+        { "mss_event_queue_depth", "gauge", "Pending events, stale timers included" },
+        { "mss_buffer_requests", "gauge", "Requests waiting in the buffer" },
+        { "mss_idle_devices", "gauge", "Devices without a request" },
+        { "mss_simulated_hours", "gauge", "Simulated time of the last published event" },
+        { "mss_requests_generated_total", "counter", "Requests created by the sources" },
+        { "mss_requests_served_total", "counter", "Requests that started service" },
+        { "mss_requests_lost_total", "counter", "Requests lost for good" },
+    };
+    for (int m = 0; m < static_cast<int>(sizeof(metrics) / sizeof(metrics[0])); ++m) {
+        appendLine(text, "# HELP %s %s\n# TYPE %s %s\n", metrics[m].name, metrics[m].help, metrics[m].name, metrics[m].type);
+        for (const RunFigures& run : runs) {
+            const LiveSample& g = run.gauges;
+            const char* label = run.run.c_str();
+            bool finished = run.run == "finished";
+            switch (m) {
+            case 0: appendLine(text, "%s{run=\"%s\"} %llu\n", metrics[m].name, label, static_cast<unsigned long long>(g.events)); break;
+            case 1:
+                if (!finished) {
+                    appendLine(text, "%s{run=\"%s\"} %.6g\n", metrics[m].name, label, run.eventsPerSecond);
+                }
+                break;
+            case 2:
+                if (!finished) {
+                    appendLine(text, "%s{run=\"%s\"} %llu\n", metrics[m].name, label, static_cast<unsigned long long>(g.queueDepth));
+                }
+                break;
+            case 3:
+                for (int p = 0; !finished && p < INSTRUMENT_PRIORITIES; ++p) {
+                    appendLine(text, "%s{run=\"%s\",priority=\"%s\"} %d\n", metrics[m].name, label, PRIORITY_LABELS[p], g.buffered[p]);
+                }
+                break;
+            case 4:
+                if (!finished) {
+                    appendLine(text, "%s{run=\"%s\"} %d\n", metrics[m].name, label, g.idleDevices);
+                }
+                break;
+            case 5:
+                if (!finished) {
+                    appendLine(text, "%s{run=\"%s\"} %.6f\n", metrics[m].name, label, g.simulatedHours);
+                }
+                break;
+            case 6: appendLine(text, "%s{run=\"%s\"} %llu\n", metrics[m].name, label, static_cast<unsigned long long>(run.generated)); break;
+            case 7: appendLine(text, "%s{run=\"%s\"} %llu\n", metrics[m].name, label, static_cast<unsigned long long>(run.served)); break;
+            default: appendLine(text, "%s{run=\"%s\"} %llu\n", metrics[m].name, label, static_cast<unsigned long long>(run.lost)); break;
+            }
+        }
+    }
+    appendLine(text, "# HELP mss_runs_finished Event loops that have finished\n# TYPE mss_runs_finished gauge\nmss_runs_finished %d\n",
+        finishedRuns);
+    return text;
+}
+
+// InfluxDB line protocol: one line per run, stamped in nanoseconds
+std::string lineProtocolText(const std::vector<RunFigures>& runs, long long nanoseconds) {
+    std::string text;
+    for (const RunFigures& run : runs) {
+        const LiveSample& g = run.gauges;
+        appendLine(text, "mss,run=%s events=%llui,generated=%llui,served=%llui,lost=%llui",
+            run.run.c_str(), static_cast<unsigned long long>(g.events),
+            static_cast<unsigned long long>(run.generated), static_cast<unsigned long long>(run.served),
+            static_cast<unsigned long long>(run.lost));
+        if (run.run != "finished") {
+            appendLine(text, ",events_per_second=%.6g", run.eventsPerSecond);
+            appendLine(text, ",queue_depth=%llui,buffer_corporate=%di,buffer_premium=%di,buffer_free=%di,idle_devices=%di,simulated_hours=%.6f",
+                static_cast<unsigned long long>(g.queueDepth), g.buffered[0], g.buffered[1], g.buffered[2],
+                g.idleDevices, g.simulatedHours);
+        }
+        appendLine(text, " %lld\n", nanoseconds);
+    }
+    return text;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// LiveCounters class
+//------------------------------------------------------------------------------
+LiveCounters::LiveCounters()
+    : counted_(0),
+    untilPublish_(INSTRUMENT_STRIDE),
+    metrics_(nullptr),
+    id_(-1)
+{
+}
+
+// Fold the final figures into the finished runs and unregister; a loop
+// that handled no event (a probe of a snapshot) is not counted
+LiveCounters::~LiveCounters() {
+    if (id_ < 0) {
+        return;
+    }
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.erase(std::remove(r.live.begin(), r.live.end(), this), r.live.end());
+    if (counted_ == 0) {
+        return;
+    }
+    MetricsSnapshot metrics = metrics_->snapshot();
+    r.finished.runs++;
+    r.finished.events += counted_;
+    r.finished.generated += metrics.total.generated;
+    r.finished.served += metrics.total.served;
+    r.finished.lost += metrics.total.lost();
+}
+
+// Register with the samplers
+void LiveCounters::attach(const SimulationMetrics& metrics) {
+    metrics_ = &metrics;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    id_ = r.nextId++;
+    r.live.push_back(this);
+}
+
+// Publish the gauges (with the event count so far)
+void LiveCounters::publish(std::uint64_t queueDepth, const int (&buffered)[INSTRUMENT_PRIORITIES],
+    int idleDevices, double simulatedHours) {
+    events_.store(counted_, std::memory_order_relaxed);
+    queueDepth_.store(queueDepth, std::memory_order_relaxed);
+    for (int p = 0; p < INSTRUMENT_PRIORITIES; ++p) {
+        buffered_[p].store(buffered[p], std::memory_order_relaxed);
+    }
+    idleDevices_.store(idleDevices, std::memory_order_relaxed);
+    simulatedHours_.store(simulatedHours, std::memory_order_relaxed);
+}
+
+// The last publication; the fields are read one by one, so a sample
+// may mix two neighbouring publications, which a gauge tolerates
+LiveSample LiveCounters::read() const {
+    LiveSample sample;
+    sample.events = events_.load(std::memory_order_relaxed);
+    sample.queueDepth = queueDepth_.load(std::memory_order_relaxed);
+    for (int p = 0; p < INSTRUMENT_PRIORITIES; ++p) {
+        sample.buffered[p] = buffered_[p].load(std::memory_order_relaxed);
+    }
+    sample.idleDevices = idleDevices_.load(std::memory_order_relaxed);
+    sample.simulatedHours = simulatedHours_.load(std::memory_order_relaxed);
+    return sample;
+}
+
+const SimulationMetrics& LiveCounters::getMetrics() const {
+    return *metrics_;
+}
+
+int LiveCounters::getId() const {
+    return id_;
+}
+
+bool parseMetricsFormat(const std::string& text, MetricsFormat& format) {
+    if (text == "prometheus") {
+        format = MetricsFormat::PROMETHEUS;
+    }
+    else if (text == "influx") {
+        format = MetricsFormat::LINE_PROTOCOL;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// MetricsSampler class
+//------------------------------------------------------------------------------
+MetricsSampler::MetricsSampler()
+    : format_(MetricsFormat::PROMETHEUS),
+    period_(1.0),
+    stopping_(false)
+{
+}
+
+MetricsSampler::~MetricsSampler() {
+    stop();
+}
+
+// Start sampling every periodSeconds; false if path cannot be written
+bool MetricsSampler::start(const std::string& path, MetricsFormat format, double periodSeconds) {
+    stop();
+    path_ = path;
+    format_ = format;
+    period_ = std::chrono::duration<double>(std::max(0.01, periodSeconds));
+    previous_.clear();
+    previousTime_ = std::chrono::steady_clock::now();
+    if (format_ == MetricsFormat::LINE_PROTOCOL) {
+        std::FILE* out = std::fopen(path_.c_str(), "w"); // a run starts its own series
+        if (!out) {
+            return false;
+        }
+        std::fclose(out);
+    }
+    if (!sample()) {
+        return false;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&MetricsSampler::samplerLoop, this);
+    return true;
+}
+
+// Write a last sample and stop the thread
+void MetricsSampler::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    sample();
+}
+
+void MetricsSampler::samplerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!changed_.wait_for(lock, period_, [this]() { return stopping_; })) {
+        lock.unlock();
+        if (!sample()) {
+            std::fprintf(stderr, "Cannot write %s\n", path_.c_str());
+        }
+        lock.lock();
+    }
+}
+
+// Write one sample; false on a write error
+bool MetricsSampler::sample() {
+    std::vector<RunFigures> runs;
+    int finishedRuns = 0;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        runs.reserve(r.live.size() + 1);
+        for (const LiveCounters* live : r.live) {
+            RunFigures run;
+            run.run = std::to_string(live->getId());
+            run.gauges = live->read();
+            MetricsSnapshot metrics = live->getMetrics().snapshot();
+            run.generated = metrics.total.generated;
+            run.served = metrics.total.served;
+            run.lost = metrics.total.lost();
+            runs.push_back(run);
+        }
+        const FinishedRuns& finished = r.finished;
+        finishedRuns = finished.runs;
+        if (finished.runs > 0) {
+            RunFigures run;
+            run.run = "finished";
+            run.gauges.events = finished.events;
+            run.generated = finished.generated;
+            run.served = finished.served;
+            run.lost = finished.lost;
+            runs.push_back(run);
+        }
+    }
+
+    // Rates of the loops seen in the previous sample
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - previousTime_).count();
+    std::vector<std::pair<int, std::uint64_t>> counts;
+    for (RunFigures& run : runs) {
+        int id = (run.run == "finished") ? -1 : std::stoi(run.run);
+        if (id < 0) {
+            continue;
+        }
+        counts.emplace_back(id, run.gauges.events);
+        auto before = std::find_if(previous_.begin(), previous_.end(),
+            [id](const std::pair<int, std::uint64_t>& p) { return p.first == id; });
+        if (before != previous_.end() && seconds > 0.0) {
+            run.eventsPerSecond = (run.gauges.events - before->second) / seconds;
+        }
+    }
+    previous_.swap(counts);
+    previousTime_ = now;
+
+    if (format_ == MetricsFormat::PROMETHEUS) {
+        // SnapshotWriter provides the write-and-rename
+        std::string text = prometheusText(runs, finishedRuns);
+        SnapshotWriter out;
+        out.writeBytes(text.data(), text.size());
+        return out.save(path_);
+    }
+    long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string text = lineProtocolText(runs, nanoseconds);
+    std::FILE* out = std::fopen(path_.c_str(), "a");
+    if (!out) {
+        return false;
+    }
+    bool written = std::fwrite(text.data(), 1, text.size(), out) == text.size();
+    return (std::fclose(out) == 0) && written;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Metrics.hpp"
+
+//------------------------------------------------------------------------------
+// Live instrumentation: gauges of running event loops, sampled by a thread
+//------------------------------------------------------------------------------
+//
+// Built with MSS_INSTRUMENTATION defined (the CMake option of that name),
+// every Controller owns a LiveCounters, which registers itself here and
+// publishes its gauges every INSTRUMENT_STRIDE events as relaxed stores.
+// A MetricsSampler thread reads every registered loop periodically and
+// writes the figures to a file, so a long run can be watched while it
+// runs. Without the macro the Controller has no hook at all; the sampler
+// still builds but finds no loops to read.
+
+// Priorities the buffer gauges are kept for (checked against PRIORITY_COUNT)
+static const int INSTRUMENT_PRIORITIES = 3;
+
+// Events between two publications of a loop's gauges
+static const std::uint32_t INSTRUMENT_STRIDE = 64;
+
+// The gauges of one event loop at its last publication
+struct LiveSample {
+    std::uint64_t events = 0;     // handled since the loop started
+    std::uint64_t queueDepth = 0; // pending events, stale timers included
+    int buffered[INSTRUMENT_PRIORITIES] = {};
+    int idleDevices = 0;
+    double simulatedHours = 0.0;
+};
+
+// One event loop's gauges. Only the loop writes and it keeps its own
+// count between publications, so an event costs one decrement and a
+// publication a few relaxed stores on a line nobody else writes.
+class alignas(64) LiveCounters {
+private:
+    std::atomic<std::uint64_t> events_{ 0 };
+    std::atomic<std::uint64_t> queueDepth_{ 0 };
+    std::atomic<int> buffered_[INSTRUMENT_PRIORITIES] = {};
+    std::atomic<int> idleDevices_{ 0 };
+    std::atomic<double> simulatedHours_{ 0.0 };
+    std::uint64_t counted_;       // event loop only
+    std::uint32_t untilPublish_;  // event loop only
+    const SimulationMetrics* metrics_;
+    int id_;                      // run label; -1 until attached
+
+public:
+    LiveCounters();
+    ~LiveCounters();
+    LiveCounters(const LiveCounters&) = delete;
+    LiveCounters& operator=(const LiveCounters&) = delete;
+
+    // Register with the samplers, reporting metrics alongside the gauges
+    void attach(const SimulationMetrics& metrics);
+
+    // Count one event; true when the gauges are due for publication
+    bool tick() {
+        counted_++;
+        if (--untilPublish_ != 0) {
+            return false;
+        }
+        untilPublish_ = INSTRUMENT_STRIDE;
+        return true;
+    }
+    // Publish the gauges (with the event count so far)
+    void publish(std::uint64_t queueDepth, const int (&buffered)[INSTRUMENT_PRIORITIES],
+        int idleDevices, double simulatedHours);
+
+    // The last publication; safe from any thread
+    LiveSample read() const;
+    const SimulationMetrics& getMetrics() const;
+    int getId() const;
+};
+
+// File formats of a MetricsSampler
+enum class MetricsFormat {
+    PROMETHEUS,   // text exposition format, the file replaced on each sample
+    LINE_PROTOCOL // InfluxDB line protocol, one line per loop appended per sample
+};
+
+// Parse "prometheus" / "influx"; returns false on unknown text
+bool parseMetricsFormat(const std::string& text, MetricsFormat& format);
+
+// Samples every registered loop each period and writes the figures to a
+// file: events, events per wall-clock second, event-queue depth, requests
+// buffered per priority, idle devices, simulated time and the request
+// counters, labelled by run. Loops that have finished are folded into one
+// run="finished" series, so the file keeps a fixed size over a sweep. A
+// Prometheus file is written to path + ".tmp" and renamed over path, so a
+// node_exporter textfile collector never reads half a sample.
+class MetricsSampler {
+private:
+    std::string path_;
+    MetricsFormat format_;
+    std::chrono::duration<double> period_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool stopping_;
+
+    // Event counts and time of the previous sample, for the rates
+    std::vector<std::pair<int, std::uint64_t>> previous_;
+    std::chrono::steady_clock::time_point previousTime_;
+
+    void samplerLoop();
+    // Write one sample; false on a write error
+    bool sample();
+
+public:
+    MetricsSampler();
+    ~MetricsSampler();
+    MetricsSampler(const MetricsSampler&) = delete;
+    MetricsSampler& operator=(const MetricsSampler&) = delete;
+
+    // Start sampling every periodSeconds; false if path cannot be written
+    bool start(const std::string& path, MetricsFormat format, double periodSeconds);
+    // Write a last sample and stop the thread
+    void stop();
+};
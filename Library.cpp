@@ -0,0 +1,66 @@
+#include "Library.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Run one scenario from an empty system to its stopping rule, writing nothing
+bool runSimulation(const SimulationConfig& config, SimulationResults& results, std::string& error) {
+    SimulationConfig quiet = config;
+    quiet.traceLevel = TraceLevel::OFF;
+    quiet.windowFile.clear();  // batch entries would race on one file
+    quiet.eventLogFile.clear();
+    // A config built in code has not been through the [sources] replay check
+    if (!quiet.replayFile.empty()) {
+        ArrivalTrace trace;
+        if (!trace.open(quiet.replayFile, error)) {
+            return false;
+        }
+    }
+    return withController(quiet, [&results, &error](auto& controller) {
+        if (!controller.getSetupError().empty()) {
+            error = controller.getSetupError();
+            return false;
+        }
+        controller.initRequests();
+        controller.work();
+        results = controller.getResults();
+        return true;
+    });
+}
+
+// Run many independent scenarios on a pool of threads, results in input order
+bool runSimulations(const std::vector<SimulationConfig>& configs, int numThreads,
+    std::vector<SimulationResults>& results, std::string& error) {
+    results.assign(configs.size(), SimulationResults());
+    std::vector<std::string> errors(configs.size());
+    const int count = static_cast<int>(configs.size());
+    std::atomic<int> next(0);
+
+    // Each worker claims the next scenario; Controllers share nothing
+    auto worker = [&configs, &results, &errors, &next, count]() {
+        for (int i = next++; i < count; i = next++) {
+            runSimulation(configs[i], results[i], errors[i]);
+        }
+    };
+
+    if (numThreads <= 0) {
+        numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    int threads = std::min(numThreads, std::max(1, count));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (!errors[i].empty()) {
+            error = "scenario " + std::to_string(i) + ": " + errors[i];
+            return false;
+        }
+    }
+    return true;
+}
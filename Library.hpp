@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+//------------------------------------------------------------------------------
+// Embedding API: scenarios in, results out, no text on the way
+//------------------------------------------------------------------------------
+//
+// The same figures the CLI prints, as values, for callers that evaluate
+// many scenarios in one process. mss.h wraps these calls in a C ABI for
+// other languages (python/mss.py loads it with ctypes).
+
+// Run one scenario from an empty system to its stopping rule and set results
+// to what printStatistics would print. Nothing is written: the trace is
+// forced off, and the config's window file and event log are ignored.
+// False with a message if the run cannot be set up (a replay trace that
+// cannot be read); results are then left as they were.
+bool runSimulation(const SimulationConfig& config, SimulationResults& results, std::string& error);
+
+// Run many independent scenarios on a pool of threads (numThreads <= 0 uses
+// every hardware thread), each as runSimulation; results come back in
+// input order. False with the message of the first scenario that failed,
+// as "scenario i: message"; the other scenarios still run.
+bool runSimulations(const std::vector<SimulationConfig>& configs, int numThreads,
+    std::vector<SimulationResults>& results, std::string& error);
@@ -0,0 +1,65 @@
+#include "Metrics.hpp"
+#include "Snapshot.hpp"
+
+//------------------------------------------------------------------------------
+// SimulationMetrics class
+//------------------------------------------------------------------------------
+
+// Copy one slot (relaxed; snapshot() checks the sequence around it)
+MetricCounters SimulationMetrics::read(int slot) const {
+    const Counters& counters = counters_[slot];
+    MetricCounters values;
+    values.generated = counters.generated.load(std::memory_order_relaxed);
+    values.served = counters.served.load(std::memory_order_relaxed);
+    values.rejected = counters.rejected.load(std::memory_order_relaxed);
+    values.evicted = counters.evicted.load(std::memory_order_relaxed);
+    values.reneged = counters.reneged.load(std::memory_order_relaxed);
+    values.retried = counters.retried.load(std::memory_order_relaxed);
+    values.waitHours = counters.waitHours.load(std::memory_order_relaxed);
+    return values;
+}
+
+// Consistent copy of every counter: retry while an update is in progress
+// or one completed during the copy
+MetricsSnapshot SimulationMetrics::snapshot() const {
+    MetricsSnapshot copy;
+    for (;;) {
+        std::uint32_t before = sequence_.load(std::memory_order_acquire);
+        if ((before & 1u) == 0) {
+            copy.total = read(METRIC_PRIORITIES);
+            for (int p = 0; p < METRIC_PRIORITIES; ++p) {
+                copy.byPriority[p] = read(p);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return copy;
+            }
+        }
+    }
+}
+
+void SimulationMetrics::save(SnapshotWriter& out) const {
+    for (int slot = 0; slot <= METRIC_PRIORITIES; ++slot) {
+        out.write(read(slot));
+    }
+}
+
+bool SimulationMetrics::load(SnapshotReader& in) {
+    MetricCounters values[METRIC_PRIORITIES + 1];
+    if (!in.read(values)) {
+        return false;
+    }
+    beginUpdate();
+    for (int slot = 0; slot <= METRIC_PRIORITIES; ++slot) {
+        Counters& counters = counters_[slot];
+        counters.generated.store(values[slot].generated, std::memory_order_relaxed);
+        counters.served.store(values[slot].served, std::memory_order_relaxed);
+        counters.rejected.store(values[slot].rejected, std::memory_order_relaxed);
+        counters.evicted.store(values[slot].evicted, std::memory_order_relaxed);
+        counters.reneged.store(values[slot].reneged, std::memory_order_relaxed);
+        counters.retried.store(values[slot].retried, std::memory_order_relaxed);
+        counters.waitHours.store(values[slot].waitHours, std::memory_order_relaxed);
+    }
+    endUpdate();
+    return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Run counters: one flat block, written by the event loop, readable anywhere
+//------------------------------------------------------------------------------
+
+// Priorities tracked by the counters (checked against PRIORITY_COUNT)
+static const int METRIC_PRIORITIES = 3;
+
+// Counters of one priority, or of all of them, as plain values; 64-bit, so
+// a long run or a benchmark loop cannot wrap them
+struct MetricCounters {
+    std::int64_t generated = 0;  // requests created by the sources
+    std::int64_t served = 0;     // requests that started service
+    std::int64_t rejected = 0;   // refused by a full buffer
+    std::int64_t evicted = 0;    // pushed out of the buffer by a higher priority
+    std::int64_t reneged = 0;    // left the buffer when their patience ran out
+    std::int64_t retried = 0;    // lost attempts that come back
+    double waitHours = 0.0;      // buffer wait summed over the served requests
+
+    // Requests lost for good: every lost attempt but those retried
+    std::int64_t lost() const { return rejected + evicted + reneged - retried; }
+};
+
+// A consistent copy of SimulationMetrics
+struct MetricsSnapshot {
+    MetricCounters total;
+    MetricCounters byPriority[METRIC_PRIORITIES];
+};
+
+// The counters of one run, indexed by priority with the totals in the last
+// slot, so an update is two adds at fixed offsets instead of a map lookup.
+// Only the thread running the event loop writes; every update is bracketed
+// by a sequence number (odd while writing), so any other thread can take a
+// snapshot() without locks and without stalling the writer. The fields are
+// relaxed atomics: on common hardware they compile to plain loads/stores.
+class alignas(64) SimulationMetrics {
+private:
+    struct Counters {
+        std::atomic<std::int64_t> generated{ 0 };
+        std::atomic<std::int64_t> served{ 0 };
+        std::atomic<std::int64_t> rejected{ 0 };
+        std::atomic<std::int64_t> evicted{ 0 };
+        std::atomic<std::int64_t> reneged{ 0 };
+        std::atomic<std::int64_t> retried{ 0 };
+        std::atomic<double> waitHours{ 0.0 };
+    };
+
+    std::atomic<std::uint32_t> sequence_{ 0 };
+    Counters counters_[METRIC_PRIORITIES + 1];
+
+    static void bump(std::atomic<std::int64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    static void add(std::atomic<double>& sum, double value) {
+        sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    void beginUpdate() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void endUpdate() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    // Copy one slot (relaxed; snapshot() checks the sequence around it)
+    MetricCounters read(int slot) const;
+
+public:
+    SimulationMetrics() = default;
+    SimulationMetrics(const SimulationMetrics&) = delete;
+    SimulationMetrics& operator=(const SimulationMetrics&) = delete;
+
+    // Updates, from the event loop only
+    void recordGenerated(int priority) {
+        beginUpdate();
+        bump(counters_[priority].generated);
+        bump(counters_[METRIC_PRIORITIES].generated);
+        endUpdate();
+    }
+    void recordServed(int priority, double waitHours) {
+        beginUpdate();
+        bump(counters_[priority].served);
+        add(counters_[priority].waitHours, waitHours);
+        bump(counters_[METRIC_PRIORITIES].served);
+        add(counters_[METRIC_PRIORITIES].waitHours, waitHours);
+        endUpdate();
+    }
+    void recordRejected(int priority) {
+        beginUpdate();
+        bump(counters_[priority].rejected);
+        bump(counters_[METRIC_PRIORITIES].rejected);
+        endUpdate();
+    }
+    void recordEvicted(int priority) {
+        beginUpdate();
+        bump(counters_[priority].evicted);
+        bump(counters_[METRIC_PRIORITIES].evicted);
+        endUpdate();
+    }
+    void recordReneged(int priority) {
+        beginUpdate();
+        bump(counters_[priority].reneged);
+        bump(counters_[METRIC_PRIORITIES].reneged);
+        endUpdate();
+    }
+    void recordRetried(int priority) {
+        beginUpdate();
+        bump(counters_[priority].retried);
+        bump(counters_[METRIC_PRIORITIES].retried);
+        endUpdate();
+    }
+
+    // Totals, for the event loop's own thread
+    std::int64_t generated() const { return counters_[METRIC_PRIORITIES].generated.load(std::memory_order_relaxed); }
+    std::int64_t served() const { return counters_[METRIC_PRIORITIES].served.load(std::memory_order_relaxed); }
+    std::int64_t lost() const {
+        const Counters& total = counters_[METRIC_PRIORITIES];
+        return total.rejected.load(std::memory_order_relaxed) + total.evicted.load(std::memory_order_relaxed)
+            + total.reneged.load(std::memory_order_relaxed) - total.retried.load(std::memory_order_relaxed);
+    }
+
+    // Consistent copy of every counter; safe from any thread at any time
+    MetricsSnapshot snapshot() const;
+
+    // Write the counters to a snapshot file / read them back (event loop only)
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
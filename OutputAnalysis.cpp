@@ -0,0 +1,161 @@
+#include "OutputAnalysis.hpp"
+#include <algorithm>
+#include <cmath>
+#include "Snapshot.hpp"
+#include "Statistics.hpp"
+
+// Number of leading batch means to drop (MSER statistic)
+int mserTruncation(const std::vector<double>& means) {
+    int n = static_cast<int>(means.size());
+    if (n < 2) {
+        return 0;
+    }
+
+    // Suffix sums give the mean and squared deviation of every tail in O(n)
+    double sum = 0.0;
+    double squares = 0.0;
+    double best = INFINITY;
+    int bestD = 0;
+    for (int d = n - 1; d >= 0; --d) {
+        sum += means[d];
+        squares += means[d] * means[d];
+        if (d > n / 2) {
+            continue;
+        }
+        double count = static_cast<double>(n - d);
+        double deviation = squares - sum * sum / count;
+        double statistic = deviation / (count * count);
+        if (statistic <= best) {
+            best = statistic;
+            bestD = d;
+        }
+    }
+    return bestD;
+}
+
+//------------------------------------------------------------------------------
+// BatchMeans class
+//------------------------------------------------------------------------------
+BatchMeans::BatchMeans(int capacity)
+    : capacity_(static_cast<std::size_t>(capacity) & ~static_cast<std::size_t>(1)),
+    batchSize_(MSER_BATCH_SIZE),
+    partialSum_(0.0),
+    partialCount_(0),
+    observations_(0)
+{
+    sums_.reserve(capacity_);
+}
+
+// Add one observation; true when it completed a batch
+bool BatchMeans::add(double value) {
+    observations_++;
+    partialSum_ += value;
+    if (++partialCount_ < batchSize_) {
+        return false;
+    }
+
+    sums_.push_back(partialSum_);
+    partialSum_ = 0.0;
+    partialCount_ = 0;
+
+    if (sums_.size() == capacity_) {
+        // Collapse pairs: half as many batches, twice as long
+        for (std::size_t i = 0; i < capacity_ / 2; ++i) {
+            sums_[i] = sums_[2 * i] + sums_[2 * i + 1];
+        }
+        sums_.resize(capacity_ / 2);
+        batchSize_ *= 2;
+    }
+    return true;
+}
+
+// MSER-truncated mean with its batch-means confidence half-width
+SteadyStateEstimate BatchMeans::estimate() const {
+    SteadyStateEstimate result;
+    result.observations = observations_;
+    if (sums_.empty()) {
+        return result;
+    }
+
+    std::vector<double> means(sums_.size());
+    for (std::size_t i = 0; i < sums_.size(); ++i) {
+        means[i] = sums_[i] / static_cast<double>(batchSize_);
+    }
+    int drop = mserTruncation(means);
+    int remaining = static_cast<int>(means.size()) - drop;
+
+    // Regroup the kept batches into equal groups; leftovers join the warm-up
+    int groups = std::min(BATCH_MEANS_GROUPS, remaining);
+    int perGroup = remaining / groups;
+    drop += remaining - groups * perGroup;
+    result.truncated = static_cast<std::uint64_t>(drop) * batchSize_;
+
+    RunningStats groupMeans;
+    for (int g = 0; g < groups; ++g) {
+        double sum = 0.0;
+        for (int i = 0; i < perGroup; ++i) {
+            sum += means[drop + g * perGroup + i];
+        }
+        groupMeans.add(sum / perGroup);
+    }
+    result.mean = groupMeans.mean();
+    if (groups > 1) {
+        result.halfWidth = studentT975(groups - 1) * groupMeans.stddev() / std::sqrt(static_cast<double>(groups));
+    }
+    return result;
+}
+
+std::uint64_t BatchMeans::observations() const {
+    return observations_;
+}
+
+int BatchMeans::batches() const {
+    return static_cast<int>(sums_.size());
+}
+
+// Write the batches to a snapshot
+void BatchMeans::save(SnapshotWriter& out) const {
+    out.write(static_cast<std::uint64_t>(capacity_));
+    out.write(batchSize_);
+    out.write(partialSum_);
+    out.write(partialCount_);
+    out.write(observations_);
+    out.writeVector(sums_);
+}
+
+// Read batches saved with the same capacity
+bool BatchMeans::load(SnapshotReader& in) {
+    std::uint64_t capacity = 0;
+    if (!in.read(capacity) || capacity != capacity_ || !in.read(batchSize_) || !in.read(partialSum_)
+        || !in.read(partialCount_) || !in.read(observations_) || !in.readVector(sums_)) {
+        return false;
+    }
+    return sums_.size() < capacity_;
+}
+
+//------------------------------------------------------------------------------
+// PrecisionRule class
+//------------------------------------------------------------------------------
+PrecisionRule::PrecisionRule(double target, std::uint64_t minObservations)
+    : target_(target),
+    minObservations_(minObservations)
+{
+}
+
+bool PrecisionRule::enabled() const {
+    return target_ > 0.0;
+}
+
+// True when the estimate is precise enough (a zero mean needs a zero width)
+bool PrecisionRule::satisfied(const BatchMeans& series) const {
+    if (series.observations() < minObservations_
+        || series.batches() < 2 * BATCH_MEANS_GROUPS) {
+        return false;
+    }
+    SteadyStateEstimate estimate = series.estimate();
+    return estimate.halfWidth <= target_ * std::fabs(estimate.mean);
+}
+
+double PrecisionRule::getTarget() const {
+    return target_;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Steady-state output analysis: MSER-5 warm-up truncation and batch means
+//------------------------------------------------------------------------------
+
+// Batch size of the finest batches (the "5" of MSER-5)
+static const int MSER_BATCH_SIZE = 5;
+// Number of batch-mean groups the confidence interval is built from
+static const int BATCH_MEANS_GROUPS = 20;
+
+// Steady-state mean of one output series after warm-up truncation
+struct SteadyStateEstimate {
+    double mean = 0.0;
+    double halfWidth = 0.0;            // 95%, batch means over BATCH_MEANS_GROUPS
+    std::uint64_t observations = 0;    // all observations seen
+    std::uint64_t truncated = 0;       // leading observations removed as warm-up
+};
+
+// Number of leading batch means to drop: the d <= n/2 minimizing the MSER
+// statistic sum_{i>=d} (Y_i - mean_d)^2 / (n - d)^2
+int mserTruncation(const std::vector<double>& means);
+
+// Batch means over a fixed number of slots. When every slot is full,
+// adjacent batches are merged and the batch size doubles, so memory stays
+// constant however long the run is.
+class BatchMeans {
+private:
+    std::vector<double> sums_;  // sum of each completed batch
+    std::size_t capacity_;
+    std::uint64_t batchSize_;
+    double partialSum_;
+    std::uint64_t partialCount_;
+    std::uint64_t observations_;
+
+public:
+    explicit BatchMeans(int capacity = 256);
+
+    // Add one observation; true when it completed a batch
+    bool add(double value);
+
+    // MSER-truncated mean with its batch-means confidence half-width
+    SteadyStateEstimate estimate() const;
+
+    std::uint64_t observations() const;
+    int batches() const;
+
+    // Write the batches to a snapshot / read them back (same capacity only)
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+// Stop once the relative half-width of every series is below a target
+class PrecisionRule {
+private:
+    double target_;
+    std::uint64_t minObservations_;
+
+public:
+    // target: relative 95% half-width (e.g. 0.05); 0 disables the rule
+    explicit PrecisionRule(double target = 0.0, std::uint64_t minObservations = 1000);
+
+    bool enabled() const;
+    // True when the estimate is precise enough (a zero mean needs a zero width)
+    bool satisfied(const BatchMeans& series) const;
+    double getTarget() const;
+};
@@ -0,0 +1,374 @@
+#include "Random.hpp"
+#include <cmath>
+#include <cstring>
+#include "Snapshot.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const std::uint32_t PHILOX_M0 = 0xD2511F53u;
+const std::uint32_t PHILOX_M1 = 0xCD9E8D57u;
+const std::uint32_t PHILOX_W0 = 0x9E3779B9u;
+const std::uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+// Blocks encrypted together by philoxLanes
+const int PHILOX_LANES = 4;
+
+// fdlibm's log(1 + f) kernel: ln 2 split in two and the minimax
+// coefficients of (log(1 + f) - f + f^2 / 2) / s in z = s^2
+const double LN2_HI = 6.93147180369123816490e-01;
+const double LN2_LO = 1.90821492927058770002e-10;
+const double SQRT2 = 1.41421356237309504880;
+const double LG1 = 6.666666666666735130e-01;
+const double LG2 = 3.999999999940941908e-01;
+const double LG3 = 2.857142874366239149e-01;
+const double LG4 = 2.222219843214978396e-01;
+const double LG5 = 1.818357216161805012e-01;
+const double LG6 = 1.531383769920937332e-01;
+const double LG7 = 1.479819860511658591e-01;
+
+#if defined(__AVX2__)
+
+// PHILOX_LANES consecutive counters through the ten Philox rounds; block j
+// goes to out[4j .. 4j + 3]. One 64-bit lane per block: _mm256_mul_epu32
+// gives the full 32x32 -> 64 bit products that Philox needs.
+void philoxLanes(std::uint32_t k0, std::uint32_t k1, std::uint64_t counter,
+    std::uint32_t c2, std::uint32_t c3, std::uint32_t* out) {
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const __m256i m0 = _mm256_set1_epi64x(PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi64x(PHILOX_M1);
+    __m256i n = _mm256_set_epi64x(static_cast<long long>(counter + 3), static_cast<long long>(counter + 2),
+        static_cast<long long>(counter + 1), static_cast<long long>(counter));
+    __m256i x0 = _mm256_and_si256(n, low);
+    __m256i x1 = _mm256_srli_epi64(n, 32);
+    __m256i x2 = _mm256_set1_epi64x(c2);
+    __m256i x3 = _mm256_set1_epi64x(c3);
+
+    for (int round = 0; round < 10; ++round) {
+        __m256i p0 = _mm256_mul_epu32(x0, m0);
+        __m256i p1 = _mm256_mul_epu32(x2, m1);
+        x0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), x1), _mm256_set1_epi64x(k0));
+        x1 = _mm256_and_si256(p1, low);
+        x2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), x3), _mm256_set1_epi64x(k1));
+        x3 = _mm256_and_si256(p0, low);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    // Interleave the four word vectors into block order
+    __m256i a = _mm256_or_si256(x0, _mm256_slli_epi64(x1, 32)); // c0 c1 of each block
+    __m256i b = _mm256_or_si256(x2, _mm256_slli_epi64(x3, 32)); // c2 c3 of each block
+    __m256i lo = _mm256_unpacklo_epi64(a, b);                   // blocks 0 and 2
+    __m256i hi = _mm256_unpackhi_epi64(a, b);                   // blocks 1 and 3
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// -log(1 - u) four at a time; the operations match the portable loop below
+void negLogComplementLanes(const double* uniforms, double* out) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    __m256d x = _mm256_sub_pd(one, _mm256_loadu_pd(uniforms));
+    __m256i bits = _mm256_castpd_si256(x);
+
+    // Unbiased exponent; it fits the low dword of each lane
+    __m256i biased = _mm256_permutevar8x32_epi32(_mm256_srli_epi64(bits, 52),
+        _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    __m256d e = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(biased)), _mm256_set1_pd(1023.0));
+
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll)),
+        _mm256_set1_epi64x(0x3FF0000000000000ll)));
+    __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), big);
+    e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d w = _mm256_mul_pd(z, z);
+    __m256d t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG2),
+        _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG4), _mm256_mul_pd(w, _mm256_set1_pd(LG6))))));
+    __m256d t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LG1),
+        _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG3),
+            _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG5), _mm256_mul_pd(w, _mm256_set1_pd(LG7))))))));
+    __m256d r = _mm256_add_pd(t2, t1);
+    __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(half, f), f);
+
+    __m256d inner = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)), _mm256_mul_pd(e, _mm256_set1_pd(LN2_LO)));
+    __m256d log = _mm256_sub_pd(_mm256_mul_pd(e, _mm256_set1_pd(LN2_HI)),
+        _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+    _mm256_storeu_pd(out, _mm256_sub_pd(_mm256_setzero_pd(), log));
+}
+
+#else
+
+// PHILOX_LANES consecutive counters through the ten Philox rounds; block j
+// goes to out[4j .. 4j + 3]. The lanes are independent, so the loops
+// vectorize where the compiler has 32x32 -> 64 bit vector multiplies.
+void philoxLanes(std::uint32_t k0, std::uint32_t k1, std::uint64_t counter,
+    std::uint32_t c2, std::uint32_t c3, std::uint32_t* out) {
+    std::uint32_t x0[PHILOX_LANES], x1[PHILOX_LANES], x2[PHILOX_LANES], x3[PHILOX_LANES];
+    for (int j = 0; j < PHILOX_LANES; ++j) {
+        x0[j] = static_cast<std::uint32_t>(counter + j);
+        x1[j] = static_cast<std::uint32_t>((counter + j) >> 32);
+        x2[j] = c2;
+        x3[j] = c3;
+    }
+    for (int round = 0; round < 10; ++round) {
+        for (int j = 0; j < PHILOX_LANES; ++j) {
+            std::uint64_t p0 = static_cast<std::uint64_t>(PHILOX_M0) * x0[j];
+            std::uint64_t p1 = static_cast<std::uint64_t>(PHILOX_M1) * x2[j];
+            x0[j] = static_cast<std::uint32_t>(p1 >> 32) ^ x1[j] ^ k0;
+            x1[j] = static_cast<std::uint32_t>(p1);
+            x2[j] = static_cast<std::uint32_t>(p0 >> 32) ^ x3[j] ^ k1;
+            x3[j] = static_cast<std::uint32_t>(p0);
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    for (int j = 0; j < PHILOX_LANES; ++j) {
+        out[4 * j] = x0[j];
+        out[4 * j + 1] = x1[j];
+        out[4 * j + 2] = x2[j];
+        out[4 * j + 3] = x3[j];
+    }
+}
+
+#endif
+
+// SplitMix64 finalizer: a bijective 64-bit mix
+std::uint64_t mix64(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+// Stream id of the given entity
+std::uint64_t streamId(StreamKind kind, int index) {
+    return (static_cast<std::uint64_t>(kind) << 32) | static_cast<std::uint32_t>(index);
+}
+
+// Stream id of the draw-th keyed draw of an entity: the draw above the kind
+std::uint64_t streamId(StreamKind kind, int index, int draw) {
+    return streamId(kind, index) | (static_cast<std::uint64_t>(draw & 0xFFFFFF) << 40);
+}
+
+// Uniform in [0, 1) fixed by (seed, stream) alone
+double keyedUniform(std::uint64_t seed, std::uint64_t stream, bool antithetic) {
+    Philox4x32 generator(seed, stream);
+    std::uint32_t flip = antithetic ? 0xFFFFFFFFu : 0u;
+    std::uint64_t hi = (generator() ^ flip) >> 5;
+    std::uint64_t lo = (generator() ^ flip) >> 6;
+    return static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+}
+
+// Seed of replication number `replication` derived from a master seed
+std::uint64_t replicationSeed(std::uint64_t masterSeed, int replication) {
+    return mix64(masterSeed ^ mix64(static_cast<std::uint64_t>(replication)));
+}
+
+// Seed of shard `shard` of one sharded run; shard 0 keeps the run's seed
+std::uint64_t shardSeed(std::uint64_t runSeed, int shard) {
+    if (shard == 0) {
+        return runSeed;
+    }
+    // A different constant than replicationSeed, so shards and replications never collide
+    return mix64(runSeed ^ mix64(0x5348415244000000ull | static_cast<std::uint32_t>(shard)));
+}
+
+//------------------------------------------------------------------------------
+// Philox4x32 class
+//------------------------------------------------------------------------------
+Philox4x32::Philox4x32(std::uint64_t seed, std::uint64_t stream) {
+    this->seed(seed, stream);
+}
+
+// Restart at the beginning of the given stream
+void Philox4x32::seed(std::uint64_t seed, std::uint64_t stream) {
+    key_[0] = static_cast<std::uint32_t>(seed);
+    key_[1] = static_cast<std::uint32_t>(seed >> 32);
+    counter_[0] = 0;
+    counter_[1] = 0;
+    counter_[2] = static_cast<std::uint32_t>(stream);
+    counter_[3] = static_cast<std::uint32_t>(stream >> 32);
+    index_ = 4;
+}
+
+// Encrypt the current counter into output_ and advance it
+void Philox4x32::generateBlock() {
+    std::uint32_t c0 = counter_[0], c1 = counter_[1], c2 = counter_[2], c3 = counter_[3];
+    std::uint32_t k0 = key_[0], k1 = key_[1];
+
+    for (int round = 0; round < 10; ++round) {
+        std::uint64_t p0 = static_cast<std::uint64_t>(PHILOX_M0) * c0;
+        std::uint64_t p1 = static_cast<std::uint64_t>(PHILOX_M1) * c2;
+        std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        std::uint32_t n1 = static_cast<std::uint32_t>(p1);
+        std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        std::uint32_t n3 = static_cast<std::uint32_t>(p0);
+        c0 = n0; c1 = n1; c2 = n2; c3 = n3;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    output_[0] = c0;
+    output_[1] = c1;
+    output_[2] = c2;
+    output_[3] = c3;
+    index_ = 0;
+
+    // 64-bit block counter in the low half
+    if (++counter_[0] == 0) {
+        ++counter_[1];
+    }
+}
+
+// Write the next `blocks` blocks (4 words each) to out
+void Philox4x32::generate(std::uint32_t* out, int blocks) {
+    std::uint64_t counter = (static_cast<std::uint64_t>(counter_[1]) << 32) | counter_[0];
+    int b = 0;
+    for (; b + PHILOX_LANES <= blocks; b += PHILOX_LANES) {
+        philoxLanes(key_[0], key_[1], counter + b, counter_[2], counter_[3], out + 4 * b);
+    }
+    if (b < blocks) {
+        std::uint32_t tail[4 * PHILOX_LANES];
+        philoxLanes(key_[0], key_[1], counter + b, counter_[2], counter_[3], tail);
+        std::memcpy(out + 4 * b, tail, sizeof(std::uint32_t) * 4 * (blocks - b));
+    }
+
+    counter += blocks;
+    counter_[0] = static_cast<std::uint32_t>(counter);
+    counter_[1] = static_cast<std::uint32_t>(counter >> 32);
+    index_ = 4;
+}
+
+// Next 32 random bits (UniformRandomBitGenerator interface)
+Philox4x32::result_type Philox4x32::operator()() {
+    if (index_ == 4) {
+        generateBlock();
+    }
+    return output_[index_++];
+}
+
+// Uniform double in [0, 1) with 53 random bits
+double Philox4x32::uniform() {
+    std::uint64_t hi = (*this)() >> 5; // 27 bits
+    std::uint64_t lo = (*this)() >> 6; // 26 bits
+    return static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+}
+
+// Exponential variate with the given rate (inverse transform)
+double Philox4x32::exponential(double rate) {
+    return -std::log1p(-uniform()) / rate;
+}
+
+//------------------------------------------------------------------------------
+// Unit exponentials and VariateStream
+//------------------------------------------------------------------------------
+
+// Unit exponentials -log(1 - u) of n uniforms in [0, 1). 1 - u is exact for
+// 53-bit uniforms and at least 2^-53, so no special cases are needed.
+// Random.cpp is built without floating-point contraction, which keeps the
+// vector and scalar paths bit-identical.
+void negLogComplement(const double* uniforms, double* out, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        negLogComplementLanes(uniforms + i, out + i);
+    }
+#endif
+    for (; i < n; ++i) {
+        double x = 1.0 - uniforms[i];
+        std::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        double e = static_cast<double>(static_cast<std::int32_t>(bits >> 52)) - 1023.0;
+        bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+        double m;
+        std::memcpy(&m, &bits, sizeof(m));
+        if (m > SQRT2) {
+            m = m * 0.5;
+            e = e + 1.0;
+        }
+
+        double f = m - 1.0;
+        double s = f / (2.0 + f);
+        double z = s * s;
+        double w = z * z;
+        double t1 = w * (LG2 + w * (LG4 + w * LG6));
+        double t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+        double r = t2 + t1;
+        double hfsq = 0.5 * f * f;
+        double log = e * LN2_HI - ((hfsq - (s * (hfsq + r) + e * LN2_LO)) - f);
+        out[i] = 0.0 - log;
+    }
+}
+
+VariateStream::VariateStream(std::uint64_t seed, std::uint64_t stream, bool antithetic)
+    : generator_(seed, stream),
+    flip_(antithetic ? 0xFFFFFFFFu : 0u),
+    wordIndex_(VARIATE_BLOCK),
+    exponentialIndex_(VARIATE_BLOCK)
+{
+}
+
+// Restart at the beginning of the given stream
+void VariateStream::seed(std::uint64_t seed, std::uint64_t stream) {
+    generator_.seed(seed, stream);
+    wordIndex_ = VARIATE_BLOCK;
+    exponentialIndex_ = VARIATE_BLOCK;
+}
+
+bool VariateStream::isAntithetic() const {
+    return flip_ != 0;
+}
+
+// Write the generator and the unread part of each block to a snapshot
+void VariateStream::save(SnapshotWriter& out) const {
+    out.write(generator_);
+    out.write(wordIndex_);
+    out.write(exponentialIndex_);
+    out.writeBytes(words_ + wordIndex_, (VARIATE_BLOCK - wordIndex_) * sizeof(words_[0]));
+    out.writeBytes(exponentials_ + exponentialIndex_,
+        (VARIATE_BLOCK - exponentialIndex_) * sizeof(exponentials_[0]));
+}
+
+bool VariateStream::load(SnapshotReader& in) {
+    if (!in.read(generator_) || !in.read(wordIndex_) || !in.read(exponentialIndex_)
+        || wordIndex_ < 0 || wordIndex_ > VARIATE_BLOCK
+        || exponentialIndex_ < 0 || exponentialIndex_ > VARIATE_BLOCK) {
+        return false;
+    }
+    return in.readBytes(words_ + wordIndex_, (VARIATE_BLOCK - wordIndex_) * sizeof(words_[0]))
+        && in.readBytes(exponentials_ + exponentialIndex_,
+            (VARIATE_BLOCK - exponentialIndex_) * sizeof(exponentials_[0]));
+}
+
+void VariateStream::refillWords() {
+    generator_.generate(words_, VARIATE_BLOCK / 4);
+    if (flip_ != 0) {
+        for (std::uint32_t& word : words_) {
+            word ^= flip_;
+        }
+    }
+    wordIndex_ = 0;
+}
+
+// Two words per uniform, combined as in Philox4x32::uniform
+void VariateStream::refillExponentials() {
+    std::uint32_t raw[2 * VARIATE_BLOCK];
+    double uniforms[VARIATE_BLOCK];
+    generator_.generate(raw, VARIATE_BLOCK / 2);
+    for (int i = 0; i < VARIATE_BLOCK; ++i) {
+        std::uint64_t hi = (raw[2 * i] ^ flip_) >> 5;
+        std::uint64_t lo = (raw[2 * i + 1] ^ flip_) >> 6;
+        uniforms[i] = static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+    }
+    negLogComplement(uniforms, exponentials_, VARIATE_BLOCK);
+    exponentialIndex_ = 0;
+}
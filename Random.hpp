@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Reproducible random-number streams
+//------------------------------------------------------------------------------
+
+// Kinds of entities that own a random stream; together with the entity
+// index they form the stream id, so every stream is fixed by (seed, entity)
+enum class StreamKind : std::uint32_t {
+    CONTROLLER = 0,
+    SOURCE = 1,
+    DEVICE = 2,
+    DEMAND = 3,   // one stream per request id (common random numbers)
+    ADMISSION = 4, // one stream per request id (EarlyDrop decisions)
+    PATIENCE = 5,  // one stream per request id and attempt (see Abandonment.hpp)
+    RETRY = 6,     // ... whether a lost attempt retries
+    BACKOFF = 7    // ... and after how long
+};
+
+// Stream id of the given entity
+std::uint64_t streamId(StreamKind kind, int index);
+// Stream id of the draw-th keyed draw of an entity (draw < 2^24); draw 0
+// is the entity's own stream
+std::uint64_t streamId(StreamKind kind, int index, int draw);
+
+// Seed of replication number `replication` derived from a master seed
+std::uint64_t replicationSeed(std::uint64_t masterSeed, int replication);
+
+// Seed of shard `shard` of one sharded run; shard 0 keeps the run's seed
+std::uint64_t shardSeed(std::uint64_t runSeed, int shard);
+
+// Philox4x32-10 counter-based generator (Salmon et al., SC'11).
+// The key is the seed, the upper half of the 128-bit counter is the stream
+// id and the lower half counts blocks, so streams never overlap and
+// creating one costs no warm-up. State is 44 bytes (vs ~5 KB for mt19937).
+class Philox4x32 {
+private:
+    std::uint32_t key_[2];
+    std::uint32_t counter_[4];
+    std::uint32_t output_[4];
+    int index_; // next unused word of output_
+
+    // Encrypt the current counter into output_ and advance it
+    void generateBlock();
+
+public:
+    using result_type = std::uint32_t;
+
+    explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+    // Restart at the beginning of the given stream
+    void seed(std::uint64_t seed, std::uint64_t stream);
+
+    // Next 32 random bits (UniformRandomBitGenerator interface)
+    result_type operator()();
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+    // Uniform double in [0, 1) with 53 random bits
+    double uniform();
+    // Exponential variate with the given rate (inverse transform)
+    double exponential(double rate);
+
+    // Write the next `blocks` blocks (4 words each) to out, several counters
+    // at a time; the words equal those of repeated operator() calls started
+    // at a block boundary. Unread words of the current block are skipped.
+    void generate(std::uint32_t* out, int blocks);
+};
+
+// Uniform in [0, 1) fixed by (seed, stream) alone, for a draw keyed by an
+// entity rather than read in sequence; 1 - u (less 2^-53) when antithetic
+double keyedUniform(std::uint64_t seed, std::uint64_t stream, bool antithetic);
+
+// Variates pre-generated per refill of a VariateStream block. Every entity
+// owns a stream, so this stays small: 32 words and 32 doubles keep a stream
+// near 400 bytes while a refill still feeds whole vector kernels.
+static const int VARIATE_BLOCK = 32;
+
+// Unit exponentials -log(1 - u) of n uniforms in [0, 1), computed with the
+// same operations on every path, so blocks are bit-identical across builds
+void negLogComplement(const double* uniforms, double* out, int n);
+
+// A Philox4x32 stream read through refillable blocks: VARIATE_BLOCK raw
+// words and VARIATE_BLOCK unit exponentials are generated at a time by
+// vectorized kernels, so a draw is usually a single array read. Words and
+// exponentials come from the same counter sequence in refill order, which
+// depends only on the draws made, so a stream stays fixed by (seed, stream).
+// An antithetic stream complements every word, so each uniform u becomes
+// 1 - u (less 2^-53) and each exponential its mirror quantile.
+class VariateStream {
+private:
+    Philox4x32 generator_;
+    std::uint32_t flip_; // XORed into every word: 0, or all ones if antithetic
+    int wordIndex_;
+    int exponentialIndex_;
+    std::uint32_t words_[VARIATE_BLOCK];
+    double exponentials_[VARIATE_BLOCK];
+
+    void refillWords();
+    void refillExponentials();
+
+public:
+    using result_type = std::uint32_t;
+
+    explicit VariateStream(std::uint64_t seed = 0, std::uint64_t stream = 0, bool antithetic = false);
+
+    // Restart at the beginning of the given stream (antithetic or not as before)
+    void seed(std::uint64_t seed, std::uint64_t stream);
+    bool isAntithetic() const;
+
+    // Write the generator and the unread part of each block to a snapshot
+    // (a stream read back continues with exactly the same variates)
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+
+    // Next 32 random bits
+    result_type operator()() {
+        if (wordIndex_ == VARIATE_BLOCK) {
+            refillWords();
+        }
+        return words_[wordIndex_++];
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+    // Uniform double in [0, 1) with 53 random bits (two words)
+    double uniform() {
+        std::uint64_t hi = (*this)() >> 5;
+        std::uint64_t lo = (*this)() >> 6;
+        return static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+    }
+
+    // Exponential variate with the given rate
+    double exponential(double rate) {
+        if (exponentialIndex_ == VARIATE_BLOCK) {
+            refillExponentials();
+        }
+        return exponentials_[exponentialIndex_++] / rate;
+    }
+};
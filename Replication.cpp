@@ -0,0 +1,278 @@
+#include "Replication.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// Print "mean +/- half-width" for one metric
+void printMetric(const char* label, const MetricSummary& metric, double scale = 1.0) {
+    std::cout << label << metric.mean * scale
+        << " +/- " << metric.halfWidth * scale << "\n";
+}
+
+// One value per observation: each replication's, or each antithetic pair's mean
+std::vector<double> observations(std::vector<double> values, bool antitheticPairs) {
+    if (!antitheticPairs) {
+        return values;
+    }
+    std::vector<double> means;
+    means.reserve(values.size() / 2);
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+        means.push_back(0.5 * (values[i] + values[i + 1]));
+    }
+    return means;
+}
+
+// Base, alternative and paired difference of one metric
+template <typename Metric>
+MetricDifference compareMetric(const std::vector<SimulationResults>& base,
+    const std::vector<SimulationResults>& alternative, bool antitheticPairs, Metric metric) {
+    std::vector<double> a;
+    std::vector<double> b;
+    std::vector<double> delta;
+    for (std::size_t r = 0; r < base.size() && r < alternative.size(); ++r) {
+        a.push_back(static_cast<double>(metric(base[r])));
+        b.push_back(static_cast<double>(metric(alternative[r])));
+        delta.push_back(b.back() - a.back());
+    }
+    MetricDifference result;
+    result.base = summarizeMetric(observations(a, antitheticPairs));
+    result.alternative = summarizeMetric(observations(b, antitheticPairs));
+    result.difference = summarizeMetric(observations(delta, antitheticPairs));
+
+    // Welch-Satterthwaite degrees of freedom for two independent samples
+    int n = result.difference.count;
+    double va = result.base.stddev * result.base.stddev / std::max(1, n);
+    double vb = result.alternative.stddev * result.alternative.stddev / std::max(1, n);
+    if (n > 1 && va + vb > 0.0) {
+        double df = (va + vb) * (va + vb) / ((va * va + vb * vb) / (n - 1));
+        result.independentHalfWidth = studentT975(static_cast<int>(df)) * std::sqrt(va + vb);
+    }
+    return result;
+}
+
+// Print one line of a ReplicationComparison
+void printDifference(const char* label, const MetricDifference& metric, double scale = 1.0) {
+    std::cout << label << metric.base.mean * scale << " -> " << metric.alternative.mean * scale
+        << ", difference " << metric.difference.mean * scale
+        << " +/- " << metric.difference.halfWidth * scale
+        << " (independent: +/- " << metric.independentHalfWidth * scale;
+    if (metric.difference.halfWidth > 0.0) {
+        double ratio = metric.independentHalfWidth / metric.difference.halfWidth;
+        std::cout << ", " << ratio * ratio << "x the replications";
+    }
+    std::cout << ")\n";
+}
+
+} // namespace
+
+// Sample mean, standard deviation and 95% CI half-width of the values
+MetricSummary summarizeMetric(const std::vector<double>& values) {
+    MetricSummary summary;
+    summary.count = static_cast<int>(values.size());
+    if (values.empty()) {
+        return summary;
+    }
+
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    summary.mean = sum / values.size();
+
+    if (values.size() > 1) {
+        double squares = 0.0;
+        for (double v : values) {
+            squares += (v - summary.mean) * (v - summary.mean);
+        }
+        summary.stddev = std::sqrt(squares / (values.size() - 1));
+        summary.halfWidth = studentT975(summary.count - 1)
+            * summary.stddev / std::sqrt(static_cast<double>(values.size()));
+    }
+    return summary;
+}
+
+//------------------------------------------------------------------------------
+// ReplicationRunner class
+//------------------------------------------------------------------------------
+ReplicationRunner::ReplicationRunner(const SimulationConfig& config, int numThreads)
+    : config_(config),
+    numThreads_(numThreads),
+    snapshot_(nullptr)
+{
+    if (numThreads_ <= 0) {
+        numThreads_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    config_.traceLevel = TraceLevel::OFF;
+    config_.windowFile.clear(); // replications would overwrite each other's file
+    config_.eventLogFile.clear();
+}
+
+// Start every replication from this snapshot instead of an empty system
+void ReplicationRunner::setSnapshot(const MappedFile* snapshot) {
+    snapshot_ = snapshot;
+}
+
+// Run independent Controllers (trace forced off), one result per replication,
+// in replication order regardless of which thread ran it
+bool ReplicationRunner::run(int numReplications, std::vector<SimulationResults>& results, std::string& error) const {
+    results.assign(std::max(0, numReplications), SimulationResults());
+    std::vector<std::string> errors(results.size());
+    std::atomic<int> next(0);
+    std::atomic<bool> failed(false);
+
+    // Each worker claims the next replication index; Controllers share nothing
+    auto worker = [this, &results, &errors, &next, &failed, numReplications]() {
+        for (int r = next++; r < numReplications && !failed; r = next++) {
+            SimulationConfig config = config_;
+            config.seed = replicationSeed(config_.seed, config_.antithetic ? r / 2 : r);
+            config.antithetic = config_.antithetic && (r & 1) != 0;
+            std::string& message = errors[r];
+            bool ok = withController(config, [this, &results, &message, r](auto& controller) {
+                if (!controller.getSetupError().empty()) {
+                    message = controller.getSetupError();
+                    return false;
+                }
+                if (snapshot_) {
+                    if (!controller.restoreSnapshot(snapshot_->data(), snapshot_->size(), message)) {
+                        return false;
+                    }
+                }
+                else {
+                    controller.initRequests();
+                }
+                controller.work();
+                results[r] = controller.getResults();
+                return true;
+            });
+            if (!ok) {
+                failed = true;
+            }
+        }
+    };
+
+    int threads = std::min(numThreads_, std::max(1, numReplications));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (std::size_t r = 0; r < errors.size(); ++r) {
+        if (!errors[r].empty()) {
+            error = "replication " + std::to_string(r) + ": " + errors[r];
+            return false;
+        }
+    }
+    return true;
+}
+
+// Merge per-replication results into means and 95% CIs
+ReplicationSummary ReplicationRunner::summarize(const std::vector<SimulationResults>& results,
+    bool antitheticPairs) {
+    ReplicationSummary summary;
+    summary.replications = static_cast<int>(results.size());
+    summary.antitheticPairs = antitheticPairs;
+
+    // Collect one column of values and summarize it
+    auto column = [&results, antitheticPairs](auto metric) {
+        std::vector<double> values;
+        values.reserve(results.size());
+        for (const auto& r : results) {
+            values.push_back(static_cast<double>(metric(r)));
+        }
+        return summarizeMetric(observations(std::move(values), antitheticPairs));
+    };
+
+    summary.generatedRequests = column([](const SimulationResults& r) { return r.generatedRequests; });
+    summary.servedRequests = column([](const SimulationResults& r) { return r.servedRequests; });
+    summary.rejectedRequests = column([](const SimulationResults& r) { return r.rejectedRequests; });
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        summary.rejectedByPriority[p] = column([p](const SimulationResults& r) { return r.rejectedByPriority[p]; });
+        for (const auto& r : results) {
+            summary.latency[p].merge(r.latency[p]);
+        }
+    }
+    summary.rejectionRate = column([](const SimulationResults& r) { return r.rejectionRate(); });
+    summary.averageWaitTime = column([](const SimulationResults& r) { return r.averageWaitTime; });
+    summary.meanUtilization = column([](const SimulationResults& r) { return r.meanUtilization(); });
+    summary.simulationTime = column([](const SimulationResults& r) { return r.simulationTime; });
+    summary.peakUtilization = column([](const SimulationResults& r) { return r.peakUtilization; });
+    summary.peakRejectionRate = column([](const SimulationResults& r) { return r.peakRejectionRate; });
+
+    std::size_t devices = results.empty() ? 0 : results.front().deviceUtilization.size();
+    for (std::size_t d = 0; d < devices; ++d) {
+        summary.deviceUtilization.push_back(
+            column([d](const SimulationResults& r) { return r.deviceUtilization[d]; }));
+    }
+    return summary;
+}
+
+int ReplicationRunner::getNumThreads() const {
+    return numThreads_;
+}
+
+// Print a ReplicationSummary in the layout of Controller::printStatistics
+void printReplicationSummary(const ReplicationSummary& summary) {
+    std::cout << "\n--- Statistics over " << summary.replications
+        << (summary.antitheticPairs ? " replications in antithetic pairs" : " replications")
+        << " (mean +/- 95% CI) ---\n";
+    printMetric("Total requests generated:  ", summary.generatedRequests);
+    printMetric("Total requests served:     ", summary.servedRequests);
+    printMetric("Total rejected requests:   ", summary.rejectedRequests);
+
+    printMetric("Rejected Corporate: ", summary.rejectedByPriority[static_cast<int>(Priority::CORPORATE)]);
+    printMetric("Rejected Premium:   ", summary.rejectedByPriority[static_cast<int>(Priority::PREMIUM)]);
+    printMetric("Rejected Free:      ", summary.rejectedByPriority[static_cast<int>(Priority::FREE)]);
+    printMetric("Rejection rate (%): ", summary.rejectionRate, 100.0);
+
+    printMetric("Average waiting time (min): ", summary.averageWaitTime, 60.0);
+    printLatencyStatistics(summary.latency);
+
+    std::cout << "\nDevices utilization (%):\n";
+    for (std::size_t d = 0; d < summary.deviceUtilization.size(); ++d) {
+        std::cout << "  Device " << (d + 1) << ": ";
+        printMetric("", summary.deviceUtilization[d], 100.0);
+    }
+    printMetric("  Mean:     ", summary.meanUtilization, 100.0);
+    printMetric("  Peak window:          ", summary.peakUtilization, 100.0);
+    printMetric("Peak-window rejection (%): ", summary.peakRejectionRate, 100.0);
+
+    printMetric("\nTotal simulation time (hours): ", summary.simulationTime);
+}
+
+// Pair base[r] with alternative[r]
+ReplicationComparison compareReplications(const std::vector<SimulationResults>& base,
+    const std::vector<SimulationResults>& alternative, bool antitheticPairs) {
+    ReplicationComparison comparison;
+    comparison.replications = static_cast<int>(std::min(base.size(), alternative.size()));
+    comparison.antitheticPairs = antitheticPairs;
+    comparison.rejectionRate = compareMetric(base, alternative, antitheticPairs,
+        [](const SimulationResults& r) { return r.rejectionRate(); });
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        comparison.rejectedByPriority[p] = compareMetric(base, alternative, antitheticPairs,
+            [p](const SimulationResults& r) { return r.rejectedByPriority[p]; });
+    }
+    comparison.averageWaitTime = compareMetric(base, alternative, antitheticPairs,
+        [](const SimulationResults& r) { return r.averageWaitTime; });
+    comparison.meanUtilization = compareMetric(base, alternative, antitheticPairs,
+        [](const SimulationResults& r) { return r.meanUtilization(); });
+    return comparison;
+}
+
+// Print a ReplicationComparison, one line per metric
+void printReplicationComparison(const ReplicationComparison& comparison) {
+    std::cout << "\n--- Alternative vs base over " << comparison.replications
+        << (comparison.antitheticPairs ? " replications in antithetic pairs" : " replications")
+        << " (common random numbers, 95% CI) ---\n";
+    printDifference("Rejection rate (%): ", comparison.rejectionRate, 100.0);
+    printDifference("Rejected Corporate: ", comparison.rejectedByPriority[static_cast<int>(Priority::CORPORATE)]);
+    printDifference("Rejected Premium:   ", comparison.rejectedByPriority[static_cast<int>(Priority::PREMIUM)]);
+    printDifference("Rejected Free:      ", comparison.rejectedByPriority[static_cast<int>(Priority::FREE)]);
+    printDifference("Average waiting time (min): ", comparison.averageWaitTime, 60.0);
+    printDifference("Devices utilization (%): ", comparison.meanUtilization, 100.0);
+}
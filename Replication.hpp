@@ -0,0 +1,101 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+//------------------------------------------------------------------------------
+// Independent replications on a thread pool, merged into confidence intervals
+//------------------------------------------------------------------------------
+
+// Mean of one metric over replications with its 95% confidence half-width
+struct MetricSummary {
+    double mean = 0.0;
+    double stddev = 0.0;
+    double halfWidth = 0.0; // Student-t, 95%
+    int count = 0;
+};
+
+// Sample mean, standard deviation and 95% CI half-width of the values
+MetricSummary summarizeMetric(const std::vector<double>& values);
+
+// printStatistics-style metrics merged over all replications
+struct ReplicationSummary {
+    int replications = 0;
+    bool antitheticPairs = false; // each CI is over the means of the pairs
+    MetricSummary generatedRequests;
+    MetricSummary servedRequests;
+    MetricSummary rejectedRequests;
+    MetricSummary rejectedByPriority[PRIORITY_COUNT];
+    MetricSummary rejectionRate;
+    MetricSummary averageWaitTime;
+    MetricSummary meanUtilization;
+    MetricSummary simulationTime;
+    MetricSummary peakUtilization;
+    MetricSummary peakRejectionRate;
+    std::vector<MetricSummary> deviceUtilization;
+    LatencyStats latency[PRIORITY_COUNT]; // histograms pooled over replications
+};
+
+class ReplicationRunner {
+private:
+    SimulationConfig config_;
+    int numThreads_;
+    const MappedFile* snapshot_;
+
+public:
+    // numThreads = 0 uses every hardware thread
+    explicit ReplicationRunner(const SimulationConfig& config, int numThreads = 0);
+
+    // Start every replication from this snapshot instead of an empty system:
+    // with its own seed, each one is an independent fork of the saved state.
+    // The mapping must outlive run() and restore into the config (the caller
+    // checks that once); nullptr starts empty again.
+    void setSnapshot(const MappedFile* snapshot);
+
+    // Run independent Controllers (trace forced off), one result per replication,
+    // in replication order regardless of which thread ran it. Replication r
+    // uses replicationSeed(config.seed, r), so results do not depend on threads;
+    // with config.antithetic, replications 2i and 2i + 1 share
+    // replicationSeed(config.seed, i) and the odd one draws antithetic.
+    // False with "replication r: message" if a replication cannot be set up
+    // or restored; the runner then stops, and results must not be merged.
+    bool run(int numReplications, std::vector<SimulationResults>& results, std::string& error) const;
+
+    // Merge per-replication results into means and 95% CIs; with
+    // antitheticPairs, each pair counts as one observation (its mean)
+    static ReplicationSummary summarize(const std::vector<SimulationResults>& results,
+        bool antitheticPairs = false);
+
+    int getNumThreads() const;
+};
+
+// Print a ReplicationSummary in the layout of Controller::printStatistics
+void printReplicationSummary(const ReplicationSummary& summary);
+
+// One metric of two configs run on the same replication seeds: the paired
+// CI of the difference, and the half-width independent runs would give
+struct MetricDifference {
+    MetricSummary base;
+    MetricSummary alternative;
+    MetricSummary difference;          // alternative - base, per replication
+    double independentHalfWidth = 0.0; // Welch, from the two spreads alone
+};
+
+// Alternative minus base for the headline metrics of printStatistics
+struct ReplicationComparison {
+    int replications = 0;
+    bool antitheticPairs = false;
+    MetricDifference rejectionRate;
+    MetricDifference rejectedByPriority[PRIORITY_COUNT];
+    MetricDifference averageWaitTime;
+    MetricDifference meanUtilization;
+};
+
+// Pair base[r] with alternative[r]; both must come from runs with the same
+// seed and replication count (common random numbers make the pairs agree
+// on their workload, and the paired CI shrinks with the agreement)
+ReplicationComparison compareReplications(const std::vector<SimulationResults>& base,
+    const std::vector<SimulationResults>& alternative, bool antitheticPairs = false);
+
+// Print a ReplicationComparison, one line per metric
+void printReplicationComparison(const ReplicationComparison& comparison);
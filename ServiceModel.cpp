@@ -0,0 +1,296 @@
+#include "ServiceModel.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Parse "exponential", "erlang", "lognormal", "deterministic" or "empirical"
+bool parseServiceKind(const std::string& text, ServiceKind& kind) {
+    if (text == "exponential") {
+        kind = ServiceKind::EXPONENTIAL;
+    }
+    else if (text == "erlang") {
+        kind = ServiceKind::ERLANG;
+    }
+    else if (text == "lognormal") {
+        kind = ServiceKind::LOGNORMAL;
+    }
+    else if (text == "deterministic") {
+        kind = ServiceKind::DETERMINISTIC;
+    }
+    else if (text == "empirical") {
+        kind = ServiceKind::EMPIRICAL;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* serviceKindName(ServiceKind kind) {
+    switch (kind) {
+    case ServiceKind::EXPONENTIAL:   return "exponential";
+    case ServiceKind::ERLANG:        return "erlang";
+    case ServiceKind::LOGNORMAL:     return "lognormal";
+    case ServiceKind::DETERMINISTIC: return "deterministic";
+    case ServiceKind::EMPIRICAL:     return "empirical";
+    }
+    return "unknown";
+}
+
+// Exponential service times with the given mean
+ServiceSpec exponentialService(double meanHours) {
+    ServiceSpec spec;
+    spec.meanHours = meanHours;
+    return spec;
+}
+
+// Check a spec before it is turned into a ServiceModel
+bool validateServiceSpec(const ServiceSpec& spec, std::string& error) {
+    if (spec.kind != ServiceKind::EMPIRICAL && !(spec.meanHours > 0.0)) {
+        error = "the mean service time must be positive";
+        return false;
+    }
+    if (spec.kind == ServiceKind::ERLANG && (spec.erlangK < 1 || spec.erlangK > 1000)) {
+        error = "erlang_k must be between 1 and 1000";
+        return false;
+    }
+    if (spec.kind == ServiceKind::LOGNORMAL && !(spec.lognormalCv > 0.0)) {
+        error = "the lognormal cv must be positive";
+        return false;
+    }
+    if (spec.kind == ServiceKind::EMPIRICAL) {
+        if (spec.binWeights.empty() || spec.binEdges.size() != spec.binWeights.size() + 1) {
+            error = "an empirical histogram needs one more edge than weights";
+            return false;
+        }
+        double total = 0.0;
+        for (std::size_t i = 0; i < spec.binWeights.size(); ++i) {
+            if (spec.binWeights[i] < 0.0 || !(spec.binEdges[i + 1] > spec.binEdges[i])) {
+                error = "histogram weights must be non-negative and edges increasing";
+                return false;
+            }
+            total += spec.binWeights[i];
+        }
+        if (spec.binEdges.front() < 0.0 || !(total > 0.0)) {
+            error = "histogram edges must be non-negative and the weights not all zero";
+            return false;
+        }
+    }
+    if (spec.batchSize < 1 || spec.batchSize > 4096) {
+        error = "batch_size must be between 1 and 4096";
+        return false;
+    }
+    if (!(spec.batchExponent >= 0.0) || spec.batchWaitHours < 0.0) {
+        error = "batch_exponent and batch_wait_minutes must not be negative";
+        return false;
+    }
+    if (!spec.batchScale.empty()) {
+        if (static_cast<int>(spec.batchScale.size()) != spec.batchSize) {
+            error = "batch_scale needs one factor per batch size up to batch_size";
+            return false;
+        }
+        for (double factor : spec.batchScale) {
+            if (!(factor > 0.0)) {
+                error = "batch_scale factors must be positive";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// ServiceModel class
+//------------------------------------------------------------------------------
+ServiceModel::ServiceModel(const ServiceSpec& spec)
+    : kind_(spec.kind),
+    mean_(spec.meanHours),
+    rate_(1.0 / spec.meanHours),
+    erlangK_(spec.erlangK),
+    logMean_(0.0),
+    logSigma_(0.0),
+    batchWait_(spec.batchWaitHours)
+{
+    // Index 0 is unused, so a batch size indexes its factor directly
+    batchFactor_.assign(1, 0.0);
+    for (int b = 1; b <= std::max(1, spec.batchSize); ++b) {
+        batchFactor_.push_back(spec.batchScale.empty()
+            ? std::pow(static_cast<double>(b), spec.batchExponent) : spec.batchScale[b - 1]);
+    }
+
+    switch (kind_) {
+    case ServiceKind::ERLANG:
+        buildQuantileTable();
+        break;
+    case ServiceKind::LOGNORMAL:
+        logSigma_ = std::sqrt(std::log1p(spec.lognormalCv * spec.lognormalCv));
+        logMean_ = std::log(mean_) - 0.5 * logSigma_ * logSigma_;
+        buildQuantileTable();
+        break;
+    case ServiceKind::EMPIRICAL: {
+        double total = 0.0;
+        double weighted = 0.0;
+        for (std::size_t i = 0; i < spec.binWeights.size(); ++i) {
+            binStart_.push_back(spec.binEdges[i]);
+            binWidth_.push_back(spec.binEdges[i + 1] - spec.binEdges[i]);
+            total += spec.binWeights[i];
+            weighted += spec.binWeights[i] * 0.5 * (spec.binEdges[i] + spec.binEdges[i + 1]);
+        }
+        mean_ = weighted / total;
+        rate_ = 1.0 / mean_;
+        buildAliasTable(spec.binWeights);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// P(X > x) of an analytic kind
+double ServiceModel::survival(double x) const {
+    if (x <= 0.0) {
+        return 1.0;
+    }
+    if (kind_ == ServiceKind::LOGNORMAL) {
+        return 0.5 * std::erfc((std::log(x) - logMean_) / (logSigma_ * std::sqrt(2.0)));
+    }
+    // Erlang-k: sum_{n<k} e^-y y^n / n! with y in units of one phase. The terms
+    // are summed relative to the largest one, at n = min(k-1, floor(y)), so
+    // that y^n / n! cannot overflow for large k
+    double y = x * erlangK_ * rate_;
+    int mode = static_cast<int>(std::min(static_cast<double>(erlangK_ - 1), std::floor(y)));
+    double logPeak = mode * std::log(y) - y - std::lgamma(mode + 1.0);
+    double sum = 1.0;
+    double term = 1.0;
+    for (int n = mode; n > 0 && term > 1e-17 * sum; --n) {
+        term *= n / y;
+        sum += term;
+    }
+    term = 1.0;
+    for (int n = mode + 1; n < erlangK_ && term > 1e-17 * sum; ++n) {
+        term *= y / n;
+        sum += term;
+    }
+    return std::min(1.0, std::exp(logPeak + std::log(sum)));
+}
+
+// Exact quantile with P(X > x) = tail, by bisection
+double ServiceModel::invertSurvival(double tail) const {
+    double lo = 0.0;
+    double hi = mean_;
+    for (int i = 0; i < 2000 && survival(hi) > tail; ++i) {
+        lo = hi;
+        hi *= 2.0;
+    }
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * hi; ++i) {
+        double mid = 0.5 * (lo + hi);
+        if (survival(mid) > tail) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+void ServiceModel::buildQuantileTable() {
+    quantiles_.resize(SERVICE_TABLE_CELLS);
+    quantiles_[0] = 0.0;
+    for (int i = 1; i < SERVICE_TABLE_CELLS; ++i) {
+        quantiles_[i] = invertSurvival(1.0 - static_cast<double>(i) / SERVICE_TABLE_CELLS);
+    }
+}
+
+// Vose's alias method: bin i is kept with aliasProb_[i], else alias_[i]
+void ServiceModel::buildAliasTable(const std::vector<double>& weights) {
+    const int n = static_cast<int>(weights.size());
+    double total = 0.0;
+    for (double w : weights) {
+        total += w;
+    }
+    std::vector<double> scaled(n);
+    std::vector<int> small;
+    std::vector<int> large;
+    for (int i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    aliasProb_.assign(n, 1.0);
+    alias_.resize(n);
+    for (int i = 0; i < n; ++i) {
+        alias_[i] = i;
+    }
+    while (!small.empty() && !large.empty()) {
+        int s = small.back();
+        small.pop_back();
+        int l = large.back();
+        aliasProb_[s] = scaled[s];
+        alias_[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Whatever is left has scaled weight 1 up to rounding and keeps its bin
+}
+
+// Next service time in hours
+double ServiceModel::sample(VariateStream& rng) const {
+    switch (kind_) {
+    case ServiceKind::EXPONENTIAL:
+        return rng.exponential(rate_);
+    case ServiceKind::DETERMINISTIC:
+        return mean_;
+    default:
+        return quantile(rng.uniform());
+    }
+}
+
+// Service time of the uniform u in [0, 1), by inverse transform
+double ServiceModel::quantile(double u) const {
+    switch (kind_) {
+    case ServiceKind::EXPONENTIAL:
+        return -std::log1p(-u) * mean_;
+    case ServiceKind::DETERMINISTIC:
+        return mean_;
+    case ServiceKind::EMPIRICAL: {
+        // The integer part picks the column and the fraction decides bin or
+        // alias; rescaled, the fraction is again uniform and places the
+        // sample inside the bin, so one uniform does both
+        double scaled = u * static_cast<double>(aliasProb_.size());
+        int column = static_cast<int>(scaled);
+        double frac = scaled - column;
+        double keep = aliasProb_[column];
+        if (frac < keep) {
+            return binStart_[column] + binWidth_[column] * (frac / keep);
+        }
+        int bin = alias_[column];
+        return binStart_[bin] + binWidth_[bin] * ((frac - keep) / (1.0 - keep));
+    }
+    default: {
+        double scaled = u * SERVICE_TABLE_CELLS;
+        int cell = static_cast<int>(scaled);
+        if (cell >= SERVICE_TABLE_CELLS - 1) {
+            return invertSurvival(1.0 - u); // unbounded last cell, 1 draw in 4096
+        }
+        double frac = scaled - cell;
+        return quantiles_[cell] + frac * (quantiles_[cell + 1] - quantiles_[cell]);
+    }
+    }
+}
+
+ServiceKind ServiceModel::getKind() const {
+    return kind_;
+}
+
+// Mean service time in hours (of a single request)
+double ServiceModel::getMean() const {
+    return mean_;
+}
+
+// Longest a device holds a partial batch for more requests, hours
+double ServiceModel::getBatchWait() const {
+    return batchWait_;
+}
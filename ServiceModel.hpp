@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Random.hpp"
+
+//------------------------------------------------------------------------------
+// Service-time distributions with precomputed samplers
+//------------------------------------------------------------------------------
+
+// Cells of an inverse-CDF table; the quantile is interpolated linearly
+// inside each cell, except in the last one, which is inverted exactly
+static const int SERVICE_TABLE_CELLS = 4096;
+
+enum class ServiceKind {
+    EXPONENTIAL,
+    ERLANG,        // sum of erlangK exponential phases
+    LOGNORMAL,
+    DETERMINISTIC,
+    EMPIRICAL      // piecewise-uniform density of a histogram
+};
+
+// Parse "exponential", "erlang", "lognormal", "deterministic" or "empirical"
+bool parseServiceKind(const std::string& text, ServiceKind& kind);
+
+const char* serviceKindName(ServiceKind kind);
+
+// Parameters of one service-time distribution (hours)
+struct ServiceSpec {
+    ServiceKind kind = ServiceKind::EXPONENTIAL;
+    double meanHours = 1.0;        // every kind but EMPIRICAL
+    int erlangK = 2;
+    double lognormalCv = 1.0;      // standard deviation / mean
+    std::vector<double> binEdges;  // EMPIRICAL: n + 1 increasing edges
+    std::vector<double> binWeights; // EMPIRICAL: n non-negative weights
+    // Batching: a device serves up to batchSize requests together, in one
+    // draw of the distribution above times the factor of the batch size
+    int batchSize = 1;
+    double batchExponent = 0.5;     // factor of a batch of b: b^batchExponent ...
+    std::vector<double> batchScale; // ... or batchScale[b - 1] (measured), b = 1..batchSize
+    double batchWaitHours = 0.0;    // longest hold of a partial batch; 0: start at once
+};
+
+// Exponential service times with the given mean
+ServiceSpec exponentialService(double meanHours);
+
+// Check a spec before it is turned into a ServiceModel
+bool validateServiceSpec(const ServiceSpec& spec, std::string& error);
+
+// A sampler built once per device class and shared by its devices.
+// Exponential keeps the exact inverse transform; Erlang-k and lognormal
+// read an inverse-CDF table (one uniform, one multiply-add, no log or
+// exp); empirical histograms pick a bin through a Walker alias table.
+class ServiceModel {
+private:
+    ServiceKind kind_;
+    double mean_;
+    double rate_;                     // 1 / mean_
+    int erlangK_;
+    double logMean_;                  // lognormal location (mu)
+    double logSigma_;                 // lognormal shape (sigma)
+    std::vector<double> quantiles_;   // quantile at i / SERVICE_TABLE_CELLS
+    std::vector<double> aliasProb_;   // EMPIRICAL: probability of keeping the bin
+    std::vector<int> alias_;          // EMPIRICAL: the other bin
+    std::vector<double> binStart_;
+    std::vector<double> binWidth_;
+    std::vector<double> batchFactor_; // by batch size, 1..batchSize
+    double batchWait_;
+
+    // P(X > x) of an analytic kind
+    double survival(double x) const;
+    // Exact quantile with P(X > x) = tail, by bisection
+    double invertSurvival(double tail) const;
+
+    void buildQuantileTable();
+    void buildAliasTable(const std::vector<double>& weights);
+
+public:
+    explicit ServiceModel(const ServiceSpec& spec);
+
+    // Next service time in hours
+    double sample(VariateStream& rng) const;
+    // Service time of the uniform u in [0, 1), by inverse transform: equal
+    // u give equal demands, and sample() draws the same way except for the
+    // exponential kind, which reads the stream's ready-made exponentials
+    double quantile(double u) const;
+
+    ServiceKind getKind() const;
+    // Mean service time in hours (of a single request)
+    double getMean() const;
+
+    // Most requests served together (1: no batching)
+    int getBatchLimit() const { return static_cast<int>(batchFactor_.size()) - 1; }
+    // Factor on the service time of a batch of `size` (1 for a single request)
+    double getBatchFactor(int size) const { return batchFactor_[size]; }
+    // Longest a device holds a partial batch for more requests, hours
+    double getBatchWait() const;
+};
@@ -0,0 +1,433 @@
+#include "Sharded.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Per-device lines in printShardedResults above this many devices become a summary
+const int MAX_LISTED_DEVICES = 64;
+
+// First item of part `index` when `total` items are split into `parts`
+// (the first total % parts parts get one more)
+int shareStart(int total, int parts, int index) {
+    return index * (total / parts) + std::min(index, total % parts);
+}
+
+int evenShare(int total, int parts, int index) {
+    return shareStart(total, parts, index + 1) - shareStart(total, parts, index);
+}
+
+// Device classes of the global devices [first, first + count), merged runs
+std::vector<DeviceClass> sliceDeviceClasses(const SimulationConfig& config, int first, int count) {
+    std::vector<DeviceClass> slice;
+    int lastClass = -1;
+    for (int i = first; i < first + count && !config.deviceClasses.empty(); ++i) {
+        int c = config.deviceClassOf(i);
+        if (c == lastClass) {
+            slice.back().count++;
+            continue;
+        }
+        slice.push_back(config.deviceClasses[c]);
+        slice.back().count = 1;
+        lastClass = c;
+    }
+    return slice;
+}
+
+// Reusable barrier for a fixed number of threads
+class ShardBarrier {
+private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    int parties_;
+    int waiting_;
+    long long generation_;
+
+public:
+    explicit ShardBarrier(int parties)
+        : parties_(parties),
+        waiting_(0),
+        generation_(0)
+    {
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        long long generation = generation_;
+        if (++waiting_ == parties_) {
+            waiting_ = 0;
+            generation_++;
+            released_.notify_all();
+            return;
+        }
+        released_.wait(lock, [this, generation]() { return generation_ != generation; });
+    }
+};
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// ShardedSimulation class
+//------------------------------------------------------------------------------
+ShardedSimulation::ShardedSimulation(const SimulationConfig& config, int numShards, double windowHours)
+    : config_(config),
+    numShards_(std::max(1, std::min(numShards, config.numDevices))),
+    windowHours_(windowHours),
+    windowCount_(0),
+    stolenRequests_(0),
+    trimmedRequests_(0),
+    generatedSeen_()
+{
+    if (config.bufferPolicy.kind != BufferPolicyKind::PRIORITY) {
+        setupError_ = std::string("Shards need the priority buffer policy, not ")
+            + bufferPolicyKindName(config.bufferPolicy.kind);
+    }
+    else if (config.abandons()) {
+        setupError_ = "Shards do not support [patience] or [retry]";
+    }
+    else if (!config.replayFile.empty()) {
+        setupError_ = "A replayed trace cannot be split over shards";
+    }
+    if (!setupError_.empty()) {
+        return;
+    }
+
+    if (windowHours_ <= 0.0) {
+        double shortest = ServiceModel(DeviceClass().service).getMean();
+        if (!config.deviceClasses.empty()) {
+            shortest = std::numeric_limits<double>::infinity();
+            for (const DeviceClass& deviceClass : config.deviceClasses) {
+                shortest = std::min(shortest, ServiceModel(deviceClass.service).getMean());
+            }
+        }
+        windowHours_ = shortest / (4.0 * config.numDevices);
+    }
+
+    // Split the request limit in proportion to the sources of each shard
+    const int counts[PRIORITY_COUNT] = { config.numCorporate, config.numPremium, config.numFree };
+    const long long totalSources = static_cast<long long>(counts[0]) + counts[1] + counts[2];
+    long long sourcesBefore = 0;
+
+    for (int s = 0; s < numShards_; ++s) {
+        SimulationConfig shard = config;
+        shard.seed = shardSeed(config.seed, s);
+        shard.traceLevel = TraceLevel::OFF;
+        shard.windowFile.clear();
+        shard.eventLogFile.clear();
+        shard.targetPrecision = 0.0;
+
+        shard.numCorporate = evenShare(counts[0], numShards_, s);
+        shard.numPremium = evenShare(counts[1], numShards_, s);
+        shard.numFree = evenShare(counts[2], numShards_, s);
+        long long sources = static_cast<long long>(shard.numCorporate) + shard.numPremium + shard.numFree;
+        if (totalSources > 0) {
+            shard.maxRequests = static_cast<int>(config.maxRequests * (sourcesBefore + sources) / totalSources
+                - config.maxRequests * sourcesBefore / totalSources);
+        }
+        sourcesBefore += sources;
+
+        int firstDevice = shareStart(config.numDevices, numShards_, s);
+        shard.numDevices = evenShare(config.numDevices, numShards_, s);
+        shard.deviceClasses = sliceDeviceClasses(config, firstDevice, shard.numDevices);
+        shard.bufferCapacity = config.bufferCapacity; // shared, trimmed at the barriers
+
+        shards_.push_back(std::make_unique<Controller>(shard));
+        if (setupError_.empty()) {
+            setupError_ = shards_.back()->getSetupError();
+        }
+    }
+}
+
+// Shard other than `except` with the most requests of priority level
+// waiting (-1: none waits)
+int ShardedSimulation::mostWaiting(int level, int except) const {
+    int shard = -1;
+    int most = 0;
+    for (int s = 0; s < numShards_; ++s) {
+        int waiting = shards_[s]->getBuffer().size(static_cast<Priority>(level));
+        if (s != except && waiting > most) {
+            most = waiting;
+            shard = s;
+        }
+    }
+    return shard;
+}
+
+// Let idle devices take the highest priorities waiting at time now, evict
+// what exceeds the shared capacity, then level each priority
+long long ShardedSimulation::rebalance(double now) {
+    long long moved = 0;
+    // Serve the priorities in order, as one buffer would: at each level
+    // the idle devices of every shard take their own shard's requests,
+    // then steal the ones other shards could not start
+    for (int level = 0; level < PRIORITY_COUNT; ++level) {
+        for (auto& shard : shards_) {
+            shard->setDispatchLevel(level, config_.numDevices, now);
+        }
+        for (int t = 0; t < numShards_; ++t) {
+            Controller& thief = *shards_[t];
+            for (int victim = mostWaiting(level, t); victim >= 0 && thief.getIdleDeviceCount() > 0;
+                victim = mostWaiting(level, t)) {
+                int got = thief.stealRequests(*shards_[victim], 1, now, level);
+                if (got == 0) {
+                    break;
+                }
+                moved += got;
+            }
+        }
+    }
+
+    // One shared buffer, once full, turns away an arrival of its lowest
+    // waiting priority and evicts the oldest of that priority for a higher
+    // one; the excess is split between the two by the window's arrivals
+    int buffered = 0;
+    std::int64_t arrivals[PRIORITY_COUNT] = {};
+    for (auto& shard : shards_) {
+        buffered += shard->getBuffer().size();
+        MetricsSnapshot metrics = shard->getMetrics().snapshot();
+        for (int p = 0; p < PRIORITY_COUNT; ++p) {
+            arrivals[p] += metrics.byPriority[p].generated;
+        }
+    }
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        std::swap(arrivals[p], generatedSeen_[p]);
+        arrivals[p] = generatedSeen_[p] - arrivals[p];
+    }
+    int excess = buffered - config_.bufferCapacity;
+    for (int k = 0; k < excess; ++k) {
+        int level = PRIORITY_COUNT - 1;
+        while (mostWaiting(level, -1) < 0) {
+            level--;
+        }
+        std::int64_t lower = arrivals[level];
+        std::int64_t higher = 0;
+        for (int p = 0; p < level; ++p) {
+            higher += arrivals[p];
+        }
+        // Turn away the newest while that keeps the share of the lowest
+        // priority's arrivals among the losses, else evict the oldest
+        Priority priority = static_cast<Priority>(level);
+        bool turnAway = k * (lower + higher) < excess * lower
+            || lower + higher == 0;
+        int shard = -1;
+        double chosen = 0.0;
+        for (int s = 0; s < numShards_; ++s) {
+            const Buffer& buffer = shards_[s]->getBuffer();
+            RequestHandle req = turnAway ? buffer.newest(priority) : buffer.oldest(priority);
+            if (req == INVALID_REQUEST) {
+                continue;
+            }
+            double entered = shards_[s]->getRequestPool()[req].getBufferEnterTime();
+            if (shard < 0 || (turnAway ? entered > chosen : entered < chosen)) {
+                shard = s;
+                chosen = entered;
+            }
+        }
+        if (turnAway) {
+            shards_[shard]->getBuffer().rejectNewest(priority);
+        }
+        else {
+            // Shards run without retries, so the evicted request is retired
+            Controller& owner = *shards_[shard];
+            owner.getRequestPool().release(owner.getBuffer().evictOldest(priority, now));
+        }
+        trimmedRequests_++;
+    }
+
+    // Then level each priority, so every shard serves about the same mix
+    // through the next window as the shared buffer would
+    for (int level = 0; level < PRIORITY_COUNT; ++level) {
+        Priority priority = static_cast<Priority>(level);
+        for (;;) {
+            int longest = 0;
+            int shortest = 0;
+            for (int s = 1; s < numShards_; ++s) {
+                if (shards_[s]->getBuffer().size(priority) > shards_[longest]->getBuffer().size(priority)) {
+                    longest = s;
+                }
+                if (shards_[s]->getBuffer().size(priority) < shards_[shortest]->getBuffer().size(priority)) {
+                    shortest = s;
+                }
+            }
+            int count = (shards_[longest]->getBuffer().size(priority) - shards_[shortest]->getBuffer().size(priority)) / 2;
+            if (count <= 0) {
+                break;
+            }
+            int got = shards_[shortest]->stealRequests(*shards_[longest], count, now, level, true);
+            if (got == 0) {
+                break;
+            }
+            moved += got;
+        }
+    }
+
+    // Through the next window a device freed in one shard should not start
+    // a lower priority than one waiting in another: it stays idle for the
+    // next barrier instead, as the shared buffer would have served that
+    // one. Each shard keeps its share of the devices those requests need.
+    for (int t = 0; t < numShards_; ++t) {
+        int level = PRIORITY_COUNT - 1;
+        int waiting = 0;
+        for (int s = 0; s < numShards_; ++s) {
+            for (int p = 0; p <= level && s != t; ++p) {
+                int count = shards_[s]->getBuffer().size(static_cast<Priority>(p));
+                if (count > 0) {
+                    waiting = (p < level) ? count : waiting + count;
+                    level = p;
+                    break;
+                }
+            }
+        }
+        int holds = (numShards_ > 1) ? (waiting + numShards_ - 2) / (numShards_ - 1) : 0;
+        shards_[t]->setDispatchLevel(level, holds, now);
+    }
+    return moved;
+}
+
+// Run all shards to the end and merge their results
+SimulationResults ShardedSimulation::run() {
+    if (!setupError_.empty()) {
+        return SimulationResults();
+    }
+    const double never = std::numeric_limits<double>::infinity();
+    std::vector<double> nextEvent(numShards_, 0.0);
+    for (auto& shard : shards_) {
+        shard->initRequests();
+    }
+
+    ShardBarrier barrier(numShards_);
+    double windowEnd = windowHours_;
+    bool done = false;
+
+    // Shard s > 0 steps its Controller between the main thread's barriers
+    auto worker = [&](int s) {
+        for (;;) {
+            barrier.wait();
+            if (done) {
+                return;
+            }
+            nextEvent[s] = shards_[s]->workUntil(windowEnd);
+            barrier.wait();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int s = 1; s < numShards_; ++s) {
+        pool.emplace_back(worker, s);
+    }
+
+    for (;;) {
+        barrier.wait();
+        nextEvent[0] = shards_[0]->workUntil(windowEnd);
+        barrier.wait();
+        windowCount_++;
+
+        // Every shard is paused at windowEnd: move work to idle devices
+        long long moved = rebalance(windowEnd);
+        stolenRequests_ += moved;
+
+        double earliest = (moved > 0) ? windowEnd : *std::min_element(nextEvent.begin(), nextEvent.end());
+        if (earliest == never) {
+            done = true;
+            barrier.wait();
+            break;
+        }
+        // Skip windows in which no shard has anything to do
+        windowEnd = std::max(windowEnd, earliest) + windowHours_;
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    // Merge: counts add up, devices keep their global order
+    SimulationResults merged;
+    double totalWait = 0.0;
+    for (auto& shard : shards_) {
+        SimulationResults part = shard->getResults();
+        merged.generatedRequests += part.generatedRequests;
+        merged.servedRequests += part.servedRequests;
+        merged.rejectedRequests += part.rejectedRequests;
+        for (int p = 0; p < PRIORITY_COUNT; ++p) {
+            merged.rejectedByPriority[p] += part.rejectedByPriority[p];
+            merged.latency[p].merge(part.latency[p]);
+        }
+        totalWait += part.averageWaitTime * part.servedRequests;
+        merged.simulationTime = std::max(merged.simulationTime, part.simulationTime);
+        merged.deviceBusyTime.insert(merged.deviceBusyTime.end(),
+            part.deviceBusyTime.begin(), part.deviceBusyTime.end());
+    }
+    merged.averageWaitTime = (merged.servedRequests > 0) ? totalWait / merged.servedRequests : 0.0;
+    for (double busyTime : merged.deviceBusyTime) {
+        merged.deviceUtilization.push_back(
+            (merged.simulationTime > 0.0) ? (busyTime / merged.simulationTime) : 0.0);
+    }
+    return merged;
+}
+
+// Why the config cannot be sharded (empty if it can)
+const std::string& ShardedSimulation::getSetupError() const {
+    return setupError_;
+}
+
+int ShardedSimulation::getNumShards() const {
+    return numShards_;
+}
+
+double ShardedSimulation::getWindowHours() const {
+    return windowHours_;
+}
+
+// Barrier windows processed by run()
+long long ShardedSimulation::getWindowCount() const {
+    return windowCount_;
+}
+
+// Requests moved between shards by run()
+long long ShardedSimulation::getStolenRequests() const {
+    return stolenRequests_;
+}
+
+// Requests turned away or evicted at the barriers to fit the shared capacity
+long long ShardedSimulation::getTrimmedRequests() const {
+    return trimmedRequests_;
+}
+
+// Print the merged results of a sharded run in the layout of printStatistics
+void printShardedResults(const SimulationResults& results, const ShardedSimulation& simulation) {
+    std::cout << "\n--- Final statistics (" << simulation.getNumShards() << " shards, "
+        << simulation.getWindowHours() * 60.0 << " min windows) ---\n";
+    std::cout << "Total requests generated:  " << results.generatedRequests << "\n";
+    std::cout << "Total requests served:     " << results.servedRequests << "\n";
+    std::cout << "Total rejected requests:   " << results.rejectedRequests << "\n";
+
+    std::cout << "Rejected Corporate: " << results.rejectedByPriority[static_cast<int>(Priority::CORPORATE)] << "\n";
+    std::cout << "Rejected Premium:   " << results.rejectedByPriority[static_cast<int>(Priority::PREMIUM)] << "\n";
+    std::cout << "Rejected Free:      " << results.rejectedByPriority[static_cast<int>(Priority::FREE)] << "\n";
+
+    std::cout << "Average waiting time (hours): " << results.averageWaitTime
+        << " (~" << (results.averageWaitTime * 60.0) << " min)\n";
+    printLatencyStatistics(results.latency);
+
+    std::cout << "\nDevices utilization:\n";
+    const std::vector<double>& utilization = results.deviceUtilization;
+    if (static_cast<int>(utilization.size()) <= MAX_LISTED_DEVICES) {
+        for (std::size_t d = 0; d < utilization.size(); ++d) {
+            std::cout << "  Device " << (d + 1) << ": busy " << results.deviceBusyTime[d]
+                << " h, load " << (utilization[d] * 100.0) << " %\n";
+        }
+    }
+    else {
+        auto range = std::minmax_element(utilization.begin(), utilization.end());
+        std::cout << "  " << utilization.size() << " devices: mean load "
+            << (results.meanUtilization() * 100.0) << " %, min " << (*range.first * 100.0)
+            << " %, max " << (*range.second * 100.0) << " %\n";
+    }
+
+    std::cout << "\nShards: " << simulation.getWindowCount() << " windows, "
+        << simulation.getStolenRequests() << " requests stolen, "
+        << simulation.getTrimmedRequests() << " dropped to fit the shared buffer\n";
+    std::cout << "\nTotal simulation time: " << results.simulationTime << " hours\n";
+}
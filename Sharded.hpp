@@ -0,0 +1,82 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+//------------------------------------------------------------------------------
+// One large system split into shards that run on parallel threads
+//------------------------------------------------------------------------------
+
+// Sources, devices and the request limit are split evenly over the
+// shards. Each shard is a Controller with its own event queue, buffer and
+// random streams (shardSeed), stepped by its own thread. The shards advance
+// in lock-step windows. The buffer capacity is shared: each shard's buffer
+// may fill all of it, so within a window an arrival is only turned away
+// when its shard alone holds the whole capacity. At the barrier that ends
+// a window:
+// - the priorities are served in order: at each level the idle devices of
+//   every shard start their own requests of it, then steal the ones other
+//   shards could not start;
+// - while the shards together hold more than the capacity, the lowest
+//   waiting priority loses its newest (turned away) or its oldest (evicted)
+//   request, in the shares of that priority's and the higher priorities'
+//   arrivals in the window, as one full buffer would have;
+// - each priority is levelled over the shards (moving the newest), so each
+//   serves about the mix of the shared buffer through the next window;
+// - each shard may keep its share of idle devices through the next window
+//   rather than start a lower priority than one waiting in another shard,
+//   which the barrier then moves to it.
+// A device freed inside a window thus claims a higher request of another
+// shard one barrier later, which the default window keeps well below the
+// time between departures, so waits as well as rejections follow the
+// sequential engine (see the README). The shards are default Controllers
+// and move requests without their timers, so a config with another buffer
+// policy, [patience], [retry] or a replayed trace is refused
+// (getSetupError).
+
+class ShardedSimulation {
+private:
+    SimulationConfig config_;
+    int numShards_;
+    double windowHours_;
+    std::vector<std::unique_ptr<Controller>> shards_;
+    long long windowCount_;
+    long long stolenRequests_;
+    long long trimmedRequests_;
+    std::int64_t generatedSeen_[PRIORITY_COUNT]; // arrivals up to the last barrier
+    std::string setupError_;                     // why the constructor could not split the run
+
+    // Shard other than `except` with the most requests of priority level
+    // waiting (-1: none waits)
+    int mostWaiting(int level, int except) const;
+    // Let idle devices take the highest priorities waiting at time now,
+    // evict what exceeds the shared capacity, then level each priority;
+    // returns the requests moved between shards
+    long long rebalance(double now);
+
+public:
+    // Traces, window files, event logs and the precision rule are per-run
+    // features and are turned off. numShards is capped at the device count; windowHours
+    // <= 0 picks a quarter of the time between departures of the whole fleet
+    // (the shortest mean service time over the device count).
+    ShardedSimulation(const SimulationConfig& config, int numShards, double windowHours = 0.0);
+
+    // Why the config cannot be sharded (empty if it can); run() then does nothing
+    const std::string& getSetupError() const;
+
+    // Run all shards to the end (numShards threads) and merge their results
+    SimulationResults run();
+
+    int getNumShards() const;
+    double getWindowHours() const;
+    // Barrier windows processed by run()
+    long long getWindowCount() const;
+    // Requests moved between shards by run()
+    long long getStolenRequests() const;
+    // Requests turned away or evicted at the barriers to fit the shared capacity
+    long long getTrimmedRequests() const;
+};
+
+// Print the merged results of a sharded run in the layout of printStatistics
+void printShardedResults(const SimulationResults& results, const ShardedSimulation& simulation);
@@ -1,33 +1,41 @@
-﻿#include "simulation.hpp"
+﻿#include "Simulation.hpp"
+#include <cstring>
 
-// Arrival rate function
+// Arrival rate function: the default day/night curve (0.2..0.7 per hour,
+// 24-hour cycle); scenarios configure their own through ArrivalSpec
 double getArrivalRate(double timeHours) {
-    // Example time-dependent: oscillation with a peak around midday or something similar
-    const double period = 24.0;    // 24-hour cycle
-    const double offset = 0.45;    // average rate
-    const double amplitude = 0.25; // half the difference from 0.2..0.7
-
-    double phase = 2.0 * 3.14159 * (timeHours / period);
-    double rate = offset + amplitude * std::sin(phase);
+    return SinusoidRate()(timeHours);
+}
 
-    // Ensure it's positive
-    if (rate <= 0) {
-        rate = 0.01; // fallback to a small positive number
+const char* priorityName(Priority pr) {
+    switch (pr) {
+    case Priority::CORPORATE: return "CORPORATE";
+    case Priority::PREMIUM:   return "PREMIUM";
+    case Priority::FREE:      return "FREE";
     }
-    return rate;
+    return "UNKNOWN";
 }
 
 // Time formatter
 std::string formatTime(double simulationTimeHours) {
-    int totalMinutes = static_cast<int>(std::floor(simulationTimeHours * 60.0));
-    int hours = (totalMinutes / 60) % 24;
-    int minutes = totalMinutes % 60;
-
     char buffer[6];
-    std::snprintf(buffer, sizeof(buffer), "%02d:%02d", hours, minutes);
+    formatTime(simulationTimeHours, buffer, sizeof(buffer));
     return std::string(buffer);
 }
 
+void formatTime(double simulationTimeHours, char* out, std::size_t size) {
+    // Minute of the day, in [0, 1440) also for negative times, so the
+    // fields are always two digits
+    int dayMinutes = static_cast<int>(std::floor(simulationTimeHours * 60.0)) % (24 * 60);
+    if (dayMinutes < 0) {
+        dayMinutes += 24 * 60;
+    }
+    int hours = dayMinutes / 60;
+    int minutes = dayMinutes % 60;
+
+    std::snprintf(out, size, "%02d:%02d", hours, minutes);
+}
+
 //------------------------------------------------------------------------------
 // Request class
 //------------------------------------------------------------------------------
@@ -36,8 +44,11 @@ Request::Request(int id, Priority priority, double arrivalTime, int sourceIndex)
     priority_(priority),
     arrivalTime_(arrivalTime),
     sourceIndex_(sourceIndex),
+    ringPosition_(0),
     bufferEnterTime_(arrivalTime),
-    startServiceTime_(0.0)
+    startServiceTime_(0.0),
+    renegeTime_(std::numeric_limits<double>::infinity()),
+    attempt_(0)
 {
 }
 
@@ -73,502 +84,2058 @@ double Request::getStartServiceTime() const {
     return startServiceTime_;
 }
 
+void Request::setRenegeTime(double t) {
+    renegeTime_ = t;
+}
+
+double Request::getRenegeTime() const {
+    return renegeTime_;
+}
+
+// Come back at t as the next attempt
+void Request::retry(double t) {
+    bufferEnterTime_ = t;
+    renegeTime_ = std::numeric_limits<double>::infinity();
+    attempt_++;
+}
+
+int Request::getAttempt() const {
+    return attempt_;
+}
+
 //------------------------------------------------------------------------------
-// Buffer class
+// RequestPool class
 //------------------------------------------------------------------------------
-Buffer::Buffer(Controller* controller)
-    : controller_(controller)
-{
-}
 
-// Add a request to the buffer with priority-based insertion
-bool Buffer::addRequest(const std::shared_ptr<Request>& req) {
-    // If there's space in the buffer, insert by priority
-    if (requests_.size() < BUFFER_SIZE) {
-        auto it = std::find_if(requests_.begin(), requests_.end(),
-            [&req](const auto& r) {
-                // We insert before the first request that has strictly lower priority
-                // or the same priority but arrived later
-                if (static_cast<int>(r->getPriority()) < static_cast<int>(req->getPriority())) {
-                    return false;
-                }
-                if (r->getPriority() == req->getPriority() && r->getArrivalTime() < req->getArrivalTime()) {
-                    return false;
-                }
-                return true;
-            }
-        );
-        requests_.insert(it, req);
-        req->setBufferEnterTime(req->getArrivalTime());
-        std::cout << "Request " << req->getId()
-            << " added to buffer (priority "
-            << static_cast<int>(req->getPriority()) << ").\n";
-        return true;
+// Take a slot (a recycled one if available) and initialize the request in it
+RequestHandle RequestPool::acquire(int id, Priority priority, double arrivalTime, int sourceIndex) {
+    if (!freeSlots_.empty()) {
+        RequestHandle handle = freeSlots_.back();
+        freeSlots_.pop_back();
+        slots_[handle] = Request(id, priority, arrivalTime, sourceIndex);
+        return handle;
     }
+    assert(slots_.size() < INVALID_REQUEST);
+    slots_.emplace_back(id, priority, arrivalTime, sourceIndex);
+    return static_cast<RequestHandle>(slots_.size() - 1);
+}
 
-    // Buffer is full, check if we can evict a lower-priority request
-    Priority newPr = req->getPriority();
-    if (newPr == Priority::FREE) {
-        // No chance to preempt anything
-        controller_->incrementRejectedRequests();
-        controller_->incrementRejectedByPriority(newPr);
-        return false;
-    }
+// Return a retired request's slot to the free list
+void RequestPool::release(RequestHandle handle) {
+    assert(handle < slots_.size());
+    freeSlots_.push_back(handle);
+}
 
-    if (newPr == Priority::PREMIUM) {
-        // Try to remove a FREE
-        auto itFree = std::find_if(requests_.begin(), requests_.end(),
-            [](auto& r) { return r->getPriority() == Priority::FREE; });
-        if (itFree != requests_.end()) {
-            auto evictedReq = *itFree;
-            requests_.erase(itFree);
-            controller_->incrementRejectedRequests();
-            controller_->incrementRejectedByPriority(evictedReq->getPriority());
+Request& RequestPool::operator[](RequestHandle handle) {
+    return slots_[handle];
+}
 
-            std::cout << "Evicting FREE request " << evictedReq->getId()
-                << " for new PREMIUM request " << req->getId() << "\n";
+const Request& RequestPool::operator[](RequestHandle handle) const {
+    return slots_[handle];
+}
 
-            requests_.push_back(req);
-            req->setBufferEnterTime(req->getArrivalTime());
-            return true;
-        }
-        else {
-            // All are premium or corporate
-            controller_->incrementRejectedRequests();
-            controller_->incrementRejectedByPriority(newPr);
+std::size_t RequestPool::capacity() const {
+    return slots_.size();
+}
+
+std::size_t RequestPool::inUse() const {
+    return slots_.size() - freeSlots_.size();
+}
+
+// Write every slot and the free list to a snapshot
+void RequestPool::save(SnapshotWriter& out) const {
+    out.writeVector(slots_);
+    out.writeVector(freeSlots_);
+}
+
+bool RequestPool::load(SnapshotReader& in) {
+    // Request has no default constructor, so the slots are read in place
+    std::uint64_t count = 0;
+    if (!in.read(count) || count >= INVALID_REQUEST || count > in.remaining() / sizeof(Request)) {
+        return false;
+    }
+    slots_.assign(static_cast<std::size_t>(count), Request(0, Priority::CORPORATE, 0.0, -1));
+    if (!in.readBytes(slots_.data(), slots_.size() * sizeof(Request)) || !in.readVector(freeSlots_)) {
+        return false;
+    }
+    for (RequestHandle handle : freeSlots_) {
+        if (handle >= slots_.size()) {
             return false;
         }
     }
+    return freeSlots_.size() <= slots_.size();
+}
 
-    if (newPr == Priority::CORPORATE) {
-        // First try to remove FREE
-        auto itFree = std::find_if(requests_.begin(), requests_.end(),
-            [](auto& r) { return r->getPriority() == Priority::FREE; });
-        if (itFree != requests_.end()) {
-            auto evictedReq = *itFree;
-            requests_.erase(itFree);
-            controller_->incrementRejectedRequests();
-            controller_->incrementRejectedByPriority(evictedReq->getPriority());
-
-            std::cout << "Evicting FREE request " << evictedReq->getId()
-                << " for new CORPORATE request " << req->getId() << "\n";
+//------------------------------------------------------------------------------
+// RequestRing class
+//------------------------------------------------------------------------------
+RequestRing::RequestRing(int capacity)
+    : slots_(capacity),
+    head_(0),
+    count_(0),
+    cancelled_(0),
+    headPosition_(0)
+{
+}
 
-            requests_.push_back(req);
-            req->setBufferEnterTime(req->getArrivalTime());
-            return true;
+// Drop the head, then any cancelled elements that reach it
+void RequestRing::advance() {
+    for (;;) {
+        if (++head_ == static_cast<int>(slots_.size())) {
+            head_ = 0;
         }
-        else {
-            // If no FREE, try to remove PREMIUM
-            auto itPrem = std::find_if(requests_.begin(), requests_.end(),
-                [](auto& r) { return r->getPriority() == Priority::PREMIUM; });
-            if (itPrem != requests_.end()) {
-                auto evictedReq = *itPrem;
-                requests_.erase(itPrem);
-                controller_->incrementRejectedRequests();
-                controller_->incrementRejectedByPriority(evictedReq->getPriority());
-
-                std::cout << "Evicting PREMIUM request " << evictedReq->getId()
-                    << " for new CORPORATE request " << req->getId() << "\n";
-
-                requests_.push_back(req);
-                req->setBufferEnterTime(req->getArrivalTime());
-                return true;
-            }
-            else {
-                // All are corporate
-                controller_->incrementRejectedRequests();
-                controller_->incrementRejectedByPriority(newPr);
-                return false;
-            }
+        headPosition_++;
+        count_--;
+        if (cancelled_ == 0 || slots_[head_] != INVALID_REQUEST) {
+            return;
         }
+        cancelled_--;
     }
-
-    // Otherwise, we reject
-    controller_->incrementRejectedRequests();
-    controller_->incrementRejectedByPriority(newPr);
-    return false;
 }
 
-// Pop a request from the front of the buffer
-std::shared_ptr<Request> Buffer::popRequest() {
-    if (!requests_.empty()) {
-        auto req = requests_.front();
-        requests_.pop_front();
-        return req;
+// Double the slots, keeping the positions: the head moves to slot 0
+void RequestRing::grow() {
+    std::vector<RequestHandle> slots(std::max<std::size_t>(1, 2 * slots_.size()));
+    for (int i = 0; i < count_; ++i) {
+        slots[i] = slots_[slotAt(i)];
     }
-    return nullptr;
+    slots_.swap(slots);
+    head_ = 0;
 }
 
-// Check if the buffer is empty
-bool Buffer::isEmpty() const {
-    return requests_.empty();
+// Append at the back; returns the position of the new element
+std::uint32_t RequestRing::push(RequestHandle req) {
+    if (count_ == static_cast<int>(slots_.size())) {
+        grow();
+    }
+    slots_[slotAt(count_)] = req;
+    return headPosition_ + static_cast<std::uint32_t>(count_++);
 }
 
-//------------------------------------------------------------------------------
-// Device class
-//------------------------------------------------------------------------------
-Device::Device(int id)
-    : id_(id),
-    busy_(false),
-    finishTime_(0.0),
-    busyTotalTime_(0.0),
-    startBusyTime_(0.0),
-    serviceTimeHours_(0.0)
-{
-    rng_.seed(std::random_device{}());
+// Remove the oldest element; the ring must not be empty
+RequestHandle RequestRing::pop() {
+    assert(count_ > 0);
+    RequestHandle req = slots_[head_];
+    advance();
+    return req;
 }
 
-// Check if the device is busy
-bool Device::isBusy() const {
-    return busy_;
+// The newest element, left in place
+RequestHandle RequestRing::back() const {
+    assert(count_ > 0);
+    int offset = count_ - 1;
+    while (slots_[slotAt(offset)] == INVALID_REQUEST) {
+        offset--;
+    }
+    return slots_[slotAt(offset)];
 }
 
-// Get the finish time of the current request
-double Device::getFinishTime() const {
-    return finishTime_;
+// Remove the newest element, with the cancelled ones behind it
+RequestHandle RequestRing::popBack() {
+    assert(count_ > 0);
+    // The head is live, so this stops at it at the latest
+    while (slots_[slotAt(count_ - 1)] == INVALID_REQUEST) {
+        count_--;
+        cancelled_--;
+    }
+    return slots_[slotAt(--count_)];
 }
 
-// Get the total busy time of the device
-double Device::getBusyTotalTime() const {
-    return busyTotalTime_;
+// Remove the element at a position holds() is true for
+void RequestRing::cancel(std::uint32_t position) {
+    std::uint32_t offset = position - headPosition_;
+    assert(offset < static_cast<std::uint32_t>(count_));
+    if (offset == 0) {
+        advance();
+        return;
+    }
+    slots_[slotAt(static_cast<int>(offset))] = INVALID_REQUEST;
+    cancelled_++;
 }
 
-// Load a request onto the device and generate service time
-void Device::loadRequest(const std::shared_ptr<Request>& req, double currentTimeHours) {
-    busy_ = true;
-    currentRequest_ = req;
-    startBusyTime_ = currentTimeHours;
+// The element at position is req
+bool RequestRing::holds(std::uint32_t position, RequestHandle req) const {
+    std::uint32_t offset = position - headPosition_;
+    return offset < static_cast<std::uint32_t>(count_) && slots_[slotAt(static_cast<int>(offset))] == req;
+}
 
-    // Generate an exponential service time
-    std::exponential_distribution<double> serviceDist(SERVICE_RATE);
-    serviceTimeHours_ = serviceDist(rng_);
-    finishTime_ = currentTimeHours + serviceTimeHours_;
+bool RequestRing::isEmpty() const {
+    return count_ == 0;
+}
 
-    req->setStartServiceTime(currentTimeHours);
+// Number of live elements
+int RequestRing::size() const {
+    return count_ - cancelled_;
+}
 
-    int serviceTimeMinutes = static_cast<int>(std::round(serviceTimeHours_ * 60.0));
-    std::cout << "Device " << id_
-        << ": request " << req->getId()
-        << " started at " << formatTime(currentTimeHours)
-        << ", estimated finish " << formatTime(finishTime_)
-        << " (service " << serviceTimeMinutes << " min)\n";
+// Write the head position and the elements oldest first, cancelled ones included
+void RequestRing::save(SnapshotWriter& out) const {
+    out.write(headPosition_);
+    out.write(count_);
+    for (int i = 0; i < count_; ++i) {
+        out.write(slots_[slotAt(i)]);
+    }
 }
 
-// Free the device after completing a request
-void Device::freeDevice(double timeHours) {
-    if (currentRequest_) {
-        std::cout << "Device " << id_
-            << ": request " << currentRequest_->getId()
-            << " finished at " << formatTime(timeHours) << "\n";
+// Read them back from the front of the ring, growing it for them if needed
+bool RequestRing::load(SnapshotReader& in) {
+    head_ = 0;
+    count_ = 0;
+    cancelled_ = 0;
+    int count = 0;
+    if (!in.read(headPosition_) || !in.read(count) || count < 0
+        || static_cast<std::size_t>(count) > in.remaining() / sizeof(RequestHandle)) {
+        return false;
+    }
+    if (count > static_cast<int>(slots_.size())) {
+        slots_.resize(count);
+    }
+    if (!in.readBytes(slots_.data(), count * sizeof(RequestHandle))) {
+        return false;
     }
-    busyTotalTime_ += (timeHours - startBusyTime_);
-    busy_ = false;
-    currentRequest_.reset();
+    count_ = count;
+    cancelled_ = static_cast<int>(std::count(slots_.begin(), slots_.begin() + count, INVALID_REQUEST));
+    return count == 0 || slots_[0] != INVALID_REQUEST;
 }
 
-// Get the generated service time in hours
-double Device::getServiceTimeHours() const {
-    return serviceTimeHours_;
+//------------------------------------------------------------------------------
+// Buffer policies
+//------------------------------------------------------------------------------
+PriorityQuota::PriorityQuota(const BufferPolicySpec& spec, int capacity, std::uint64_t, bool) {
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        quota_[p] = std::max(1, static_cast<int>(spec.quotaShare[p] * capacity));
+    }
 }
 
-int Device::getId() const {
-    return id_;
+bool PriorityQuota::admit(const RequestRing (&rings)[PRIORITY_COUNT], int, const Request& req) {
+    int level = static_cast<int>(req.getPriority());
+    return rings[level].size() < quota_[level];
 }
 
-//------------------------------------------------------------------------------
-// Source class
-//------------------------------------------------------------------------------
-Source::Source(Priority priority, int sourceIndex)
-    : priority_(priority),
-    sourceIndex_(sourceIndex)
+EarlyDrop::EarlyDrop(const BufferPolicySpec& spec, int capacity, std::uint64_t seed, bool antithetic)
+    : start_(spec.dropStart * capacity),
+    full_(spec.dropFull * capacity),
+    averaging_(spec.dropAveraging),
+    average_(0.0),
+    seed_(seed),
+    antithetic_(antithetic)
 {
-    rng_.seed(std::random_device{}());
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        probability_[p] = spec.dropProbability[p];
+    }
 }
 
-// Generate the inter-arrival time for the next request
-double Source::generateInterArrivalTime(double currentTimeHours) {
-    double lambda = getArrivalRate(currentTimeHours);
-    std::exponential_distribution<double> dist(lambda);
-    return dist(rng_);
+// Update the average with the occupancy seen by this arrival, then drop it
+// with a probability growing linearly from start_ to full_
+bool EarlyDrop::admit(const RequestRing (&)[PRIORITY_COUNT], int size, const Request& req) {
+    average_ += averaging_ * (size - average_);
+    if (average_ <= start_) {
+        return true;
+    }
+    double share = std::min(1.0, (average_ - start_) / (full_ - start_));
+    double drop = probability_[static_cast<int>(req.getPriority())] * share;
+    return keyedUniform(seed_, streamId(StreamKind::ADMISSION, req.getId()), antithetic_) >= drop;
 }
 
-// Create a new request
-std::shared_ptr<Request> Source::createRequest(int requestId, double arrivalTimeHours) {
-    return std::make_shared<Request>(
-        requestId,
-        priority_,
-        arrivalTimeHours,
-        sourceIndex_
-    );
+void EarlyDrop::save(SnapshotWriter& out) const {
+    out.write(average_);
 }
 
-// Schedule the next request generation
-void Source::scheduleNextRequest(Controller& controller, double currentTime) {
-    // If we already generated maxRequests, do not create more
-    if (controller.getGeneratedRequestsCountRef() >= controller.getMaxRequests()) {
-        return;
+bool EarlyDrop::load(SnapshotReader& in) {
+    return in.read(average_) && average_ >= 0.0;
+}
+
+// The first non-empty ring (the buffer is not empty)
+int PriorityOrder::take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool&) {
+    int level = 0;
+    while (level < PRIORITY_COUNT - 1 && rings[level].isEmpty()) {
+        level++;
     }
+    return level;
+}
 
-    double delta = generateInterArrivalTime(currentTime);
-    double arrivalTime = currentTime + delta;
+// The ring whose oldest request entered first; ties go to the higher priority
+int ArrivalOrder::take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool) {
+    int best = -1;
+    double earliest = 0.0;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (rings[p].isEmpty()) {
+            continue;
+        }
+        double arrival = pool[rings[p].front()].getBufferEnterTime();
+        if (best < 0 || arrival < earliest) {
+            best = p;
+            earliest = arrival;
+        }
+    }
+    return best;
+}
 
-    auto& globalId = controller.getGlobalRequestIdRef();
-    globalId++;
-    int newReqId = globalId;
+DeadlineOrder::DeadlineOrder(const BufferPolicySpec& spec, int, std::uint64_t, bool) {
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        deadline_[p] = spec.deadlineHours[p];
+    }
+}
 
-    auto newReq = createRequest(newReqId, arrivalTime);
-    controller.getGeneratedRequestsCountRef()++;
+// The ring whose oldest request is due first; ties go to the higher priority
+int DeadlineOrder::take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool) {
+    int best = -1;
+    double earliest = 0.0;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (rings[p].isEmpty()) {
+            continue;
+        }
+        double due = pool[rings[p].front()].getBufferEnterTime() + deadline_[p];
+        if (best < 0 || due < earliest) {
+            best = p;
+            earliest = due;
+        }
+    }
+    return best;
+}
 
-    // Push event: request generated
-    controller.pushEvent(Event{
-        EventType::REQUEST_GENERATED,
-        arrivalTime,
-        newReq,
-        -1
-        });
+WeightedFairOrder::WeightedFairOrder(const BufferPolicySpec& spec, int, std::uint64_t, bool)
+    : lastPass_(0.0)
+{
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        stride_[p] = 1.0 / spec.weights[p];
+        pass_[p] = 0.0;
+    }
 }
 
-Priority Source::getPriority() const {
-    return priority_;
+// A priority that was empty restarts at the pass last served
+void WeightedFairOrder::pushed(int level, bool wasEmpty) {
+    if (wasEmpty && pass_[level] < lastPass_) {
+        pass_[level] = lastPass_;
+    }
 }
 
-int Source::getSourceIndex() const {
-    return sourceIndex_;
+// The waiting priority with the smallest pass; ties go to the higher priority
+int WeightedFairOrder::take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool&) {
+    int best = -1;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (!rings[p].isEmpty() && (best < 0 || pass_[p] < pass_[best])) {
+            best = p;
+        }
+    }
+    lastPass_ = pass_[best];
+    pass_[best] += stride_[best];
+    return best;
+}
+
+void WeightedFairOrder::save(SnapshotWriter& out) const {
+    out.write(pass_);
+    out.write(lastPass_);
+}
+
+bool WeightedFairOrder::load(SnapshotReader& in) {
+    return in.read(pass_) && in.read(lastPass_);
 }
 
 //------------------------------------------------------------------------------
-// Controller class
+// Buffer class
 //------------------------------------------------------------------------------
-Controller::Controller(int numCorporate, int numPremium, int numFree,
-    int numDevices, int maxRequests)
-    : buffer_(this),
-    globalRequestId_(0),
-    maxRequests_(maxRequests),
-    generatedRequestsCount_(0),
-    rejectedRequests_(0),
-    totalWaitTime_(0.0),
-    servedRequestsCount_(0),
-    lastEventTime_(0.0)
+template <class Admission, class Eviction, class Order>
+BasicBuffer<Admission, Eviction, Order>::BasicBuffer(RequestPool& pool, SimulationMetrics& metrics, TraceSink& trace,
+    EventLogWriter& eventLog, WindowRecorder& windows, int capacity,
+    const BufferPolicySpec& policy, std::uint64_t seed, bool antithetic)
+    : rings_{ RequestRing(capacity), RequestRing(capacity), RequestRing(capacity) },
+    capacity_(capacity),
+    size_(0),
+    pool_(pool),
+    metrics_(metrics),
+    trace_(trace),
+    eventLog_(eventLog),
+    windows_(windows),
+    admission_(policy, capacity, seed, antithetic),
+    eviction_(policy, capacity, seed, antithetic),
+    order_(policy, capacity, seed, antithetic)
 {
-    // Initialize rejections
-    rejectedByPriority_[Priority::CORPORATE] = 0;
-    rejectedByPriority_[Priority::PREMIUM] = 0;
-    rejectedByPriority_[Priority::FREE] = 0;
+}
 
-    // Create source objects
-    int sourceIndex = 0;
-    for (int i = 0; i < numCorporate; ++i) {
-        sources_.push_back(std::make_unique<Source>(Priority::CORPORATE, sourceIndex++));
+// Add a request to the buffer if the admission policy lets it in; when
+// full, evict the oldest request of the lowest priority the eviction
+// policy allows (handed to the caller, or retired back to the pool)
+template <class Admission, class Eviction, class Order>
+bool BasicBuffer<Admission, Eviction, Order>::addRequest(RequestHandle handle, RequestHandle* evictedOut) {
+    Request& req = pool_[handle];
+    Priority newPr = req.getPriority();
+    int level = static_cast<int>(newPr);
+    if (evictedOut) {
+        *evictedOut = INVALID_REQUEST;
     }
-    for (int i = 0; i < numPremium; ++i) {
-        sources_.push_back(std::make_unique<Source>(Priority::PREMIUM, sourceIndex++));
-    }
-    for (int i = 0; i < numFree; ++i) {
-        sources_.push_back(std::make_unique<Source>(Priority::FREE, sourceIndex++));
+    bool admitted = admission_.admit(rings_, size_, req);
+
+    // If there's space in the buffer, append to the ring of its priority;
+    // arrivals come in time order, so each ring stays sorted by enter time
+    if (admitted && size_ < capacity_) {
+        order_.pushed(level, rings_[level].isEmpty());
+        req.setRingPosition(rings_[level].push(handle));
+        size_++;
+        if (trace_.enabled(TraceLevel::FULL)) {
+            trace_.write("Request %d added to buffer (priority %d).\n",
+                req.getId(), level);
+        }
+        return true;
     }
 
-    // Create device objects
-    for (int i = 1; i <= numDevices; ++i) {
-        devices_.push_back(std::make_unique<Device>(i));
+    // Buffer is full: evict from the lowest non-empty priority the policy allows
+    for (int victim = PRIORITY_COUNT - 1; admitted && victim >= 0; --victim) {
+        if (eviction_.evicts(victim, level) && !rings_[victim].isEmpty()) {
+            RequestHandle evicted = rings_[victim].pop();
+            const Request& evictedReq = pool_[evicted];
+            metrics_.recordEvicted(victim);
+            windows_.recordRejection(victim);
+
+            if (trace_.enabled(TraceLevel::FULL)) {
+                trace_.write("Evicting %s request %d for new %s request %d\n",
+                    priorityName(evictedReq.getPriority()), evictedReq.getId(),
+                    priorityName(newPr), req.getId());
+            }
+            if (eventLog_.isOpen()) {
+                eventLog_.record(req.getBufferEnterTime(), LogEventType::EVICTED, evictedReq.getId(), victim);
+            }
+            if (evictedOut) {
+                *evictedOut = evicted;
+            }
+            else {
+                pool_.release(evicted);
+            }
+
+            order_.pushed(level, rings_[level].isEmpty());
+            req.setRingPosition(rings_[level].push(handle));
+            return true;
+        }
     }
 
-    rng_.seed(std::random_device{}());
+    // Turned away, or nothing the policy may preempt: reject
+    metrics_.recordRejected(level);
+    windows_.recordRejection(level);
+    return false;
 }
 
-void Controller::initRequests() {
-    // Initialize first requests for each source at time = 0
-    double startTime = 0.0;
-    for (auto& src : sources_) {
-        if (generatedRequestsCount_ >= maxRequests_) {
-            break;
-        }
-        double interArrival = src->generateInterArrivalTime(startTime);
-        double arrivalTime = startTime + interArrival;
+// Pop the next request in the order of the policy (INVALID_REQUEST if empty)
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::popRequest() {
+    if (size_ == 0) {
+        return INVALID_REQUEST;
+    }
+    size_--;
+    return rings_[order_.take(rings_, pool_)].pop();
+}
 
-        globalRequestId_++;
-        auto newReq = src->createRequest(globalRequestId_, arrivalTime);
-        generatedRequestsCount_++;
+// Pop the oldest request of one priority, bypassing the order policy
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::popRequest(Priority priority) {
+    RequestRing& ring = rings_[static_cast<int>(priority)];
+    if (ring.isEmpty()) {
+        return INVALID_REQUEST;
+    }
+    size_--;
+    return ring.pop();
+}
 
-        events_.push(Event{
-            EventType::REQUEST_GENERATED,
-            arrivalTime,
-            newReq,
-            -1
-            });
+// Pop the newest request of one priority
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::popNewest(Priority priority) {
+    RequestRing& ring = rings_[static_cast<int>(priority)];
+    if (ring.isEmpty()) {
+        return INVALID_REQUEST;
     }
+    size_--;
+    return ring.popBack();
 }
 
-void Controller::work() {
-    // Continue until we serve at least maxRequests_ requests
-    while (servedRequestsCount_ < maxRequests_) {
-        if (events_.empty()) {
-            // No more events => stop
-            std::cout << "No more events, simulation ends.\n";
-            break;
-        }
+// The request is waiting in the buffer
+template <class Admission, class Eviction, class Order>
+bool BasicBuffer<Admission, Eviction, Order>::contains(RequestHandle handle) const {
+    const Request& req = pool_[handle];
+    return rings_[static_cast<int>(req.getPriority())].holds(req.getRingPosition(), handle);
+}
 
-        Event currentEvent = popEvent();
-        double currentTime = currentEvent.time;
-        updateLastEventTime(currentTime);
+// Take a waiting request out of the buffer in O(1), wherever it is
+template <class Admission, class Eviction, class Order>
+void BasicBuffer<Admission, Eviction, Order>::removeRequest(RequestHandle handle) {
+    assert(contains(handle));
+    const Request& req = pool_[handle];
+    rings_[static_cast<int>(req.getPriority())].cancel(req.getRingPosition());
+    size_--;
+}
 
-        if (currentEvent.type == EventType::REQUEST_GENERATED) {
-            handleRequestGenerated(currentEvent.request, currentTime);
-        }
-        else if (currentEvent.type == EventType::REQUEST_SERVED) {
-            handleRequestFinished(currentEvent.deviceId, currentTime, currentEvent.request);
-        }
-    }
+// The oldest / newest waiting request of a priority
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::oldest(Priority priority) const {
+    const RequestRing& ring = rings_[static_cast<int>(priority)];
+    return ring.isEmpty() ? INVALID_REQUEST : ring.front();
 }
 
-// Handle a newly generated request
-void Controller::handleRequestGenerated(const std::shared_ptr<Request>& req, double currentTime) {
-    std::cout << "Request " << req->getId()
-        << " generated at " << formatTime(currentTime)
-        << " with priority " << static_cast<int>(req->getPriority())
-        << ".\n";
-
-    bool added = buffer_.addRequest(req);
-    if (!added) {
-        std::cout << "Request " << req->getId() << " rejected.\n";
-    }
-    else {
-        // Attempt to load into devices immediately if any are free
-        loadRequestsToFreeDevices(currentTime);
-    }
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::newest(Priority priority) const {
+    const RequestRing& ring = rings_[static_cast<int>(priority)];
+    return ring.isEmpty() ? INVALID_REQUEST : ring.back();
+}
 
-    // Schedule the next request from the same source
-    int srcIdx = req->getSourceIndex();
-    if (srcIdx >= 0 && srcIdx < static_cast<int>(getSources().size())) {
-        getSources()[srcIdx]->scheduleNextRequest(*this, currentTime);
+// Evict the oldest waiting request of a priority; the caller retires it
+template <class Admission, class Eviction, class Order>
+RequestHandle BasicBuffer<Admission, Eviction, Order>::evictOldest(Priority priority, double currentTime) {
+    int victim = static_cast<int>(priority);
+    RequestHandle evicted = popRequest(priority);
+    const Request& evictedReq = pool_[evicted];
+    metrics_.recordEvicted(victim);
+    windows_.recordRejection(victim);
+    if (trace_.enabled(TraceLevel::FULL)) {
+        trace_.write("Evicting %s request %d\n", priorityName(priority), evictedReq.getId());
+    }
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::EVICTED, evictedReq.getId(), victim);
     }
+    return evicted;
 }
 
-// Handle the completion of a request
-void Controller::handleRequestFinished(int deviceId, double currentTime, const std::shared_ptr<Request>& req) {
-    // The device frees itself
-    devices_[deviceId - 1]->freeDevice(currentTime);
-    // Load next request from the buffer
-    loadRequestsToFreeDevices(currentTime);
+// Reject the newest waiting request of a priority
+template <class Admission, class Eviction, class Order>
+void BasicBuffer<Admission, Eviction, Order>::rejectNewest(Priority priority) {
+    int level = static_cast<int>(priority);
+    RequestHandle rejected = popNewest(priority);
+    metrics_.recordRejected(level);
+    windows_.recordRejection(level);
+    pool_.release(rejected);
 }
 
-void Controller::printStatistics() {
-    std::cout << "\n--- Final statistics ---\n";
-    std::cout << "Total requests generated:  " << generatedRequestsCount_ << "\n";
-    std::cout << "Total requests served:     " << servedRequestsCount_ << "\n";
-    std::cout << "Total rejected requests:   " << rejectedRequests_ << "\n";
+// Check if the buffer is empty
+template <class Admission, class Eviction, class Order>
+bool BasicBuffer<Admission, Eviction, Order>::isEmpty() const {
+    return size_ == 0;
+}
 
-    std::cout << "Rejected Corporate: " << rejectedByPriority_[Priority::CORPORATE] << "\n";
-    std::cout << "Rejected Premium:   " << rejectedByPriority_[Priority::PREMIUM] << "\n";
-    std::cout << "Rejected Free:      " << rejectedByPriority_[Priority::FREE] << "\n";
+// Number of requests currently waiting
+template <class Admission, class Eviction, class Order>
+int BasicBuffer<Admission, Eviction, Order>::size() const {
+    return size_;
+}
 
-    double avgWaitTime = 0.0;
-    if (servedRequestsCount_ > 0) {
-        avgWaitTime = totalWaitTime_ / (double)servedRequestsCount_;
-    }
-    std::cout << "Average waiting time (hours): " << avgWaitTime
-        << " (~" << (avgWaitTime * 60.0) << " min)\n";
+template <class Admission, class Eviction, class Order>
+int BasicBuffer<Admission, Eviction, Order>::size(Priority priority) const {
+    return rings_[static_cast<int>(priority)].size();
+}
 
-    std::cout << "\nDevices utilization:\n";
-    for (auto& dev : devices_) {
-        double busyTime = dev->getBusyTotalTime();
-        double utilization = (lastEventTime_ > 0.0)
-            ? (busyTime / lastEventTime_)
-            : 0.0;
+template <class Admission, class Eviction, class Order>
+int BasicBuffer<Admission, Eviction, Order>::getCapacity() const {
+    return capacity_;
+}
 
-        std::cout << "  Device " << dev->getId()
-            << ": busy " << busyTime << " h, load "
-            << (utilization * 100.0) << " %\n";
+// Write the queued handles and the policy state to a snapshot
+template <class Admission, class Eviction, class Order>
+void BasicBuffer<Admission, Eviction, Order>::save(SnapshotWriter& out) const {
+    out.write(capacity_);
+    for (const RequestRing& ring : rings_) {
+        ring.save(out);
     }
+    admission_.save(out);
+    eviction_.save(out);
+    order_.save(out);
+}
 
-    std::cout << "\nTotal simulation time: " << lastEventTime_ << " hours\n";
+// Read them back into a buffer of the same capacity and policies
+template <class Admission, class Eviction, class Order>
+bool BasicBuffer<Admission, Eviction, Order>::load(SnapshotReader& in) {
+    int capacity = 0;
+    if (!in.read(capacity) || capacity != capacity_) {
+        return false;
+    }
+    size_ = 0;
+    for (RequestRing& ring : rings_) {
+        if (!ring.load(in)) {
+            return false;
+        }
+        size_ += ring.size();
+    }
+    return size_ <= capacity_ && admission_.load(in) && eviction_.load(in) && order_.load(in);
 }
 
-void Controller::incrementRejectedRequests() {
-    rejectedRequests_++;
+// Every buffer of BufferPolicyKind
+template class BasicBuffer<AdmitAll, EvictLowerPriority, PriorityOrder>;
+template class BasicBuffer<AdmitAll, NoEviction, ArrivalOrder>;
+template class BasicBuffer<AdmitAll, EvictLowerPriority, DeadlineOrder>;
+template class BasicBuffer<AdmitAll, EvictLowerPriority, WeightedFairOrder>;
+template class BasicBuffer<PriorityQuota, EvictLowerPriority, PriorityOrder>;
+template class BasicBuffer<EarlyDrop, EvictLowerPriority, PriorityOrder>;
+
+//------------------------------------------------------------------------------
+// DeviceTable class
+//------------------------------------------------------------------------------
+
+DeviceTable::DeviceTable(bool commonDemands, bool antithetic)
+    : demandSeed_(0),
+    commonDemands_(commonDemands),
+    antithetic_(antithetic),
+    replayDemands_(nullptr)
+{
 }
 
-void Controller::incrementRejectedByPriority(Priority pr) {
-    rejectedByPriority_[pr]++;
+// Room for `count` devices without reallocation
+void DeviceTable::reserve(int count) {
+    busy_.reserve((count + 63) / 64);
+    finishTime_.reserve(count);
+    inService_.reserve(count);
+    busyTotal_.reserve(count);
+    startBusy_.reserve(count);
+    serviceTime_.reserve(count);
+    currentRequest_.reserve(count);
+    service_.reserve(count);
+    rng_.reserve(count);
 }
 
-int Controller::getRejectedByPriority(Priority p) const {
-    auto it = rejectedByPriority_.find(p);
-    if (it != rejectedByPriority_.end()) {
-        return it->second;
+// Append the device with index size()
+void DeviceTable::add(std::uint64_t seed, const ServiceModel& service) {
+    int index = size();
+    if ((index & 63) == 0) {
+        busy_.push_back(0);
     }
-    return 0;
+    finishTime_.push_back(0.0);
+    busyTotal_.push_back(0.0);
+    startBusy_.push_back(0.0);
+    serviceTime_.push_back(0.0);
+    currentRequest_.push_back(INVALID_REQUEST);
+    inService_.push_back(0);
+    service_.push_back(&service);
+    rng_.emplace_back(seed, streamId(StreamKind::DEVICE, index + 1), antithetic_);
+    demandSeed_ = seed;
+}
+
+int DeviceTable::size() const {
+    return static_cast<int>(finishTime_.size());
 }
 
-int Controller::getServedRequestsCount() const {
-    return servedRequestsCount_;
+// Service demands of replayed requests by request id - 1
+void DeviceTable::setReplayDemands(const double* demands) {
+    replayDemands_ = demands;
 }
 
-void Controller::pushEvent(const Event& ev) {
-    events_.push(ev);
+// Start serving req; returns the generated service time in hours
+double DeviceTable::start(int index, RequestHandle req, int requestId, double currentTimeHours, int batchSize) {
+    busy_[index >> 6] |= std::uint64_t(1) << (index & 63);
+    currentRequest_[index] = req;
+    inService_[index] = batchSize;
+    startBusy_[index] = currentTimeHours;
+
+    // Generate a service time from the device class's model
+    double serviceTime = (replayDemands_ && replayDemands_[requestId - 1] > 0.0) ? replayDemands_[requestId - 1]
+        : commonDemands_ ? service_[index]->quantile(keyedUniform(demandSeed_, streamId(StreamKind::DEMAND, requestId), antithetic_))
+        : service_[index]->sample(rng_[index]);
+    if (batchSize > 1) {
+        serviceTime *= service_[index]->getBatchFactor(batchSize);
+    }
+    serviceTime_[index] = serviceTime;
+    finishTime_[index] = currentTimeHours + serviceTime;
+    return serviceTime;
 }
 
-bool Controller::eventsEmpty() const {
-    return events_.empty();
+// End one request of the current service
+bool DeviceTable::finish(int index, double timeHours) {
+    if (--inService_[index] > 0) {
+        return false;
+    }
+    busyTotal_[index] += (timeHours - startBusy_[index]);
+    busy_[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+    currentRequest_[index] = INVALID_REQUEST;
+    return true;
 }
 
-Event Controller::popEvent() {
-    auto topEvent = events_.top();
-    events_.pop();
-    return topEvent;
-} // TODO: 
+// Restart every service-time stream under another seed
+void DeviceTable::reseed(std::uint64_t seed) {
+    for (int i = 0; i < size(); ++i) {
+        rng_[i].seed(seed, streamId(StreamKind::DEVICE, i + 1));
+    }
+    demandSeed_ = seed;
+}
 
-int& Controller::getGlobalRequestIdRef() {
-    return globalRequestId_;
+// Write the device state and streams to a snapshot
+void DeviceTable::save(SnapshotWriter& out) const {
+    out.writeVector(busy_);
+    out.writeVector(finishTime_);
+    out.writeVector(busyTotal_);
+    out.writeVector(startBusy_);
+    out.writeVector(serviceTime_);
+    out.writeVector(currentRequest_);
+    out.writeVector(inService_);
+    for (const VariateStream& rng : rng_) {
+        rng.save(out);
+    }
 }
 
-int Controller::getGlobalRequestId() const {
-    return globalRequestId_;
+// Read them back into a table with the same number of devices
+bool DeviceTable::load(SnapshotReader& in) {
+    const long long count = size();
+    if (!in.readVector(busy_, static_cast<long long>(busy_.size())) || !in.readVector(finishTime_, count)
+        || !in.readVector(busyTotal_, count) || !in.readVector(startBusy_, count)
+        || !in.readVector(serviceTime_, count) || !in.readVector(currentRequest_, count)
+        || !in.readVector(inService_, count)) {
+        return false;
+    }
+    for (VariateStream& rng : rng_) {
+        if (!rng.load(in)) {
+            return false;
+        }
+    }
+    return true;
 }
 
-int& Controller::getGeneratedRequestsCountRef() {
-    return generatedRequestsCount_;
+//------------------------------------------------------------------------------
+// Device class
+//------------------------------------------------------------------------------
+Device::Device(DeviceTable& table, int id, RequestPool& pool, TraceSink& trace)
+    : table_(&table),
+    index_(id - 1),
+    pool_(&pool),
+    trace_(&trace)
+{
 }
 
-int Controller::getMaxRequests() const {
-    return maxRequests_;
+// Check if the device is busy
+bool Device::isBusy() const {
+    return table_->isBusy(index_);
 }
 
-std::vector<std::unique_ptr<Device>>& Controller::getDevices() {
-    return devices_;
+// Get the finish time of the current request
+double Device::getFinishTime() const {
+    return table_->getFinishTime(index_);
 }
 
-std::vector<std::unique_ptr<Source>>& Controller::getSources() {
-    return sources_;
+// Get the total busy time of the device
+double Device::getBusyTotalTime() const {
+    return table_->getBusyTotalTime(index_);
 }
 
-void Controller::loadRequestsToFreeDevices(double currentTime) {
-    for (auto& device : devices_) {
-        if (!device->isBusy()) {
-            auto nextReq = buffer_.popRequest();
-            if (nextReq) {
-                device->loadRequest(nextReq, currentTime);
-
-                double waitTime = currentTime - nextReq->getBufferEnterTime();
-                totalWaitTime_ += waitTime;
-                servedRequestsCount_++;
-
-                double serviceDuration = device->getServiceTimeHours();
-                pushEvent(Event{
-                    EventType::REQUEST_SERVED,
-                    currentTime + serviceDuration,
-                    nextReq,
-                    device->getId()
-                    });
-            }
-            else {
-                break;
-            }
+// Load a request, or the first of a batch, onto the device and generate service time
+void Device::loadRequest(RequestHandle req, double currentTimeHours, int batchSize) {
+    const Request& request = (*pool_)[req];
+    double serviceTimeHours = table_->start(index_, req, request.getId(), currentTimeHours, batchSize);
+
+    if (trace_->enabled(TraceLevel::FULL)) {
+        int serviceTimeMinutes = static_cast<int>(std::round(serviceTimeHours * 60.0));
+        char started[6];
+        char finish[6];
+        formatTime(currentTimeHours, started, sizeof(started));
+        formatTime(table_->getFinishTime(index_), finish, sizeof(finish));
+        if (batchSize > 1) {
+            trace_->write("Device %d: batch of %d from request %d started at %s, estimated finish %s (service %d min)\n",
+                getId(), batchSize, (*pool_)[req].getId(), started, finish, serviceTimeMinutes);
+        }
+        else {
+            trace_->write("Device %d: request %d started at %s, estimated finish %s (service %d min)\n",
+                getId(), (*pool_)[req].getId(), started, finish, serviceTimeMinutes);
         }
     }
 }
 
-void Controller::updateLastEventTime(double t) {
-    if (t > lastEventTime_) {
+// Complete req; true when it was the last of its batch
+bool Device::freeDevice(RequestHandle req, double timeHours) {
+    if (req != INVALID_REQUEST && trace_->enabled(TraceLevel::FULL)) {
+        char finished[6];
+        formatTime(timeHours, finished, sizeof(finished));
+        trace_->write("Device %d: request %d finished at %s\n",
+            getId(), (*pool_)[req].getId(), finished);
+    }
+    return table_->finish(index_, timeHours);
+}
+
+// Get the generated service time in hours
+double Device::getServiceTimeHours() const {
+    return table_->getServiceTimeHours(index_);
+}
+
+int Device::getId() const {
+    return index_ + 1;
+}
+
+//------------------------------------------------------------------------------
+// Source class
+//------------------------------------------------------------------------------
+Source::Source(Priority priority, int sourceIndex, std::uint64_t seed, const ArrivalProfile& arrivals,
+    bool antithetic)
+    : priority_(priority),
+    sourceIndex_(sourceIndex),
+    rng_(seed, streamId(StreamKind::SOURCE, sourceIndex), antithetic),
+    arrivals_(&arrivals)
+{
+}
+
+// Generate the inter-arrival time for the next request
+double Source::generateInterArrivalTime(double currentTimeHours) {
+    return arrivals_->nextArrival(currentTimeHours, rng_) - currentTimeHours;
+}
+
+// Create a new request in the pool
+RequestHandle Source::createRequest(RequestPool& pool, int requestId, double arrivalTimeHours) {
+    return pool.acquire(
+        requestId,
+        priority_,
+        arrivalTimeHours,
+        sourceIndex_
+    );
+}
+
+// Schedule the next request generation on a BasicController
+template <class Host>
+void Source::scheduleNextRequest(Host& controller, double currentTime) {
+    // If we already generated maxRequests, do not create more
+    SimulationMetrics& metrics = controller.getMetrics();
+    if (metrics.generated() >= controller.getMaxRequests()) {
+        return;
+    }
+
+    double delta = generateInterArrivalTime(currentTime);
+    double arrivalTime = currentTime + delta;
+
+    auto& globalId = controller.getGlobalRequestIdRef();
+    globalId++;
+    int newReqId = globalId;
+
+    RequestHandle newReq = createRequest(controller.getRequestPool(), newReqId, arrivalTime);
+    metrics.recordGenerated(static_cast<int>(priority_));
+
+    // Push event: request generated
+    controller.pushEvent(Event{
+        arrivalTime,
+        newReq,
+        EventType::REQUEST_GENERATED,
+        -1
+        });
+}
+
+Priority Source::getPriority() const {
+    return priority_;
+}
+
+int Source::getSourceIndex() const {
+    return sourceIndex_;
+}
+
+// Restart the arrival stream under another seed
+void Source::reseed(std::uint64_t seed) {
+    rng_.seed(seed, streamId(StreamKind::SOURCE, sourceIndex_));
+}
+
+void Source::save(SnapshotWriter& out) const {
+    rng_.save(out);
+}
+
+bool Source::load(SnapshotReader& in) {
+    return rng_.load(in);
+}
+
+//------------------------------------------------------------------------------
+// ReplaySource class
+//------------------------------------------------------------------------------
+ReplaySource::ReplaySource()
+    : nextRow_(0)
+{
+}
+
+// Map the trace; false with a message on a bad file
+bool ReplaySource::open(const std::string& path, std::string& error) {
+    nextRow_ = 0;
+    if (!trace_.open(path, error)) {
+        return false;
+    }
+    if (trace_.getRowCount() > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+        error = path + ": more rows than request ids";
+        return false;
+    }
+    return true;
+}
+
+bool ReplaySource::isOpen() const {
+    return trace_.isOpen();
+}
+
+const ArrivalTrace& ReplaySource::getTrace() const {
+    return trace_;
+}
+
+// Schedule the arrival of the next row
+template <class Host>
+void ReplaySource::scheduleNextRequest(Host& controller, double currentTime) {
+    SimulationMetrics& metrics = controller.getMetrics();
+    if (nextRow_ >= trace_.getRowCount() || metrics.generated() >= controller.getMaxRequests()) {
+        return;
+    }
+    const std::uint64_t row = nextRow_++;
+#if defined(__GNUC__)
+    // Touch the rows a page ahead, so a fault is taken before it is needed
+    if (row + REPLAY_PREFETCH_ROWS < trace_.getRowCount()) {
+        __builtin_prefetch(trace_.getTimes() + row + REPLAY_PREFETCH_ROWS);
+        __builtin_prefetch(trace_.getPriorities() + row + REPLAY_PREFETCH_ROWS);
+    }
+#endif
+    double arrivalTime = std::max(trace_.getTime(row), currentTime);
+    Priority priority = static_cast<Priority>(std::min(trace_.getPriority(row), PRIORITY_COUNT - 1));
+
+    auto& globalId = controller.getGlobalRequestIdRef();
+    globalId++;
+    RequestHandle newReq = controller.getRequestPool().acquire(globalId, priority, arrivalTime, REPLAY_SOURCE_INDEX);
+    metrics.recordGenerated(static_cast<int>(priority));
+
+    controller.pushEvent(Event{
+        arrivalTime,
+        newReq,
+        EventType::REQUEST_GENERATED,
+        -1
+        });
+}
+
+// Write the replay position to a snapshot
+void ReplaySource::save(SnapshotWriter& out) const {
+    out.write(trace_.getRowCount());
+    out.write(nextRow_);
+}
+
+bool ReplaySource::load(SnapshotReader& in) {
+    std::uint64_t rows = 0;
+    return in.read(rows) && in.read(nextRow_) && rows == trace_.getRowCount() && nextRow_ <= rows;
+}
+
+//------------------------------------------------------------------------------
+// Controller class
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// SimulationResults struct
+//------------------------------------------------------------------------------
+
+// Share of generated requests that were rejected or evicted
+double SimulationResults::rejectionRate() const {
+    return generatedRequests > 0
+        ? static_cast<double>(rejectedRequests) / generatedRequests
+        : 0.0;
+}
+
+// Index into deviceClasses of the device with 0-based index (0 when empty)
+int SimulationConfig::deviceClassOf(int deviceIndex) const {
+    int first = 0;
+    for (std::size_t c = 0; c < deviceClasses.size(); ++c) {
+        first += deviceClasses[c].count;
+        if (deviceIndex < first) {
+            return static_cast<int>(c);
+        }
+    }
+    return deviceClasses.empty() ? 0 : static_cast<int>(deviceClasses.size()) - 1;
+}
+
+// Some requests renege or retry
+bool SimulationConfig::abandons() const {
+    for (const PatienceSpec& spec : patience) {
+        if (spec.enabled) {
+            return true;
+        }
+    }
+    return retry.maxAttempts > 1 && retry.probability > 0.0;
+}
+
+// Utilization averaged over all devices
+double SimulationResults::meanUtilization() const {
+    if (deviceUtilization.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double u : deviceUtilization) {
+        sum += u;
+    }
+    return sum / deviceUtilization.size();
+}
+
+// Print mean, p50, p95 and p99 of wait and sojourn time per priority
+void printLatencyStatistics(const LatencyStats (&latency)[PRIORITY_COUNT]) {
+    std::cout << "\nTimes by priority (min):   mean      p50      p95      p99\n";
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        const char* name = priorityName(static_cast<Priority>(p));
+        const LogHistogram* rows[2] = { &latency[p].wait, &latency[p].sojourn };
+        const char* kinds[2] = { "wait", "sojourn" };
+        for (int k = 0; k < 2; ++k) {
+            char line[128];
+            std::snprintf(line, sizeof(line), "  %-9s %-8s %8.2f %8.2f %8.2f %8.2f\n",
+                name, kinds[k],
+                rows[k]->getStats().mean() * 60.0,
+                rows[k]->percentile(50.0) * 60.0,
+                rows[k]->percentile(95.0) * 60.0,
+                rows[k]->percentile(99.0) * 60.0);
+            std::cout << line;
+        }
+    }
+}
+
+namespace {
+
+SimulationConfig makeConfig(int numCorporate, int numPremium, int numFree,
+    int numDevices, int maxRequests, int bufferCapacity)
+{
+    SimulationConfig config;
+    config.numCorporate = numCorporate;
+    config.numPremium = numPremium;
+    config.numFree = numFree;
+    config.numDevices = numDevices;
+    config.maxRequests = maxRequests;
+    config.bufferCapacity = bufferCapacity;
+    return config;
+}
+
+// First bytes of a Controller snapshot (the digit is the format version)
+const char SNAPSHOT_MAGIC[8] = { 'M', 'S', 'S', 'S', 'N', 'A', 'P', '7' };
+
+// Stale RENEGE events kept queued before a purge is considered
+const std::size_t RENEGE_PURGE_MIN = 1024;
+
+// Fixed header of a snapshot: the layout the sections below depend on
+struct SnapshotHeader {
+    char magic[8];
+    std::uint64_t seed;
+    std::int32_t sources[PRIORITY_COUNT];
+    std::int32_t devices;
+    std::int32_t bufferCapacity;
+    std::int32_t bufferPolicy; // BufferPolicyKind; also keeps the struct free of padding
+};
+
+static_assert(sizeof(SnapshotHeader) == 40, "SnapshotHeader must not contain padding");
+
+} // namespace
+
+// The seed a Controller snapshot was saved under
+bool readSnapshotSeed(const void* data, std::size_t size, std::uint64_t& seed) {
+    SnapshotReader in(data, size);
+    SnapshotHeader header;
+    if (!in.read(header) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        return false;
+    }
+    seed = header.seed;
+    return true;
+}
+
+template <class BufferType>
+BasicController<BufferType>::BasicController(int numCorporate, int numPremium, int numFree,
+    int numDevices, int maxRequests, int bufferCapacity)
+    : BasicController(makeConfig(numCorporate, numPremium, numFree,
+        numDevices, maxRequests, bufferCapacity))
+{
+}
+
+template <class BufferType>
+BasicController<BufferType>::BasicController(const SimulationConfig& config)
+    : events_(makeEventQueue(config.queueKind)),
+    devices_(config.commonRandomNumbers, config.antithetic),
+    idleDevices_(config.numDevices, config.dispatchPolicy),
+    trace_(config.traceLevel),
+    buffer_(requests_, metrics_, trace_, eventLog_, windows_, config.bufferCapacity,
+        config.bufferPolicy, config.seed, config.antithetic),
+    bufferPolicy_(config.bufferPolicy.kind),
+    rng_(config.seed, streamId(StreamKind::CONTROLLER, 0)),
+    seed_(config.seed),
+    globalRequestId_(0),
+    maxRequests_(config.maxRequests),
+    maxTimeHours_(config.maxTimeHours),
+    lastEventTime_(0.0),
+    nextSummaryTime_(1.0),
+    precision_(config.targetPrecision),
+    checkPrecision_(false),
+    precisionReached_(false),
+    windows_(config.windowHours, config.numDevices),
+    checkpointHours_(0.0),
+    nextCheckpointTime_(std::numeric_limits<double>::infinity()),
+    holdingDevice_(-1),
+    holdDeadline_(0.0),
+    dispatchLevel_(PRIORITY_COUNT - 1),
+    dispatchHolds_(0),
+    abandonment_(config.patience, config.retry, config.seed, config.antithetic),
+    pendingRenege_(0),
+    lostSeen_(0)
+{
+#if defined(MSS_INSTRUMENTATION)
+    live_.attach(metrics_);
+#endif
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        arrivals_[p] = ArrivalProfile(config.arrivals[p]);
+    }
+
+    // Create source objects, or replay a trace in their place
+    if (!config.replayFile.empty()) {
+        std::string error;
+        if (replay_.open(config.replayFile, error)) {
+            devices_.setReplayDemands(replay_.getTrace().getDemands());
+        }
+        else {
+            setupError_ = error;
+        }
+    }
+    sources_.reserve(config.replayFile.empty() ? config.numCorporate + config.numPremium + config.numFree : 0);
+    int sourceIndex = 0;
+    for (int i = 0; config.replayFile.empty() && i < config.numCorporate; ++i) {
+        sources_.emplace_back(Priority::CORPORATE, sourceIndex++, config.seed,
+            arrivals_[static_cast<int>(Priority::CORPORATE)], config.antithetic);
+    }
+    for (int i = 0; config.replayFile.empty() && i < config.numPremium; ++i) {
+        sources_.emplace_back(Priority::PREMIUM, sourceIndex++, config.seed,
+            arrivals_[static_cast<int>(Priority::PREMIUM)], config.antithetic);
+    }
+    for (int i = 0; config.replayFile.empty() && i < config.numFree; ++i) {
+        sources_.emplace_back(Priority::FREE, sourceIndex++, config.seed,
+            arrivals_[static_cast<int>(Priority::FREE)], config.antithetic);
+    }
+
+    // One sampler per device class, built before the devices point at them
+    if (config.deviceClasses.empty()) {
+        serviceModels_.emplace_back(DeviceClass().service);
+    }
+    for (const DeviceClass& deviceClass : config.deviceClasses) {
+        serviceModels_.emplace_back(deviceClass.service);
+    }
+
+    // Create the device table
+    devices_.reserve(config.numDevices);
+    for (int i = 0; i < config.numDevices; ++i) {
+        devices_.add(config.seed, serviceModels_[config.deviceClassOf(i)]);
+    }
+
+    if (setupError_.empty() && !config.windowFile.empty() && !windows_.open(config.windowFile)) {
+        setupError_ = "Cannot write " + config.windowFile;
+    }
+    if (setupError_.empty() && !config.eventLogFile.empty()
+        && !eventLog_.open(config.eventLogFile, config.numDevices)) {
+        setupError_ = "Cannot write " + config.eventLogFile;
+    }
+}
+
+template <class BufferType>
+const std::string& BasicController<BufferType>::getSetupError() const {
+    return setupError_;
+}
+
+template <class BufferType>
+const std::string& BasicController<BufferType>::getRunError() const {
+    return runError_;
+}
+
+template <class BufferType>
+void BasicController<BufferType>::initRequests() {
+    // Initialize first requests for each source at time = 0
+    double startTime = 0.0;
+    for (Source& src : sources_) {
+        if (metrics_.generated() >= maxRequests_) {
+            break;
+        }
+        double interArrival = src.generateInterArrivalTime(startTime);
+        double arrivalTime = startTime + interArrival;
+
+        globalRequestId_++;
+        RequestHandle newReq = src.createRequest(requests_, globalRequestId_, arrivalTime);
+        metrics_.recordGenerated(static_cast<int>(src.getPriority()));
+
+        pushEvent(Event{
+            arrivalTime,
+            newReq,
+            EventType::REQUEST_GENERATED,
+            -1
+            });
+    }
+    if (replay_.isOpen()) {
+        replay_.scheduleNextRequest(*this, startTime);
+    }
+}
+
+template <class BufferType>
+void BasicController<BufferType>::work() {
+    // Continue until we serve at least maxRequests_ requests, or until the
+    // steady-state estimates are precise enough
+    while (metrics_.served() < maxRequests_) {
+        if (events_->empty()) {
+            // No more events => stop
+            if (trace_.enabled(TraceLevel::SUMMARY)) {
+                trace_.write("No more events, simulation ends.\n");
+            }
+            break;
+        }
+
+        Event currentEvent = popEvent();
+        if (currentEvent.time > maxTimeHours_) {
+            // Time limit: the event stays pending, unprocessed
+            pushEvent(currentEvent);
+            if (trace_.enabled(TraceLevel::SUMMARY)) {
+                trace_.write("Time limit reached, simulation ends.\n");
+            }
+            break;
+        }
+        if (currentEvent.time >= nextCheckpointTime_) {
+            // Checkpoint between two events; this one is handled right after
+            pushEvent(currentEvent);
+            if (!saveSnapshot(checkpointPath_) && runError_.empty()) {
+                runError_ = "Cannot write " + checkpointPath_;
+            }
+            nextCheckpointTime_ = (std::floor(currentEvent.time / checkpointHours_) + 1.0) * checkpointHours_;
+            continue;
+        }
+        processEvent(currentEvent);
+
+        // Re-test the stopping rule only when a batch has been completed
+        if (checkPrecision_) {
+            checkPrecision_ = false;
+            if (precision_.satisfied(waitSeries_) && precision_.satisfied(lossSeries_)) {
+                precisionReached_ = true;
+                if (trace_.enabled(TraceLevel::SUMMARY)) {
+                    trace_.write("Precision target reached, simulation ends.\n");
+                }
+                break;
+            }
+        }
+    }
+
+    if (!checkpointPath_.empty() && !saveSnapshot(checkpointPath_) && runError_.empty()) {
+        runError_ = "Cannot write " + checkpointPath_;
+    }
+    if (trace_.enabled(TraceLevel::SUMMARY)) {
+        traceProgress(lastEventTime_);
+    }
+    windows_.finish(lastEventTime_);
+    eventLog_.close();
+    trace_.flush();
+#if defined(MSS_INSTRUMENTATION)
+    publishLiveCounters();
+#endif
+}
+
+#if defined(MSS_INSTRUMENTATION)
+// Publish the queue depth, buffer levels, idle devices and clock
+template <class BufferType>
+void BasicController<BufferType>::publishLiveCounters() {
+    int buffered[PRIORITY_COUNT];
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        buffered[p] = buffer_.size(static_cast<Priority>(p));
+    }
+    live_.publish(events_->size(), buffered, idleDevices_.size(), lastEventTime_);
+}
+#endif
+
+// Write one SUMMARY progress line
+template <class BufferType>
+void BasicController<BufferType>::traceProgress(double currentTime) {
+    char now[6];
+    formatTime(currentTime, now, sizeof(now));
+    trace_.write("[%s, %.1f h] generated %lld, served %lld, rejected %lld, in buffer %d\n",
+        now, currentTime, static_cast<long long>(metrics_.generated()), static_cast<long long>(metrics_.served()),
+        static_cast<long long>(metrics_.lost()), buffer_.size());
+    nextSummaryTime_ = std::floor(currentTime) + 1.0;
+}
+
+// Handle a newly generated request
+template <class BufferType>
+void BasicController<BufferType>::handleRequestGenerated(RequestHandle req, double currentTime) {
+    const Request& request = requests_[req];
+    // Read before the request can be retired below
+    int srcIdx = request.getSourceIndex();
+
+    if (trace_.enabled(TraceLevel::FULL)) {
+        char generated[6];
+        formatTime(currentTime, generated, sizeof(generated));
+        trace_.write("Request %d generated at %s with priority %d.\n",
+            request.getId(), generated, static_cast<int>(request.getPriority()));
+    }
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::ARRIVAL, request.getId(), static_cast<int>(request.getPriority()));
+    }
+    admitRequest(req, currentTime);
+
+    // The requests lost since the previous arrival: at most this one or an
+    // evicted one, plus those that reneged meanwhile
+    std::int64_t lost = metrics_.lost();
+    if (lossSeries_.add(lost - lostSeen_) && precision_.enabled()) {
+        checkPrecision_ = true;
+    }
+    lostSeen_ = lost;
+
+    // Schedule the next request from the same source
+    if (srcIdx >= 0 && srcIdx < static_cast<int>(getSources().size())) {
+        getSources()[srcIdx].scheduleNextRequest(*this, currentTime);
+    }
+    else if (srcIdx == REPLAY_SOURCE_INDEX) {
+        replay_.scheduleNextRequest(*this, currentTime);
+    }
+}
+
+// Handle a rejected, evicted or reneged request coming back
+template <class BufferType>
+void BasicController<BufferType>::handleRequestRetry(RequestHandle req, double currentTime) {
+    Request& request = requests_[req];
+    request.retry(currentTime);
+    if (trace_.enabled(TraceLevel::FULL)) {
+        trace_.write("Request %d retries (attempt %d).\n", request.getId(), request.getAttempt() + 1);
+    }
+    admitRequest(req, currentTime);
+}
+
+// Offer an arrival, new or retried, to the buffer and dispatch it
+template <class BufferType>
+void BasicController<BufferType>::admitRequest(RequestHandle req, double currentTime) {
+    windows_.recordArrival();
+    RequestHandle evicted = INVALID_REQUEST;
+    bool admitted = buffer_.addRequest(req, &evicted);
+    if (evicted != INVALID_REQUEST) {
+        retryOrRelease(evicted, currentTime); // may come back, as a rejection
+    }
+    if (!admitted) {
+        const Request& request = requests_[req];
+        if (trace_.enabled(TraceLevel::FULL)) {
+            trace_.write("Request %d rejected.\n", request.getId());
+        }
+        if (eventLog_.isOpen()) {
+            eventLog_.record(currentTime, LogEventType::REJECTED, request.getId(), static_cast<int>(request.getPriority()));
+        }
+        retryOrRelease(req, currentTime);
+        return;
+    }
+
+    // Attempt to load into devices immediately if any are free
+    loadRequestsToFreeDevices(currentTime);
+
+    // Still waiting: its patience starts
+    Request& request = requests_[req];
+    int level = static_cast<int>(request.getPriority());
+    if (abandonment_.hasPatience(level) && buffer_.contains(req)) {
+        double renegeTime = currentTime + abandonment_.patience(level, request.getId(), request.getAttempt());
+        request.setRenegeTime(renegeTime);
+        pushEvent(Event{
+            renegeTime,
+            req,
+            EventType::RENEGE,
+            -1
+            });
+        pendingRenege_++;
+    }
+}
+
+// Send a rejected, evicted or reneged request back after its backoff, or retire it
+template <class BufferType>
+void BasicController<BufferType>::retryOrRelease(RequestHandle req, double currentTime) {
+    const Request& request = requests_[req];
+    if (!abandonment_.retries(request.getId(), request.getAttempt())) {
+        requests_.release(req);
+        return;
+    }
+    // The slot stays taken through the backoff
+    metrics_.recordRetried(static_cast<int>(request.getPriority()));
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::RETRY, request.getId(), static_cast<int>(request.getPriority()));
+    }
+    pushEvent(Event{
+        currentTime + abandonment_.backoff(request.getId(), request.getAttempt()),
+        req,
+        EventType::REQUEST_RETRY,
+        -1
+        });
+}
+
+// The RENEGE is of its request's current stay in the buffer: a request
+// served, evicted or retired since, or a recycled slot, fails one of the tests
+template <class BufferType>
+bool BasicController<BufferType>::isLiveRenege(const Event& ev) const {
+    return buffer_.contains(ev.request) && requests_[ev.request].getRenegeTime() == ev.time;
+}
+
+// Handle a request whose patience ran out (processEvent drops stale timers)
+template <class BufferType>
+void BasicController<BufferType>::handleRenege(RequestHandle req, double currentTime) {
+    pendingRenege_--;
+    buffer_.removeRequest(req);
+    const Request& request = requests_[req];
+    int level = static_cast<int>(request.getPriority());
+    metrics_.recordReneged(level);
+    windows_.recordRejection(level);
+    if (trace_.enabled(TraceLevel::FULL)) {
+        trace_.write("Request %d reneged after %.1f min.\n", request.getId(),
+            (currentTime - request.getBufferEnterTime()) * 60.0);
+    }
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::RENEGED, request.getId(), level);
+    }
+    retryOrRelease(req, currentTime);
+}
+
+// Drop the stale RENEGE events once they are most of the queue: each
+// purge drains and refills the queue, O(n log n), and is only due after
+// n / 2 more stale timers, so it costs O(log n) per cancellation
+template <class BufferType>
+void BasicController<BufferType>::purgeStaleRenege() {
+    std::size_t live = 0;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (abandonment_.hasPatience(p)) {
+            live += buffer_.size(static_cast<Priority>(p));
+        }
+    }
+    // Requests moved in from another Controller may wait without a timer
+    // counted here, so live can exceed the count
+    std::size_t stale = pendingRenege_ > live ? pendingRenege_ - live : 0;
+    if (stale < RENEGE_PURGE_MIN || 2 * stale < events_->size()) {
+        return;
+    }
+    std::vector<Event> pending;
+    pending.reserve(events_->size() - stale);
+    std::size_t kept = 0;
+    while (!events_->empty()) {
+        Event ev = events_->pop();
+        if (ev.type != EventType::RENEGE || isLiveRenege(ev)) {
+            kept += (ev.type == EventType::RENEGE) ? 1 : 0;
+            pending.push_back(ev);
+        }
+    }
+    for (const Event& ev : pending) {
+        events_->push(ev);
+    }
+    pendingRenege_ = kept;
+}
+
+// Handle the completion of a request
+template <class BufferType>
+void BasicController<BufferType>::handleRequestFinished(int deviceId, double currentTime, RequestHandle req) {
+    // The device frees itself once the last request of its batch is done
+    Device device = getDevice(deviceId);
+    if (device.freeDevice(req, currentTime)) {
+        idleDevices_.release(deviceId - 1, device.getBusyTotalTime());
+    }
+    // The request is done: record its sojourn and recycle its slot
+    const Request& request = requests_[req];
+    latency_[static_cast<int>(request.getPriority())].sojourn.record(currentTime - request.getArrivalTime());
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::SERVICE_END, request.getId(),
+            static_cast<int>(request.getPriority()), deviceId);
+    }
+    requests_.release(req);
+    // Load next request from the buffer
+    loadRequestsToFreeDevices(currentTime);
+}
+
+// Process the events before endTime (and not after maxTimeHours); returns
+// the time of the next pending event, or infinity when none is left
+template <class BufferType>
+double BasicController<BufferType>::workUntil(double endTime) {
+    while (!events_->empty()) {
+        Event currentEvent = popEvent();
+        if (currentEvent.time >= endTime || currentEvent.time > maxTimeHours_) {
+            pushEvent(currentEvent);
+            return (currentEvent.time > maxTimeHours_)
+                ? std::numeric_limits<double>::infinity() : currentEvent.time;
+        }
+        processEvent(currentEvent);
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+// Advance the clock to one event and handle it
+template <class BufferType>
+void BasicController<BufferType>::processEvent(const Event& currentEvent) {
+#if defined(MSS_INSTRUMENTATION)
+    if (live_.tick()) {
+        publishLiveCounters();
+    }
+#endif
+    // A stale timer is no event of the model: it leaves the clock alone
+    if (currentEvent.type == EventType::RENEGE && !isLiveRenege(currentEvent)) {
+        pendingRenege_--;
+        return;
+    }
+    double currentTime = currentEvent.time;
+    updateLastEventTime(currentTime);
+    windows_.advance(currentTime);
+
+    if (currentTime >= nextSummaryTime_ && trace_.enabled(TraceLevel::SUMMARY)) {
+        traceProgress(currentTime);
+    }
+
+    if (currentEvent.type == EventType::REQUEST_GENERATED) {
+        handleRequestGenerated(currentEvent.request, currentTime);
+    }
+    else if (currentEvent.type == EventType::REQUEST_SERVED) {
+        handleRequestFinished(currentEvent.deviceId, currentTime, currentEvent.request);
+    }
+    else if (currentEvent.type == EventType::BATCH_TIMEOUT) {
+        handleBatchTimeout(currentEvent.deviceId, currentTime);
+    }
+    else if (currentEvent.type == EventType::RENEGE) {
+        handleRenege(currentEvent.request, currentTime);
+    }
+    else if (currentEvent.type == EventType::REQUEST_RETRY) {
+        handleRequestRetry(currentEvent.request, currentTime);
+    }
+    if (pendingRenege_ > RENEGE_PURGE_MIN) {
+        purgeStaleRenege();
+    }
+    windows_.setLevels(getBusyDeviceCount(), buffer_.size());
+}
+
+// Move up to `count` buffered requests of victim into this Controller and
+// dispatch them at currentTime
+template <class BufferType>
+int BasicController<BufferType>::stealRequests(BasicController& victim, int count, double currentTime, int level,
+    bool newest) {
+    int moved = 0;
+    bool refused = false;
+    updateLastEventTime(currentTime);
+    windows_.advance(currentTime);
+    victim.windows_.advance(currentTime);
+    // Only into free places, so no stolen request is evicted or rejected
+    while (moved < count && buffer_.size() < buffer_.getCapacity()) {
+        RequestHandle theirs = (level < 0) ? victim.buffer_.popRequest()
+            : newest ? victim.buffer_.popNewest(static_cast<Priority>(level))
+            : victim.buffer_.popRequest(static_cast<Priority>(level));
+        if (theirs == INVALID_REQUEST) {
+            break;
+        }
+        // The copy keeps its buffer enter time and attempt, so its wait is
+        // measured from when it first entered the victim's buffer
+        const Request& request = victim.requests_[theirs];
+        RequestHandle mine = requests_.acquire(request.getId(), request.getPriority(),
+            request.getArrivalTime(), request.getSourceIndex());
+        requests_[mine] = victim.requests_[theirs];
+        victim.requests_.release(theirs);
+        if (!buffer_.addRequest(mine)) {
+            // Only a policy other than the default refuses a free place: the
+            // buffer has counted it as rejected, so retire it and stop
+            requests_.release(mine);
+            refused = true;
+            break;
+        }
+        moved++;
+    }
+    if (moved > 0 || refused) {
+        loadRequestsToFreeDevices(currentTime);
+        windows_.setLevels(getBusyDeviceCount(), buffer_.size());
+        victim.windows_.setLevels(victim.getBusyDeviceCount(), victim.buffer_.size());
+    }
+    return moved;
+}
+
+// Keep up to `holds` devices idle rather than start a request below priority level
+template <class BufferType>
+void BasicController<BufferType>::setDispatchLevel(int level, int holds, double currentTime) {
+    dispatchLevel_ = level;
+    dispatchHolds_ = holds;
+    if (!buffer_.isEmpty() && idleDevices_.size() > 0) {
+        updateLastEventTime(currentTime);
+        windows_.advance(currentTime);
+        loadRequestsToFreeDevices(currentTime);
+        windows_.setLevels(getBusyDeviceCount(), buffer_.size());
+    }
+}
+
+// Whether a request of priority level or higher is buffered
+template <class BufferType>
+bool BasicController<BufferType>::waitsUpTo(int level) const {
+    if (level >= PRIORITY_COUNT - 1) {
+        return true;
+    }
+    for (int p = 0; p <= level; ++p) {
+        if (buffer_.size(static_cast<Priority>(p)) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Number of devices without a request
+template <class BufferType>
+int BasicController<BufferType>::getIdleDeviceCount() const {
+    return idleDevices_.size();
+}
+
+// Write the full state between two events to a snapshot file
+template <class BufferType>
+bool BasicController<BufferType>::saveSnapshot(const std::string& path) {
+    SnapshotWriter out;
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.seed = seed_;
+    for (const Source& src : sources_) {
+        header.sources[static_cast<int>(src.getPriority())]++;
+    }
+    header.devices = devices_.size();
+    header.bufferCapacity = buffer_.getCapacity();
+    header.bufferPolicy = static_cast<std::int32_t>(bufferPolicy_);
+    out.write(header);
+
+    out.write(globalRequestId_);
+    metrics_.save(out);
+    out.write(lastEventTime_);
+    out.write(nextSummaryTime_);
+    out.write(checkPrecision_);
+    out.write(precisionReached_);
+    out.write(holdingDevice_);
+    out.write(holdDeadline_);
+    out.write(lostSeen_);
+    out.write(rng_);
+
+    // The queues cannot be iterated: drain in time order and refill
+    std::vector<Event> pending;
+    pending.reserve(events_->size());
+    while (!events_->empty()) {
+        pending.push_back(events_->pop());
+    }
+    for (const Event& ev : pending) {
+        events_->push(ev);
+    }
+    out.writeVector(pending);
+
+    requests_.save(out);
+    buffer_.save(out);
+    devices_.save(out);
+    idleDevices_.save(out);
+    for (const Source& src : sources_) {
+        src.save(out);
+    }
+    replay_.save(out);
+    for (const LatencyStats& latency : latency_) {
+        latency.save(out);
+    }
+    waitSeries_.save(out);
+    lossSeries_.save(out);
+    windows_.save(out);
+
+    // Everything traced so far precedes the snapshot
+    trace_.flush();
+    return out.save(path);
+}
+
+// Continue from a snapshot instead of calling initRequests()
+template <class BufferType>
+bool BasicController<BufferType>::restoreSnapshot(const void* data, std::size_t size, std::string& error) {
+    if (!events_->empty() || metrics_.generated() != 0) {
+        error = "a snapshot can only be restored into a Controller that has not started";
+        return false;
+    }
+    SnapshotReader in(data, size);
+    SnapshotHeader header;
+    if (!in.read(header) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a snapshot of this version";
+        return false;
+    }
+    int sources[PRIORITY_COUNT] = {};
+    for (const Source& src : sources_) {
+        sources[static_cast<int>(src.getPriority())]++;
+    }
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        if (header.sources[p] != sources[p]) {
+            error = "the snapshot has a different number of sources";
+            return false;
+        }
+    }
+    if (header.devices != devices_.size() || header.bufferCapacity != buffer_.getCapacity()) {
+        error = "the snapshot has a different number of devices or buffer capacity";
+        return false;
+    }
+    if (header.bufferPolicy != static_cast<std::int32_t>(bufferPolicy_)) {
+        error = "the snapshot has a different buffer policy";
+        return false;
+    }
+
+    std::vector<Event> pending;
+    bool ok = in.read(globalRequestId_) && metrics_.load(in) && in.read(lastEventTime_) && in.read(nextSummaryTime_) && in.read(checkPrecision_)
+        && in.read(precisionReached_) && in.read(holdingDevice_) && in.read(holdDeadline_) && in.read(lostSeen_) && in.read(rng_) && in.readVector(pending)
+        && requests_.load(in) && buffer_.load(in) && devices_.load(in) && idleDevices_.load(in);
+    for (std::size_t i = 0; ok && i < sources_.size(); ++i) {
+        ok = sources_[i].load(in);
+    }
+    ok = ok && replay_.load(in);
+    for (int p = 0; ok && p < PRIORITY_COUNT; ++p) {
+        ok = latency_[p].load(in);
+    }
+    ok = ok && waitSeries_.load(in) && lossSeries_.load(in) && windows_.load(in) && in.remaining() == 0
+        && holdingDevice_ >= -1 && holdingDevice_ < devices_.size();
+    if (!ok) {
+        error = "the snapshot is damaged, or its dispatch policy, window width or replayed trace differ";
+        return false;
+    }
+
+    for (const Event& ev : pending) {
+        bool served = ev.type == EventType::REQUEST_SERVED;
+        bool timeout = ev.type == EventType::BATCH_TIMEOUT;
+        if ((!timeout && ev.request >= requests_.capacity())
+            || ((served || timeout) && (ev.deviceId < 1 || ev.deviceId > devices_.size()))) {
+            error = "the snapshot has an event of an unknown request or device";
+            return false;
+        }
+        pendingRenege_ += (ev.type == EventType::RENEGE) ? 1 : 0;
+        pushEvent(ev);
+    }
+
+    // Another seed forks the run: every stream restarts under it
+    if (header.seed != seed_) {
+        rng_.seed(seed_, streamId(StreamKind::CONTROLLER, 0));
+        for (Source& src : sources_) {
+            src.reseed(seed_);
+        }
+        devices_.reseed(seed_);
+        abandonment_.reseed(seed_);
+    }
+    if (checkpointHours_ > 0.0) {
+        nextCheckpointTime_ = (std::floor(lastEventTime_ / checkpointHours_) + 1.0) * checkpointHours_;
+    }
+    return true;
+}
+
+// Same, read from a memory-mapped file
+template <class BufferType>
+bool BasicController<BufferType>::restoreSnapshot(const std::string& path, std::string& error) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    if (!restoreSnapshot(file.data(), file.size(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+// Save a snapshot to path when work() stops and every `everyHours`
+// simulated hours before that (never when everyHours <= 0)
+template <class BufferType>
+void BasicController<BufferType>::setCheckpoint(const std::string& path, double everyHours) {
+    checkpointPath_ = path;
+    checkpointHours_ = std::max(0.0, everyHours);
+    nextCheckpointTime_ = (checkpointHours_ > 0.0)
+        ? (std::floor(lastEventTime_ / checkpointHours_) + 1.0) * checkpointHours_
+        : std::numeric_limits<double>::infinity();
+}
+
+template <class BufferType>
+void BasicController<BufferType>::printStatistics() {
+    MetricsSnapshot metrics = metrics_.snapshot();
+    std::cout << "\n--- Final statistics ---\n";
+    std::cout << "Total requests generated:  " << metrics.total.generated << "\n";
+    std::cout << "Total requests served:     " << metrics.total.served << "\n";
+    std::cout << "Total rejected requests:   " << metrics.total.lost() << "\n";
+
+    std::cout << "Rejected Corporate: " << metrics.byPriority[static_cast<int>(Priority::CORPORATE)].lost() << "\n";
+    std::cout << "Rejected Premium:   " << metrics.byPriority[static_cast<int>(Priority::PREMIUM)].lost() << "\n";
+    std::cout << "Rejected Free:      " << metrics.byPriority[static_cast<int>(Priority::FREE)].lost() << "\n";
+    if (abandonment_.anyPatience() || abandonment_.anyRetries()) {
+        // Included above when they are not retried
+        std::cout << "Reneged attempts:   " << metrics.total.reneged << "\n";
+        std::cout << "Retried attempts:   " << metrics.total.retried << "\n";
+    }
+
+    double avgWaitTime = 0.0;
+    if (metrics.total.served > 0) {
+        avgWaitTime = metrics.total.waitHours / (double)metrics.total.served;
+    }
+    std::cout << "Average waiting time (hours): " << avgWaitTime
+        << " (~" << (avgWaitTime * 60.0) << " min)\n";
+    printLatencyStatistics(latency_);
+    if (precision_.enabled()) {
+        printSteadyState();
+    }
+    printPeakWindows();
+
+    std::cout << "\nDevices utilization:\n";
+    for (int i = 0; i < devices_.size(); ++i) {
+        double busyTime = devices_.getBusyTotalTime(i);
+        double utilization = (lastEventTime_ > 0.0)
+            ? (busyTime / lastEventTime_)
+            : 0.0;
+
+        std::cout << "  Device " << (i + 1)
+            << ": busy " << busyTime << " h, load "
+            << (utilization * 100.0) << " %\n";
+    }
+
+    std::cout << "\nTotal simulation time: " << lastEventTime_ << " hours\n";
+}
+
+// Print the steady-state estimates of the precision stopping rule
+template <class BufferType>
+void BasicController<BufferType>::printSteadyState() const {
+    SteadyStateEstimate wait = waitSeries_.estimate();
+    SteadyStateEstimate loss = lossSeries_.estimate();
+    std::cout << "\nSteady state (MSER-5 truncation, batch means, 95% CI):\n";
+    std::cout << "  Waiting time (min): " << wait.mean * 60.0 << " +/- " << wait.halfWidth * 60.0
+        << " (warm-up " << wait.truncated << " of " << wait.observations << " requests)\n";
+    std::cout << "  Rejection rate (%): " << loss.mean * 100.0 << " +/- " << loss.halfWidth * 100.0
+        << " (warm-up " << loss.truncated << " of " << loss.observations << " arrivals)\n";
+    std::cout << "  Stopped by: " << (precisionReached_
+        ? "relative precision target" : "request limit") << "\n";
+}
+
+// Print the busiest and the most rejecting window
+template <class BufferType>
+void BasicController<BufferType>::printPeakWindows() const {
+    if (windows_.getWindowCount() == 0) {
+        return;
+    }
+    const WindowMetrics& busiest = windows_.getPeakUtilization();
+    const WindowMetrics& rejecting = windows_.getPeakRejection();
+    char start[6];
+
+    std::cout << "\nPeak windows (" << windows_.getWidth() << " h, "
+        << windows_.getWindowCount() << " windows):\n";
+    formatTime(busiest.start, start, sizeof(start));
+    std::cout << "  Utilization: " << (windows_.utilization(busiest) * 100.0)
+        << " % in the window at " << busiest.start << " h (" << start << "), "
+        << busiest.rejected << " of " << busiest.arrivals << " arrivals rejected\n";
+    formatTime(rejecting.start, start, sizeof(start));
+    std::cout << "  Rejections:  " << rejecting.rejected << " of " << rejecting.arrivals
+        << " arrivals in the window at " << rejecting.start << " h (" << start << "), utilization "
+        << (windows_.utilization(rejecting) * 100.0) << " %\n";
+}
+
+// The same statistics as a value (safe to call from any thread after work())
+template <class BufferType>
+SimulationResults BasicController<BufferType>::getResults() const {
+    SimulationResults results;
+    MetricsSnapshot metrics = metrics_.snapshot();
+    results.generatedRequests = metrics.total.generated;
+    results.servedRequests = metrics.total.served;
+    results.rejectedRequests = metrics.total.lost();
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        results.rejectedByPriority[p] = metrics.byPriority[p].lost();
+        results.latency[p] = latency_[p];
+    }
+    if (metrics.total.served > 0) {
+        results.averageWaitTime = metrics.total.waitHours / (double)metrics.total.served;
+    }
+    results.simulationTime = lastEventTime_;
+    results.steadyWait = waitSeries_.estimate();
+    results.steadyLoss = lossSeries_.estimate();
+    results.precisionReached = precisionReached_;
+    results.peakUtilization = windows_.utilization(windows_.getPeakUtilization());
+    const WindowMetrics& peak = windows_.getPeakRejection();
+    results.peakRejectionRate = (peak.arrivals > 0) ? static_cast<double>(peak.rejected) / peak.arrivals : 0.0;
+
+    results.deviceBusyTime.reserve(devices_.size());
+    results.deviceUtilization.reserve(devices_.size());
+    for (int i = 0; i < devices_.size(); ++i) {
+        double busyTime = devices_.getBusyTotalTime(i);
+        results.deviceBusyTime.push_back(busyTime);
+        results.deviceUtilization.push_back(
+            (lastEventTime_ > 0.0) ? (busyTime / lastEventTime_) : 0.0);
+    }
+    return results;
+}
+
+template <class BufferType>
+void BasicController<BufferType>::setTraceLevel(TraceLevel level) {
+    trace_.setLevel(level);
+}
+
+template <class BufferType>
+TraceSink& BasicController<BufferType>::getTrace() {
+    return trace_;
+}
+
+template <class BufferType>
+RequestPool& BasicController<BufferType>::getRequestPool() {
+    return requests_;
+}
+
+template <class BufferType>
+BufferType& BasicController<BufferType>::getBuffer() {
+    return buffer_;
+}
+
+// Counters of the run
+template <class BufferType>
+SimulationMetrics& BasicController<BufferType>::getMetrics() {
+    return metrics_;
+}
+
+template <class BufferType>
+const SimulationMetrics& BasicController<BufferType>::getMetrics() const {
+    return metrics_;
+}
+
+template <class BufferType>
+const LatencyStats& BasicController<BufferType>::getLatency(Priority p) const {
+    return latency_[static_cast<int>(p)];
+}
+
+// Requests of a priority rejected or evicted
+template <class BufferType>
+std::int64_t BasicController<BufferType>::getRejectedByPriority(Priority p) const {
+    return metrics_.snapshot().byPriority[static_cast<int>(p)].lost();
+}
+
+template <class BufferType>
+std::int64_t BasicController<BufferType>::getServedRequestsCount() const {
+    return metrics_.served();
+}
+
+// Switch the event-queue backend (pending events are carried over)
+template <class BufferType>
+void BasicController<BufferType>::setEventQueue(EventQueueKind kind) {
+    std::unique_ptr<EventQueue> queue = makeEventQueue(kind);
+    while (!events_->empty()) {
+        queue->push(events_->pop());
+    }
+    events_ = std::move(queue);
+}
+
+template <class BufferType>
+void BasicController<BufferType>::pushEvent(const Event& ev) {
+    events_->push(ev);
+}
+
+template <class BufferType>
+bool BasicController<BufferType>::eventsEmpty() const {
+    return events_->empty();
+}
+
+template <class BufferType>
+Event BasicController<BufferType>::popEvent() {
+    return events_->pop();
+}
+
+template <class BufferType>
+int& BasicController<BufferType>::getGlobalRequestIdRef() {
+    return globalRequestId_;
+}
+
+template <class BufferType>
+int BasicController<BufferType>::getGlobalRequestId() const {
+    return globalRequestId_;
+}
+
+template <class BufferType>
+int BasicController<BufferType>::getMaxRequests() const {
+    return maxRequests_;
+}
+
+template <class BufferType>
+DeviceTable& BasicController<BufferType>::getDevices() {
+    return devices_;
+}
+
+// View of the device with the given 1-based id
+template <class BufferType>
+Device BasicController<BufferType>::getDevice(int deviceId) {
+    return Device(devices_, deviceId, requests_, trace_);
+}
+
+template <class BufferType>
+std::vector<Source>& BasicController<BufferType>::getSources() {
+    return sources_;
+}
+
+// Choose how idle devices are picked (default: LOWEST_ID)
+template <class BufferType>
+void BasicController<BufferType>::setDispatchPolicy(DispatchPolicy policy) {
+    // Only valid before the run starts, while every device is idle
+    assert(idleDevices_.size() == devices_.size());
+    idleDevices_ = IdleDeviceSet(devices_.size(), policy);
+}
+
+// Fill the idle devices from the buffer. A batching device that finds
+// fewer requests than its limit holds them for up to its batch wait: it
+// starts as soon as enough are buffered, or when its BATCH_TIMEOUT fires.
+// Only the holding device waits; the other idle devices keep serving the
+// buffer. One device holds at a time, so another batching device that
+// finds a short batch meanwhile starts with what there is.
+template <class BufferType>
+void BasicController<BufferType>::loadRequestsToFreeDevices(double currentTime) {
+    if (holdingDevice_ >= 0 && buffer_.size() >= devices_.getBatchLimit(holdingDevice_)) {
+        int index = holdingDevice_;
+        holdingDevice_ = -1;
+        startService(index, currentTime);
+    }
+    while (!buffer_.isEmpty()
+        && (idleDevices_.size() > dispatchHolds_ || waitsUpTo(dispatchLevel_))) {
+        int index = idleDevices_.acquire();
+        if (index < 0) {
+            break;
+        }
+        if (holdingDevice_ < 0 && buffer_.size() < devices_.getBatchLimit(index)
+            && devices_.getBatchWait(index) > 0.0) {
+            holdingDevice_ = index;
+            holdDeadline_ = currentTime + devices_.getBatchWait(index);
+            pushEvent(Event{
+                holdDeadline_,
+                INVALID_REQUEST,
+                EventType::BATCH_TIMEOUT,
+                index + 1
+                });
+            continue;
+        }
+        startService(index, currentTime);
+    }
+}
+
+// Start the device with index on the next batch (up to its limit) of the buffer
+template <class BufferType>
+void BasicController<BufferType>::startService(int index, double currentTime) {
+    int batchSize = std::min(devices_.getBatchLimit(index), buffer_.size());
+    RequestHandle first = buffer_.popRequest();
+    Device device = getDevice(index + 1);
+    device.loadRequest(first, currentTime, batchSize);
+
+    double finishTime = currentTime + device.getServiceTimeHours();
+    beginService(first, device.getId(), currentTime, finishTime);
+    for (int k = 1; k < batchSize; ++k) {
+        beginService(buffer_.popRequest(), device.getId(), currentTime, finishTime);
+    }
+}
+
+// Count one buffered request as served and schedule its completion
+template <class BufferType>
+void BasicController<BufferType>::beginService(RequestHandle req, int deviceId, double currentTime, double finishTime) {
+    Request& request = requests_[req];
+    request.setStartServiceTime(currentTime);
+    double waitTime = currentTime - request.getBufferEnterTime();
+    metrics_.recordServed(static_cast<int>(request.getPriority()), waitTime);
+    latency_[static_cast<int>(request.getPriority())].wait.record(waitTime);
+    windows_.recordServiceStart(waitTime);
+    if (eventLog_.isOpen()) {
+        eventLog_.record(currentTime, LogEventType::SERVICE_START, request.getId(),
+            static_cast<int>(request.getPriority()), deviceId, waitTime);
+    }
+    if (waitSeries_.add(waitTime) && precision_.enabled()) {
+        checkPrecision_ = true;
+    }
+
+    pushEvent(Event{
+        finishTime,
+        req,
+        EventType::REQUEST_SERVED,
+        deviceId
+        });
+}
+
+// Start the holding device with what it has, unless the timer is stale
+template <class BufferType>
+void BasicController<BufferType>::handleBatchTimeout(int deviceId, double currentTime) {
+    int index = deviceId - 1;
+    if (holdingDevice_ != index || holdDeadline_ != currentTime) {
+        return; // the batch filled up before its deadline
+    }
+    holdingDevice_ = -1;
+    if (buffer_.isEmpty()) {
+        // Its requests went to other devices (or were stolen by another shard)
+        idleDevices_.release(index, devices_.getBusyTotalTime(index));
+        return;
+    }
+    startService(index, currentTime);
+    loadRequestsToFreeDevices(currentTime);
+}
+
+// Devices serving a batch (a holding device is neither busy nor idle)
+template <class BufferType>
+int BasicController<BufferType>::getBusyDeviceCount() const {
+    return devices_.size() - idleDevices_.size() - (holdingDevice_ >= 0 ? 1 : 0);
+}
+
+template <class BufferType>
+void BasicController<BufferType>::updateLastEventTime(double t) {
+    if (t > lastEventTime_) {
         lastEventTime_ = t;
     }
-}
\ No newline at end of file
+}
+
+// The event loop of every buffer of BufferPolicyKind
+template class BasicController<Buffer>;
+template class BasicController<FifoBuffer>;
+template class BasicController<DeadlineBuffer>;
+template class BasicController<WeightedFairBuffer>;
+template class BasicController<QuotaBuffer>;
+template class BasicController<EarlyDropBuffer>;
\ No newline at end of file
@@ -2,15 +2,31 @@
 #include <iostream>
 #include <vector>
 #include <queue>
-#include <random>
 #include <cmath>
-#include <map>
 #include <memory>
 #include <algorithm>
 #include <string>
 #include <cstdio>
 #include <cassert>
-#include <deque>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include "Trace.hpp"
+#include "EventQueue.hpp"
+#include "Dispatch.hpp"
+#include "Random.hpp"
+#include "ArrivalProfile.hpp"
+#include "ServiceModel.hpp"
+#include "Statistics.hpp"
+#include "OutputAnalysis.hpp"
+#include "TimeSeries.hpp"
+#include "Snapshot.hpp"
+#include "EventLog.hpp"
+#include "Metrics.hpp"
+#include "ArrivalTrace.hpp"
+#include "BufferPolicy.hpp"
+#include "Abandonment.hpp"
+#include "Instrumentation.hpp"
 
 //------------------------------------------------------------------------------
 // Common simulation constants and helper functions
@@ -28,8 +44,20 @@ enum class Priority {
     FREE       // 2 — lowest
 };
 
+static const int PRIORITY_COUNT = 3;
+static_assert(PRIORITY_COUNT == WINDOW_PRIORITIES, "window metrics track every priority");
+static_assert(PRIORITY_COUNT == METRIC_PRIORITIES, "run counters track every priority");
+static_assert(PRIORITY_COUNT == POLICY_PRIORITIES, "buffer policies are set per priority");
+static_assert(PRIORITY_COUNT == PATIENCE_PRIORITIES, "patience is set per priority");
+static_assert(PRIORITY_COUNT == INSTRUMENT_PRIORITIES, "live gauges track every priority");
+
+// Upper-case name of a priority ("CORPORATE", "PREMIUM", "FREE")
+const char* priorityName(Priority pr);
+
 // Helper for formatting hours into HH:MM
 std::string formatTime(double simulationTimeHours);
+// Same as above, but writes into a caller-provided buffer (at least 6 chars)
+void formatTime(double simulationTimeHours, char* out, std::size_t size);
 
 //------------------------------------------------------------------------------
 // Request class (describes a single request)
@@ -41,8 +69,11 @@ private:
     Priority priority_;
     double arrivalTime_;
     int sourceIndex_;
+    std::uint32_t ringPosition_; // in the buffer ring of its priority (RequestRing::push)
     double bufferEnterTime_;
     double startServiceTime_;
+    double renegeTime_; // when its RENEGE event fires; infinity: no timer
+    int attempt_;       // arrivals before this one (retries)
 
 public:
     // Constructor to initialize a request with id, priority, arrival time, and source index
@@ -60,72 +91,386 @@ public:
 
     void setStartServiceTime(double t);
     double getStartServiceTime() const;
-};
 
-// Forward declaration of Controller
-class Controller;
+    void setRingPosition(std::uint32_t position) { ringPosition_ = position; }
+    std::uint32_t getRingPosition() const { return ringPosition_; }
+    void setRenegeTime(double t);
+    double getRenegeTime() const;
+
+    // Come back at t as the next attempt: it enters the buffer anew
+    void retry(double t);
+    int getAttempt() const;
+};
 
 //------------------------------------------------------------------------------
-// Buffer class (fixed-size queue with priority-based insertion/eviction)
+// RequestPool class (recycled storage for requests, addressed by handles)
 //------------------------------------------------------------------------------
 
-static const int BUFFER_SIZE = 8;
-
-class Buffer {
+// RequestHandle (a 32-bit slot index) is declared in EventQueue.hpp
+class RequestPool {
 private:
-    std::deque<std::shared_ptr<Request>> requests_;
+    std::vector<Request> slots_;
+    std::vector<RequestHandle> freeSlots_;
 
 public:
-    explicit Buffer(Controller* controller);
-    Controller* controller_;
+    // Take a slot (a recycled one if available) and initialize the request in it
+    RequestHandle acquire(int id, Priority priority, double arrivalTime, int sourceIndex);
+    // Return a retired request's slot to the free list
+    void release(RequestHandle handle);
+
+    // Access a live request; references stay valid until the next acquire()
+    Request& operator[](RequestHandle handle);
+    const Request& operator[](RequestHandle handle) const;
+
+    // Number of slots ever allocated / currently holding live requests
+    std::size_t capacity() const;
+    std::size_t inUse() const;
+
+    // Write every slot and the free list to a snapshot / read them back
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
 
-    // Add a request to the buffer with priority-based insertion
-    bool addRequest(const std::shared_ptr<Request>& req);
-    // Pop a request from the front of the buffer
-    std::shared_ptr<Request> popRequest();
-    // Check if the buffer is empty
+//------------------------------------------------------------------------------
+// RequestRing class (FIFO of request handles with O(1) cancellation)
+//------------------------------------------------------------------------------
+
+// Elements are numbered by position, the pushes before them, so a request
+// that keeps its position can be cancelled in place: its slot becomes
+// INVALID_REQUEST and is skipped once it reaches the head. The head is
+// always a live element. Without cancellations the ring never outgrows
+// the capacity it is built with; with them it doubles when full.
+class RequestRing {
+private:
+    std::vector<RequestHandle> slots_;
+    int head_;
+    int count_;     // elements from the head to the back, cancelled ones included
+    int cancelled_; // cancelled elements behind the head
+    std::uint32_t headPosition_;
+
+    // Slot of the element `offset` places behind the head
+    int slotAt(int offset) const {
+        int slot = head_ + offset;
+        return (slot >= static_cast<int>(slots_.size())) ? slot - static_cast<int>(slots_.size()) : slot;
+    }
+    // Drop the head, then any cancelled elements that reach it
+    void advance();
+    // Double the slots, keeping the positions
+    void grow();
+
+public:
+    explicit RequestRing(int capacity = 0);
+
+    // Append at the back; returns the position of the new element
+    std::uint32_t push(RequestHandle req);
+    // Remove the oldest element; the ring must not be empty
+    RequestHandle pop();
+    // Remove the newest element; the ring must not be empty
+    RequestHandle popBack();
+    // The oldest element, left in place; the ring must not be empty
+    RequestHandle front() const { return slots_[head_]; }
+    // The newest element, left in place; the ring must not be empty
+    RequestHandle back() const;
+    // Remove the element at a position holds() is true for
+    void cancel(std::uint32_t position);
+    // The element at position is req
+    bool holds(std::uint32_t position, RequestHandle req) const;
     bool isEmpty() const;
+    // Number of live elements
+    int size() const;
+
+    // Write the elements oldest first / read them back
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
 };
 
 //------------------------------------------------------------------------------
-// Two event types in the controller
+// Buffer policies (template parameters of BasicBuffer)
 //------------------------------------------------------------------------------
+//
+// Each policy is a small class built from (spec, capacity, seed, antithetic)
+// whose hooks the buffer calls directly, so they inline into its code:
+//   Admission: bool admit(rings, size, request) - may the arrival enter?
+//   Eviction:  bool evicts(victim, level) - may a full buffer drop the oldest
+//              request of priority victim for an arrival of priority level?
+//   Order:     void pushed(level, wasEmpty) - a request entered ring level;
+//              int take(rings, pool) - the ring the next pop takes from
+// All three save and load whatever state they keep between events.
+
+// Admit every arrival; the buffer still rejects when it has no room
+class AdmitAll {
+public:
+    AdmitAll(const BufferPolicySpec&, int, std::uint64_t, bool) {}
+    bool admit(const RequestRing (&)[PRIORITY_COUNT], int, const Request&) { return true; }
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// Admit while the arrival's priority holds fewer than its quota of places
+class PriorityQuota {
+private:
+    int quota_[PRIORITY_COUNT]; // places, at least one
 
-enum class EventType {
-    REQUEST_GENERATED, // A new request arrived (generated)
-    REQUEST_SERVED     // A request finished service
+public:
+    PriorityQuota(const BufferPolicySpec& spec, int capacity, std::uint64_t seed, bool antithetic);
+    bool admit(const RequestRing (&rings)[PRIORITY_COUNT], int size, const Request& req);
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
 };
 
-// Event structure
-struct Event {
-    EventType type;
-    double time;
-    std::shared_ptr<Request> request;
-    int deviceId; // used for REQUEST_SERVED to indicate which device
+// Random early drop against the occupancy averaged over the arrivals. Each
+// decision is the uniform keyed by (seed, request id), so configs compared
+// on one seed drop the same requests where their averages agree.
+class EarlyDrop {
+private:
+    double start_;       // average occupancy where dropping starts
+    double full_;        // ... and where it reaches the full probability
+    double probability_[PRIORITY_COUNT];
+    double averaging_;   // weight of the newest occupancy in the average
+    double average_;
+    std::uint64_t seed_;
+    bool antithetic_;
 
-    bool operator<(const Event& other) const {
-        // We want the earliest event first, so invert comparison
-        return time > other.time;
-    }
+public:
+    EarlyDrop(const BufferPolicySpec& spec, int capacity, std::uint64_t seed, bool antithetic);
+    bool admit(const RequestRing (&rings)[PRIORITY_COUNT], int size, const Request& req);
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+// A full buffer drops the oldest request of the lowest priority below the arrival's
+class EvictLowerPriority {
+public:
+    EvictLowerPriority(const BufferPolicySpec&, int, std::uint64_t, bool) {}
+    bool evicts(int victim, int level) const { return victim > level; }
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// A full buffer rejects the arrival
+class NoEviction {
+public:
+    NoEviction(const BufferPolicySpec&, int, std::uint64_t, bool) {}
+    bool evicts(int, int) const { return false; }
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// Serve the oldest request of the highest priority
+class PriorityOrder {
+public:
+    PriorityOrder(const BufferPolicySpec&, int, std::uint64_t, bool) {}
+    void pushed(int, bool) {}
+    int take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool);
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// Serve the oldest request of any priority
+class ArrivalOrder {
+public:
+    ArrivalOrder(const BufferPolicySpec&, int, std::uint64_t, bool) {}
+    void pushed(int, bool) {}
+    int take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool);
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// Serve the earliest deadline, buffer enter time plus the deadline of the
+// priority; within one ring that is the oldest, so only the heads compete
+class DeadlineOrder {
+private:
+    double deadline_[PRIORITY_COUNT]; // hours
+
+public:
+    DeadlineOrder(const BufferPolicySpec& spec, int capacity, std::uint64_t seed, bool antithetic);
+    void pushed(int, bool) {}
+    int take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool);
+    void save(SnapshotWriter&) const {}
+    bool load(SnapshotReader&) { return true; }
+};
+
+// Weighted fair queuing by stride scheduling (Waldspurger, 1995): each pop
+// serves the waiting priority with the smallest pass and advances its pass
+// by 1 / weight. A priority that was empty restarts at the pass last
+// served, so idle time earns it no credit.
+class WeightedFairOrder {
+private:
+    double stride_[PRIORITY_COUNT];
+    double pass_[PRIORITY_COUNT];
+    double lastPass_;
+
+public:
+    WeightedFairOrder(const BufferPolicySpec& spec, int capacity, std::uint64_t seed, bool antithetic);
+    void pushed(int level, bool wasEmpty);
+    int take(const RequestRing (&rings)[PRIORITY_COUNT], const RequestPool& pool);
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
 };
 
 //------------------------------------------------------------------------------
-// Device class (each device processes requests one at a time)
+// Buffer class (bounded queue with policy-driven admission, eviction and order)
 //------------------------------------------------------------------------------
 
+// Default buffer capacity
+static const int BUFFER_SIZE = 8;
+
+// One FIFO ring per priority, all drawing on a single capacity budget. The
+// policies are template parameters, so every combination is compiled on
+// its own; with the default ones (Buffer) insertion, eviction of the lowest
+// priority and pop are all O(1), as hand-written.
+template <class Admission, class Eviction, class Order>
+class BasicBuffer {
+private:
+    RequestRing rings_[PRIORITY_COUNT];
+    int capacity_;
+    int size_;
+    RequestPool& pool_;
+    // Where rejections and evictions are counted, traced and logged
+    SimulationMetrics& metrics_;
+    TraceSink& trace_;
+    EventLogWriter& eventLog_;
+    WindowRecorder& windows_;
+    Admission admission_;
+    Eviction eviction_;
+    Order order_;
+
+public:
+    BasicBuffer(RequestPool& pool, SimulationMetrics& metrics, TraceSink& trace,
+        EventLogWriter& eventLog, WindowRecorder& windows, int capacity = BUFFER_SIZE,
+        const BufferPolicySpec& policy = BufferPolicySpec(), std::uint64_t seed = 0, bool antithetic = false);
+
+    // Add a request to the buffer if the admission policy lets it in; when
+    // full, the oldest request of the first non-empty priority, lowest
+    // first, that the eviction policy allows is evicted. The evicted
+    // request is handed to the caller through `evicted` (INVALID_REQUEST if
+    // none), who retires it; without `evicted` it is released to the pool.
+    // False if the request is rejected.
+    bool addRequest(RequestHandle req, RequestHandle* evicted = nullptr);
+    // Pop the next request in the order of the policy (INVALID_REQUEST if empty)
+    RequestHandle popRequest();
+    // Pop the oldest request of one priority, bypassing the order policy
+    // (INVALID_REQUEST if none waits)
+    RequestHandle popRequest(Priority priority);
+    // Pop the newest request of one priority (INVALID_REQUEST if none waits)
+    RequestHandle popNewest(Priority priority);
+    // The request is waiting in the buffer (a retired slot is not)
+    bool contains(RequestHandle req) const;
+    // Take a waiting request out of the buffer in O(1), wherever it is;
+    // the caller retires it
+    void removeRequest(RequestHandle req);
+    // The oldest / newest waiting request of a priority (INVALID_REQUEST if none)
+    RequestHandle oldest(Priority priority) const;
+    RequestHandle newest(Priority priority) const;
+    // Evict the oldest waiting request of a priority that has one, as a
+    // full buffer does for a higher arrival (counted and logged); the
+    // caller retires the returned request
+    RequestHandle evictOldest(Priority priority, double currentTime);
+    // Reject the newest waiting request of a priority that has one, as a
+    // full buffer does an arrival it cannot make room for (counted and
+    // retired; the caller logs it)
+    void rejectNewest(Priority priority);
+    // Check if the buffer is empty
+    bool isEmpty() const;
+    // Number of requests currently waiting, of all priorities or of one
+    int size() const;
+    int size(Priority priority) const;
+    int getCapacity() const;
+
+    // Write the queued handles and the policy state to a snapshot / read
+    // them back into a buffer of the same capacity and policies
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+// The default buffer: strict priority order, evicting the lowest priority
+using Buffer = BasicBuffer<AdmitAll, EvictLowerPriority, PriorityOrder>;
+// The buffers of the other kinds of BufferPolicyKind
+using FifoBuffer = BasicBuffer<AdmitAll, NoEviction, ArrivalOrder>;
+using DeadlineBuffer = BasicBuffer<AdmitAll, EvictLowerPriority, DeadlineOrder>;
+using WeightedFairBuffer = BasicBuffer<AdmitAll, EvictLowerPriority, WeightedFairOrder>;
+using QuotaBuffer = BasicBuffer<PriorityQuota, EvictLowerPriority, PriorityOrder>;
+using EarlyDropBuffer = BasicBuffer<EarlyDrop, EvictLowerPriority, PriorityOrder>;
+
+//------------------------------------------------------------------------------
+// Device table (each device processes requests one at a time)
+//------------------------------------------------------------------------------
+
+// State of all devices as parallel arrays indexed by 0-based device index,
+// so a pass over the devices reads only the fields it needs (about 45 bytes
+// per device; 10k devices fit in L2). The random streams are a separate
+// table: they are large and only touched when a service starts. With common
+// random numbers a demand is keyed by request id instead (see start()).
+class DeviceTable {
+private:
+    std::vector<std::uint64_t> busy_;           // bit i: device i is busy
+    std::vector<double> finishTime_;
+    std::vector<double> busyTotal_;
+    std::vector<double> startBusy_;
+    std::vector<double> serviceTime_;           // of the current or last service
+    std::vector<RequestHandle> currentRequest_; // first of the current batch
+    std::vector<int> inService_;                // requests of the batch not yet finished
+    std::vector<const ServiceModel*> service_;  // shared per device class
+    std::vector<VariateStream> rng_;
+    std::uint64_t demandSeed_;
+    bool commonDemands_;
+    bool antithetic_;
+    const double* replayDemands_; // by request id - 1; nullptr: none
+
+public:
+    explicit DeviceTable(bool commonDemands = false, bool antithetic = false);
+
+    // Room for `count` devices without reallocation
+    void reserve(int count);
+    // Append the device with index size(); its service-time stream is fixed
+    // by (seed, device id), and service must outlive the table
+    void add(std::uint64_t seed, const ServiceModel& service);
+    int size() const;
+
+    bool isBusy(int index) const { return (busy_[index >> 6] >> (index & 63)) & 1u; }
+    double getFinishTime(int index) const { return finishTime_[index]; }
+    double getBusyTotalTime(int index) const { return busyTotal_[index]; }
+    double getServiceTimeHours(int index) const { return serviceTime_[index]; }
+    RequestHandle getCurrentRequest(int index) const { return currentRequest_[index]; }
+
+    // Service demands of replayed requests by request id - 1 (the mapped
+    // demand column of an ArrivalTrace); a positive one is used as is
+    void setReplayDemands(const double* demands);
+
+    // Start serving req; returns the generated service time in hours. With
+    // common demands it is the device's quantile of the uniform keyed by
+    // (seed, request id), so any fleet serves a request with the same work
+    // whichever device takes it and whatever was rejected before. A batch
+    // of batchSize requests (req and requestId are its first) takes one
+    // such draw times the class's batch factor.
+    double start(int index, RequestHandle req, int requestId, double currentTimeHours, int batchSize = 1);
+    // End one request of the current service; when it was the last of its
+    // batch, add the service to the busy time and return true
+    bool finish(int index, double timeHours);
+    // Most requests the device serves together (1: no batching)
+    int getBatchLimit(int index) const { return service_[index]->getBatchLimit(); }
+    double getBatchWait(int index) const { return service_[index]->getBatchWait(); }
+
+    // Restart every service-time stream at the beginning of its stream
+    // under another seed
+    void reseed(std::uint64_t seed);
+    // Write the device state and streams to a snapshot / read them back
+    // into a table with the same number of devices (service models stay)
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+// Object-style view of one device of a DeviceTable (id = index + 1).
+// Views are cheap to make and hold no state of their own.
 class Device {
 private:
-    int id_;
-    bool busy_;
-    double finishTime_;
-    double busyTotalTime_;
-    double startBusyTime_;
-    std::shared_ptr<Request> currentRequest_;
-    double serviceTimeHours_;  // to store the generated service time
-    std::mt19937 rng_;
+    DeviceTable* table_;
+    int index_;
+    RequestPool* pool_;
+    TraceSink* trace_;
 
 public:
-    explicit Device(int id);
+    Device(DeviceTable& table, int id, RequestPool& pool, TraceSink& trace);
 
     // Check if the device is busy
     bool isBusy() const;
@@ -134,10 +479,11 @@ public:
     // Get the total busy time of the device
     double getBusyTotalTime() const;
 
-    // Load a request onto the device and generate service time
-    void loadRequest(const std::shared_ptr<Request>& req, double currentTimeHours);
-    // Free the device after completing a request
-    void freeDevice(double timeHours);
+    // Load a request, or the first of a batch of batchSize, onto the device
+    // and generate service time
+    void loadRequest(RequestHandle req, double currentTimeHours, int batchSize = 1);
+    // Complete req; true when it was the last of its batch and the device is free
+    bool freeDevice(RequestHandle req, double timeHours);
 
     // Get the generated service time in hours
     double getServiceTimeHours() const;
@@ -152,68 +498,335 @@ class Source {
 private:
     Priority priority_;
     int sourceIndex_;
-    std::mt19937 rng_;
+    VariateStream rng_;
+    const ArrivalProfile* arrivals_;
 
 public:
-    Source(Priority priority, int sourceIndex);
+    // The arrival stream is fixed by (seed, source index), so it does not
+    // depend on the fleet; the profile is owned by the Controller
+    Source(Priority priority, int sourceIndex, std::uint64_t seed, const ArrivalProfile& arrivals,
+        bool antithetic = false);
 
     // Generate the inter-arrival time for the next request
     double generateInterArrivalTime(double currentTimeHours);
-    // Create a new request
-    std::shared_ptr<Request> createRequest(int requestId, double arrivalTimeHours);
+    // Create a new request in the pool
+    RequestHandle createRequest(RequestPool& pool, int requestId, double arrivalTimeHours);
 
-    // Schedule the next request generation
-    void scheduleNextRequest(Controller& controller, double currentTime);
+    // Schedule the next request generation on a BasicController
+    template <class Host>
+    void scheduleNextRequest(Host& controller, double currentTime);
 
     Priority getPriority() const;
     int getSourceIndex() const;
+
+    // Restart the arrival stream at its beginning under another seed
+    void reseed(std::uint64_t seed);
+    // Write the arrival stream to a snapshot / read it back
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
 };
 
 //------------------------------------------------------------------------------
-// Controller class (manages the simulation events and overall logic)
+// ReplaySource class (replays an arrival trace in place of the sources)
 //------------------------------------------------------------------------------
 
-class Controller {
+// Source index of the requests read from a trace
+static const int REPLAY_SOURCE_INDEX = -2;
+
+// Rows ahead of the replay position that are prefetched (a 4 KB page of
+// each f64 column)
+static const int REPLAY_PREFETCH_ROWS = 512;
+
+// Streams the rows of a mapped ArrivalTrace into the event queue: each
+// arrival schedules the next row, so one trace arrival is pending at a
+// time and no row is ever copied. Request ids are row + 1, which is how
+// the devices find a replayed demand. A row earlier than the one before
+// arrives at that one's time, and a priority past the lowest counts as the
+// lowest, so a trace is never read ahead to be checked.
+class ReplaySource {
 private:
-    std::priority_queue<Event> events_;
-    std::vector<std::unique_ptr<Source>> sources_;
-    std::vector<std::unique_ptr<Device>> devices_;
+    ArrivalTrace trace_;
+    std::uint64_t nextRow_;
+
+public:
+    ReplaySource();
+
+    // Map the trace; false with a message on a bad file
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const;
+    const ArrivalTrace& getTrace() const;
+
+    // Schedule the arrival of the next row (none after the last row or
+    // once the Controller's maxRequests have been generated)
+    template <class Host>
+    void scheduleNextRequest(Host& controller, double currentTime);
+
+    // Write the replay position to a snapshot / read it back
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+//------------------------------------------------------------------------------
+// Scenario parameters and end-of-run results
+//------------------------------------------------------------------------------
 
-    Buffer buffer_;
+// A group of identical devices
+struct DeviceClass {
+    int count = 1;
+    ServiceSpec service = exponentialService(1.0 / SERVICE_RATE);
+};
+
+// Everything needed to construct a Controller: the runtime model that
+// Config.hpp fills from a scenario file and the command line
+struct SimulationConfig {
+    int numCorporate = 2;
+    int numPremium = 4;
+    int numFree = 6;
+    int numDevices = 5;
+    // Device classes in id order; when they cover fewer than numDevices, the
+    // last class repeats. Empty: every device exponential at SERVICE_RATE
+    std::vector<DeviceClass> deviceClasses;
+    int maxRequests = 5000;
+    double maxTimeHours = std::numeric_limits<double>::infinity(); // stop at this simulated time
+    int bufferCapacity = BUFFER_SIZE;
+    std::uint64_t seed = 1; // master seed; every random stream derives from it
+    bool seedGiven = false; // seed was set by --seed or a config file (else a restore keeps the snapshot's)
+    TraceLevel traceLevel = TraceLevel::FULL;
+    EventQueueKind queueKind = EventQueueKind::QUAD_HEAP;
+    DispatchPolicy dispatchPolicy = DispatchPolicy::LOWEST_ID;
+    ArrivalSpec arrivals[PRIORITY_COUNT]; // per-source arrival rate of each priority
+    double targetPrecision = 0.0; // relative 95% half-width to stop at; 0: run to maxRequests
+    double windowHours = 1.0;     // width of the time-series windows
+    std::string windowFile;       // columnar per-window file; empty: none
+    std::string eventLogFile;     // columnar per-request event log; empty: none
+    std::string replayFile;       // ArrivalTrace replayed instead of the sources; empty: none
+    // Admission, eviction and order of the buffer; withController() builds
+    // the Controller of its kind, which reads the parameters
+    BufferPolicySpec bufferPolicy;
+    // Patience of each priority in the buffer, and the retries of the
+    // requests that are rejected or run out of it
+    PatienceSpec patience[PRIORITY_COUNT];
+    RetrySpec retry;
+    // Common random numbers: service demands keyed by request id, not drawn
+    // by devices, so configs with the same seed see the same workload
+    bool commonRandomNumbers = false;
+    // Draw 1 - u for every uniform u; replications then run in antithetic
+    // pairs (2i, 2i + 1) on one seed, the odd one of each pair antithetic
+    bool antithetic = false;
+
+    // Index into deviceClasses of the device with 0-based index (0 when empty)
+    int deviceClassOf(int deviceIndex) const;
+    // Some requests renege or retry
+    bool abandons() const;
+};
+
+// Metrics reported by printStatistics, as values
+struct SimulationResults {
+    std::int64_t generatedRequests = 0;
+    std::int64_t servedRequests = 0;
+    std::int64_t rejectedRequests = 0;
+    std::int64_t rejectedByPriority[PRIORITY_COUNT] = {};
+    double averageWaitTime = 0.0; // hours
+    double simulationTime = 0.0;  // hours
+    std::vector<double> deviceBusyTime;
+    std::vector<double> deviceUtilization;
+    LatencyStats latency[PRIORITY_COUNT]; // wait and sojourn histograms
+    SteadyStateEstimate steadyWait;       // MSER-5 truncated, hours
+    SteadyStateEstimate steadyLoss;       // share of arrivals lost
+    bool precisionReached = false;        // stopped by targetPrecision
+    double peakUtilization = 0.0;         // busiest window
+    double peakRejectionRate = 0.0;       // window with the most rejections
+
+    // Share of generated requests that were rejected or evicted
+    double rejectionRate() const;
+    // Utilization averaged over all devices
+    double meanUtilization() const;
+};
+
+// Print mean, p50, p95 and p99 of wait and sojourn time per priority
+void printLatencyStatistics(const LatencyStats (&latency)[PRIORITY_COUNT]);
+
+// The seed a Controller snapshot was saved under; false if data is not a
+// snapshot of this version
+bool readSnapshotSeed(const void* data, std::size_t size, std::uint64_t& seed);
 
-    std::mt19937 rng_;
+//------------------------------------------------------------------------------
+// Controller class (manages the simulation events and overall logic)
+//------------------------------------------------------------------------------
+
+// The event loop around one buffer type; Controller is the default one.
+// Every member is defined in Simulation.cpp and instantiated there for the
+// buffers of BufferPolicyKind.
+template <class BufferType>
+class BasicController {
+private:
+    std::unique_ptr<EventQueue> events_;
+    ArrivalProfile arrivals_[PRIORITY_COUNT];
+    std::vector<ServiceModel> serviceModels_; // one per device class
+    std::vector<Source> sources_;
+    ReplaySource replay_;
+    DeviceTable devices_;
+    IdleDeviceSet idleDevices_;
+
+    TraceSink trace_;
+    RequestPool requests_;
+    SimulationMetrics metrics_;
+    BufferType buffer_;
+    BufferPolicyKind bufferPolicy_; // recorded in snapshots
+
+    Philox4x32 rng_;
+    std::uint64_t seed_;
     int globalRequestId_;
 
     const int maxRequests_;
-    int generatedRequestsCount_;
-
-    int rejectedRequests_;
-    std::map<Priority, int> rejectedByPriority_;
+    const double maxTimeHours_;
 
-    double totalWaitTime_;
-    int servedRequestsCount_;
+    LatencyStats latency_[PRIORITY_COUNT];
     double lastEventTime_;
+    double nextSummaryTime_;
+
+    // Steady-state series: wait per served request, loss per arrival
+    BatchMeans waitSeries_;
+    BatchMeans lossSeries_;
+    PrecisionRule precision_;
+    bool checkPrecision_;
+    bool precisionReached_;
+
+    WindowRecorder windows_;
+    EventLogWriter eventLog_;
+    std::string setupError_;     // why the constructor could not set up the run
+    std::string runError_;       // the first snapshot work() could not write
+
+    std::string checkpointPath_;
+    double checkpointHours_;
+    double nextCheckpointTime_;
+
+    // Batching device waiting for its partial batch to fill (-1: none) and
+    // when it stops waiting; a BATCH_TIMEOUT for another deadline is stale
+    int holdingDevice_;
+    double holdDeadline_;
+
+    // Lowest priority level an idle device takes from the buffer while at
+    // most dispatchHolds_ devices are idle; a shard lowers it while a
+    // higher priority waits in another shard
+    int dispatchLevel_;
+    int dispatchHolds_;
+
+    // Patience and retries; a RENEGE of a request that has left the buffer
+    // is stale and stays queued (lazy deletion) until it fires or the
+    // stale ones outnumber the other events and are purged
+    Abandonment abandonment_;
+    std::size_t pendingRenege_; // RENEGE events queued, stale ones included
+    std::int64_t lostSeen_;     // lost() at the last fresh arrival
+
+#if defined(MSS_INSTRUMENTATION)
+    // Gauges for a MetricsSampler; last, so it unregisters before the
+    // metrics it reads are destroyed
+    LiveCounters live_;
+    // Publish the queue depth, buffer levels, idle devices and clock
+    void publishLiveCounters();
+#endif
+
+    // Write one SUMMARY progress line
+    void traceProgress(double currentTime);
+    // Start the device with index on the next batch (up to its limit) of the buffer
+    void startService(int index, double currentTime);
+    // Count one buffered request as served and schedule its completion
+    void beginService(RequestHandle req, int deviceId, double currentTime, double finishTime);
+    // Start the holding device with what it has, unless the timer is stale
+    void handleBatchTimeout(int deviceId, double currentTime);
+    // Whether a request of priority level or higher is buffered
+    bool waitsUpTo(int level) const;
+    // Offer an arrival, new or retried, to the buffer and dispatch it; a
+    // request left waiting starts its patience
+    void admitRequest(RequestHandle req, double currentTime);
+    // Send a rejected, evicted or reneged request back after its backoff, or retire it
+    void retryOrRelease(RequestHandle req, double currentTime);
+    // Handle a request whose patience ran out; the timer is live
+    void handleRenege(RequestHandle req, double currentTime);
+    // The RENEGE is of its request's current stay in the buffer
+    bool isLiveRenege(const Event& ev) const;
+    // Drop the stale RENEGE events once they are most of the queue
+    void purgeStaleRenege();
+    // Devices serving a batch (a holding device is neither busy nor idle)
+    int getBusyDeviceCount() const;
+    // Advance the clock to one event and handle it
+    void processEvent(const Event& currentEvent);
+    // Print the steady-state estimates of the precision stopping rule
+    void printSteadyState() const;
+    // Print the busiest and the most rejecting window
+    void printPeakWindows() const;
 
 public:
-    Controller(int numCorporate, int numPremium, int numFree,
-        int numDevices, int maxRequests);
+    explicit BasicController(const SimulationConfig& config);
+    BasicController(int numCorporate, int numPremium, int numFree,
+        int numDevices, int maxRequests, int bufferCapacity = BUFFER_SIZE);
+
+    // Why the config could not be set up as asked (a replay trace that
+    // cannot be read, an output file that cannot be written); empty if it
+    // could. The constructor never prints: the caller checks this first.
+    const std::string& getSetupError() const;
 
     // Initialize the first requests for each source
     void initRequests();
     // Main simulation loop
     void work();
+    // Process the events before endTime (and not after maxTimeHours); returns
+    // the time of the next pending event, or infinity when none is left
+    double workUntil(double endTime);
+    // Write the full state between two events to a snapshot file: the
+    // pending events, requests, buffer, devices, idle set, every random
+    // stream, the metrics and the output statistics. False on a write error.
+    bool saveSnapshot(const std::string& path);
+    // Continue from a snapshot instead of calling initRequests(). The
+    // Controller must be fresh and built with the same sources per
+    // priority, devices, buffer capacity and policy, dispatch policy and
+    // window width; the limits, arrival rates, service models and policy
+    // parameters may differ. If its seed equals the snapshot's, the run
+    // resumes exactly; otherwise every stream restarts under the new seed,
+    // so forks of one warmed-up snapshot are independent. False with a message on a mismatch or a
+    // damaged file; the Controller must then be discarded.
+    bool restoreSnapshot(const void* data, std::size_t size, std::string& error);
+    // Same, read from a memory-mapped file
+    bool restoreSnapshot(const std::string& path, std::string& error);
+    // Save a snapshot to path when work() stops and every `everyHours`
+    // simulated hours before that (never when everyHours <= 0). Each save
+    // replaces the previous one; a run stopped by its time limit keeps the
+    // next event pending, so the snapshot can be run on with a later limit.
+    void setCheckpoint(const std::string& path, double everyHours);
+    // The first snapshot work() failed to write, as "Cannot write PATH";
+    // empty if every save succeeded. The run goes on either way, and
+    // nothing is printed: the caller reports it.
+    const std::string& getRunError() const;
+
     // Print final statistics
     void printStatistics();
+    // The same statistics as a value (safe to call from any thread after work())
+    SimulationResults getResults() const;
+
+    // Select how much the event loop writes (default: FULL)
+    void setTraceLevel(TraceLevel level);
+    TraceSink& getTrace();
+
+    // Storage of all live requests
+    RequestPool& getRequestPool();
+    // The buffer between sources and devices
+    BufferType& getBuffer();
 
-    // Increment the number of rejected requests
-    void incrementRejectedRequests();
-    // Increment the number of rejected requests by priority
-    void incrementRejectedByPriority(Priority pr);
+    // Counters of the run; getMetrics().snapshot() may be called from any
+    // thread while work() runs
+    SimulationMetrics& getMetrics();
+    const SimulationMetrics& getMetrics() const;
 
-    int getRejectedByPriority(Priority p) const;
-    int getServedRequestsCount() const;
+    // Requests of a priority rejected or evicted
+    std::int64_t getRejectedByPriority(Priority p) const;
+    std::int64_t getServedRequestsCount() const;
+    // Wait and sojourn distribution of one priority
+    const LatencyStats& getLatency(Priority p) const;
 
     // Event queue management
+    // Switch the event-queue backend (pending events are carried over)
+    void setEventQueue(EventQueueKind kind);
     void pushEvent(const Event& ev);
     bool eventsEmpty() const;
     Event popEvent();
@@ -221,12 +834,32 @@ public:
     // Request counters
     int& getGlobalRequestIdRef();
     int getGlobalRequestId() const;
-    int& getGeneratedRequestsCountRef();
     int getMaxRequests() const;
 
     // Access to devices and sources
-    std::vector<std::unique_ptr<Device>>& getDevices();
-    std::vector<std::unique_ptr<Source>>& getSources();
+    DeviceTable& getDevices();
+    // View of the device with the given 1-based id
+    Device getDevice(int deviceId);
+    std::vector<Source>& getSources();
+
+    // Choose how idle devices are picked (default: LOWEST_ID); call before initRequests()
+    void setDispatchPolicy(DispatchPolicy policy);
+
+    // Number of devices without a request
+    int getIdleDeviceCount() const;
+    // Move up to `count` buffered requests of victim (in its buffer's order,
+    // or of priority `level` if it is not -1: the oldest, or the newest if
+    // `newest`) into free places of this Controller's buffer and dispatch
+    // them at currentTime. Both event loops must be paused at currentTime;
+    // returns how many moved.
+    int stealRequests(BasicController& victim, int count, double currentTime, int level = -1,
+        bool newest = false);
+
+    // Keep up to `holds` devices idle rather than start a request below
+    // priority level (PRIORITY_COUNT - 1, the default: start any), and
+    // dispatch what that allows at currentTime. Assumes the priority
+    // buffer; not saved in snapshots.
+    void setDispatchLevel(int level, int holds, double currentTime);
 
     // Load requests from buffer to free devices
     void loadRequestsToFreeDevices(double currentTime);
@@ -234,9 +867,47 @@ public:
     // Update the time of the last event
     void updateLastEventTime(double t);
 
-    // Handle the completion of a request
-    void handleRequestFinished(int deviceId, double currentTime, const std::shared_ptr<Request>& req);
+    // Handle the completion of a request (retires it back to the pool)
+    void handleRequestFinished(int deviceId, double currentTime, RequestHandle req);
 
     // Handle a newly generated request
-    void handleRequestGenerated(const std::shared_ptr<Request>& req, double currentTime);
-};
\ No newline at end of file
+    void handleRequestGenerated(RequestHandle req, double currentTime);
+    // Handle a rejected, evicted or reneged request coming back
+    void handleRequestRetry(RequestHandle req, double currentTime);
+};
+
+// The default Controller: strict priority order, evicting the lowest priority
+using Controller = BasicController<Buffer>;
+
+// Build the Controller of config.bufferPolicy.kind and return f(controller).
+// The policy is chosen here, once per run; each kind has its own compiled
+// event loop, so none of them dispatches per event.
+template <class F>
+auto withController(const SimulationConfig& config, F&& f) -> decltype(f(std::declval<Controller&>())) {
+    switch (config.bufferPolicy.kind) {
+    case BufferPolicyKind::FIFO: {
+        BasicController<FifoBuffer> controller(config);
+        return f(controller);
+    }
+    case BufferPolicyKind::DEADLINE: {
+        BasicController<DeadlineBuffer> controller(config);
+        return f(controller);
+    }
+    case BufferPolicyKind::WEIGHTED_FAIR: {
+        BasicController<WeightedFairBuffer> controller(config);
+        return f(controller);
+    }
+    case BufferPolicyKind::QUOTA: {
+        BasicController<QuotaBuffer> controller(config);
+        return f(controller);
+    }
+    case BufferPolicyKind::EARLY_DROP: {
+        BasicController<EarlyDropBuffer> controller(config);
+        return f(controller);
+    }
+    default: {
+        Controller controller(config);
+        return f(controller);
+    }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "Snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------
+// SnapshotWriter class
+//------------------------------------------------------------------------------
+void SnapshotWriter::writeBytes(const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    bytes_.insert(bytes_.end(), bytes, bytes + size);
+}
+
+std::size_t SnapshotWriter::size() const {
+    return bytes_.size();
+}
+
+// Write to path + ".tmp" and rename it over path
+bool SnapshotWriter::save(const std::string& path) const {
+    std::string temporary = path + ".tmp";
+    std::FILE* out = std::fopen(temporary.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    bool written = std::fwrite(bytes_.data(), 1, bytes_.size(), out) == bytes_.size();
+    written = (std::fclose(out) == 0) && written;
+    if (!written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// SnapshotReader class
+//------------------------------------------------------------------------------
+SnapshotReader::SnapshotReader(const void* data, std::size_t size)
+    : data_(static_cast<const char*>(data)),
+    size_(size),
+    offset_(0)
+{
+}
+
+bool SnapshotReader::readBytes(void* out, std::size_t size) {
+    if (size > remaining()) {
+        offset_ = size_;
+        return false;
+    }
+    if (size > 0) {
+        std::memcpy(out, data_ + offset_, size);
+    }
+    offset_ += size;
+    return true;
+}
+
+std::size_t SnapshotReader::remaining() const {
+    return size_ - offset_;
+}
+
+//------------------------------------------------------------------------------
+// MappedFile class
+//------------------------------------------------------------------------------
+MappedFile::MappedFile()
+    : data_(nullptr),
+    size_(0)
+#if defined(_WIN32)
+    , file_(INVALID_HANDLE_VALUE),
+    mapping_(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+    }
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+#else
+    if (data_) {
+        munmap(const_cast<void*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// Map the file; false if it cannot be opened or is empty
+bool MappedFile::open(const std::string& path) {
+    close();
+#if defined(_WIN32)
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER length;
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &length) || length.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data_ = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data_) {
+        close();
+        return false;
+    }
+    size_ = static_cast<std::size_t>(length.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data_ = mapped;
+    size_ = static_cast<std::size_t>(info.st_size);
+#endif
+    return true;
+}
+
+// Tell the OS the mapping will be read front to back
+void MappedFile::adviseSequential() const {
+#if !defined(_WIN32)
+    if (data_) {
+        madvise(const_cast<void*>(data_), size_, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+const void* MappedFile::data() const {
+    return data_;
+}
+
+std::size_t MappedFile::size() const {
+    return size_;
+}
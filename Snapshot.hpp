@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Binary snapshots: flat sections of plain values, read back from a mapping
+//------------------------------------------------------------------------------
+
+// A snapshot is the state of each object written one after another in a
+// fixed order, as raw values in host byte order; arrays are a uint64 count
+// followed by the elements. There are no per-field tags: the reader must
+// ask for the same values in the same order, and the Controller's header
+// (see Controller::saveSnapshot) rejects files of a different layout.
+class SnapshotWriter {
+private:
+    std::vector<char> bytes_;
+
+public:
+    SnapshotWriter() = default;
+
+    void writeBytes(const void* data, std::size_t size);
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values");
+        writeBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void writeVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values");
+        write(static_cast<std::uint64_t>(values.size()));
+        writeBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    std::size_t size() const;
+
+    // Write to path + ".tmp" and rename it over path, so a process killed
+    // while saving leaves the previous snapshot intact
+    bool save(const std::string& path) const;
+};
+
+// Bounds-checked reads over a snapshot in memory. Every read fails once
+// the data runs out, so a truncated file is an error, never a crash.
+class SnapshotReader {
+private:
+    const char* data_;
+    std::size_t size_;
+    std::size_t offset_;
+
+public:
+    SnapshotReader(const void* data, std::size_t size);
+
+    bool readBytes(void* out, std::size_t size);
+
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values");
+        return readBytes(&value, sizeof(T));
+    }
+
+    // Array of exactly `expected` elements (any count when expected < 0)
+    template <typename T>
+    bool readVector(std::vector<T>& values, long long expected = -1) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values");
+        std::uint64_t count = 0;
+        if (!read(count) || count > remaining() / sizeof(T)
+            || (expected >= 0 && count != static_cast<std::uint64_t>(expected))) {
+            return false;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        return readBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    std::size_t remaining() const;
+};
+
+// Read-only memory mapping of a whole file. Restoring reads the state
+// straight out of the page cache, and many processes forking one snapshot
+// share a single copy of it.
+class MappedFile {
+private:
+    const void* data_;
+    std::size_t size_;
+#if defined(_WIN32)
+    void* file_;
+    void* mapping_;
+#endif
+
+    void close();
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file; false if it cannot be opened or is empty
+    bool open(const std::string& path);
+
+    // Tell the OS the mapping will be read front to back, so it reads
+    // ahead and drops pages behind (a hint; no-op where unsupported)
+    void adviseSequential() const;
+
+    const void* data() const;
+    std::size_t size() const;
+};
@@ -0,0 +1,214 @@
+#include "Statistics.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "Snapshot.hpp"
+
+// Two-sided 97.5% quantile of Student's t distribution
+double studentT975(int degreesOfFreedom) {
+    static const double table[] = {
+        0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degreesOfFreedom <= 0) {
+        return 0.0;
+    }
+    if (degreesOfFreedom <= 30) {
+        return table[degreesOfFreedom];
+    }
+    // Cornish-Fisher expansion around the normal quantile
+    const double z = 1.959964;
+    double df = degreesOfFreedom;
+    return z + (z * z * z + z) / (4.0 * df)
+        + (5.0 * std::pow(z, 5) + 16.0 * z * z * z + 3.0 * z) / (96.0 * df * df);
+}
+
+//------------------------------------------------------------------------------
+// RunningStats class
+//------------------------------------------------------------------------------
+RunningStats::RunningStats()
+    : count_(0),
+    mean_(0.0),
+    m2_(0.0),
+    min_(std::numeric_limits<double>::infinity()),
+    max_(-std::numeric_limits<double>::infinity())
+{
+}
+
+// Add one observation
+void RunningStats::add(double value) {
+    count_++;
+    double delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+// Combine with statistics of a disjoint sample
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    double n1 = static_cast<double>(count_);
+    double n2 = static_cast<double>(other.count_);
+    double n = n1 + n2;
+    double delta = other.mean_ - mean_;
+    mean_ += delta * n2 / n;
+    m2_ += other.m2_ + delta * delta * n1 * n2 / n;
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+std::uint64_t RunningStats::count() const {
+    return count_;
+}
+
+double RunningStats::mean() const {
+    return mean_;
+}
+
+double RunningStats::variance() const {
+    return (count_ > 1) ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+double RunningStats::min() const {
+    return (count_ > 0) ? min_ : 0.0;
+}
+
+double RunningStats::max() const {
+    return (count_ > 0) ? max_ : 0.0;
+}
+
+//------------------------------------------------------------------------------
+// LogHistogram class
+//------------------------------------------------------------------------------
+LogHistogram::LogHistogram(double lowest, int octaves)
+    : lowest_(lowest),
+    invLowest_(1.0 / lowest),
+    octaves_(octaves),
+    counts_(1 + (static_cast<std::size_t>(octaves) << HISTOGRAM_SUB_BITS), 0)
+{
+}
+
+// Bucket of a value (values past the range land in the last bucket)
+int LogHistogram::bucketOf(double value) const {
+    double scaled = value * invLowest_;
+    if (!(scaled >= 1.0)) {
+        return 0; // also catches NaN
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &scaled, sizeof(bits));
+    int exponent = static_cast<int>(bits >> 52) - 1023;
+    if (exponent >= octaves_) {
+        return static_cast<int>(counts_.size()) - 1;
+    }
+    int sub = static_cast<int>((bits >> (52 - HISTOGRAM_SUB_BITS)) & ((1u << HISTOGRAM_SUB_BITS) - 1));
+    return 1 + (exponent << HISTOGRAM_SUB_BITS) + sub;
+}
+
+// Smallest value of a bucket
+double LogHistogram::bucketStart(int bucket) const {
+    if (bucket == 0) {
+        return 0.0;
+    }
+    int exponent = (bucket - 1) >> HISTOGRAM_SUB_BITS;
+    int sub = (bucket - 1) & ((1 << HISTOGRAM_SUB_BITS) - 1);
+    double mantissa = 1.0 + static_cast<double>(sub) / (1 << HISTOGRAM_SUB_BITS);
+    return std::ldexp(mantissa, exponent) * lowest_;
+}
+
+// Add one observation
+void LogHistogram::record(double value) {
+    counts_[bucketOf(value)]++;
+    stats_.add(value);
+}
+
+// Add the counts of a histogram with the same layout
+void LogHistogram::merge(const LogHistogram& other) {
+    assert(counts_.size() == other.counts_.size() && lowest_ == other.lowest_);
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    stats_.merge(other.stats_);
+}
+
+// Value at percentile p (0..100): the midpoint of the bucket holding it
+double LogHistogram::percentile(double p) const {
+    std::uint64_t total = stats_.count();
+    if (total == 0) {
+        return 0.0;
+    }
+    double clamped = std::min(std::max(p, 0.0), 100.0);
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * total));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen = 0;
+    int last = static_cast<int>(counts_.size()) - 1;
+    for (int bucket = 0; bucket <= last; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= rank) {
+            if (bucket == 0) {
+                return stats_.min(); // below resolution, typically zero waits
+            }
+            double start = bucketStart(bucket);
+            double end = (bucket == last) ? stats_.max() : bucketStart(bucket + 1);
+            double value = 0.5 * (start + end);
+            return std::min(std::max(value, stats_.min()), stats_.max());
+        }
+    }
+    return stats_.max();
+}
+
+const RunningStats& LogHistogram::getStats() const {
+    return stats_;
+}
+
+std::uint64_t LogHistogram::count() const {
+    return stats_.count();
+}
+
+// Write the counts to a snapshot
+void LogHistogram::save(SnapshotWriter& out) const {
+    out.write(lowest_);
+    out.write(octaves_);
+    out.write(stats_);
+    out.writeVector(counts_);
+}
+
+// Read counts saved from a histogram of the same layout
+bool LogHistogram::load(SnapshotReader& in) {
+    double lowest = 0.0;
+    int octaves = 0;
+    return in.read(lowest) && in.read(octaves) && lowest == lowest_ && octaves == octaves_
+        && in.read(stats_) && in.readVector(counts_, static_cast<long long>(counts_.size()));
+}
+
+//------------------------------------------------------------------------------
+// LatencyStats struct
+//------------------------------------------------------------------------------
+void LatencyStats::merge(const LatencyStats& other) {
+    wait.merge(other.wait);
+    sojourn.merge(other.sojourn);
+}
+
+void LatencyStats::save(SnapshotWriter& out) const {
+    wait.save(out);
+    sojourn.save(out);
+}
+
+bool LatencyStats::load(SnapshotReader& in) {
+    return wait.load(in) && sojourn.load(in);
+}
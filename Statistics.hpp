@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Constant-memory streaming statistics, mergeable across replications
+//------------------------------------------------------------------------------
+
+// Two-sided 97.5% quantile of Student's t distribution
+double studentT975(int degreesOfFreedom);
+
+// Count, mean and variance by Welford's update; merged with Chan's formula
+class RunningStats {
+private:
+    std::uint64_t count_;
+    double mean_;
+    double m2_;
+    double min_;
+    double max_;
+
+public:
+    RunningStats();
+
+    // Add one observation
+    void add(double value);
+    // Combine with statistics of a disjoint sample
+    void merge(const RunningStats& other);
+
+    std::uint64_t count() const;
+    double mean() const;
+    double variance() const; // sample variance
+    double stddev() const;
+    double min() const;
+    double max() const;
+};
+
+// Sub-buckets per power of two: bucket width is at most 1/128 of its value
+static const int HISTOGRAM_SUB_BITS = 7;
+
+// HDR-style log-linear histogram. Bucket 0 counts [0, lowest); above that,
+// each power of two is split into 2^HISTOGRAM_SUB_BITS equal buckets, so
+// percentiles keep two significant digits. The bucket index comes straight
+// from the exponent and top mantissa bits of value / lowest.
+class LogHistogram {
+private:
+    double lowest_;
+    double invLowest_;
+    int octaves_;
+    RunningStats stats_;
+    std::vector<std::uint64_t> counts_;
+
+    // Bucket of a value (values past the range land in the last bucket)
+    int bucketOf(double value) const;
+    // Smallest value of a bucket
+    double bucketStart(int bucket) const;
+
+public:
+    // Covers [lowest, lowest * 2^octaves); the defaults span 3.6 s to ~700 days in hours
+    explicit LogHistogram(double lowest = 1e-3, int octaves = 24);
+
+    // Add one observation
+    void record(double value);
+    // Add the counts of a histogram with the same layout
+    void merge(const LogHistogram& other);
+
+    // Value at percentile p (0..100): the midpoint of the bucket holding it
+    // (so within half a bucket width), clamped to the observed min and max;
+    // the minimum when it falls below `lowest`
+    double percentile(double p) const;
+
+    const RunningStats& getStats() const;
+    std::uint64_t count() const;
+
+    // Write the counts to a snapshot; load() reads them back into a
+    // histogram of the same layout (false on any mismatch)
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
+
+// Wait (buffer to device) and sojourn (arrival to completion) of one class
+struct LatencyStats {
+    LogHistogram wait;
+    LogHistogram sojourn;
+
+    void merge(const LatencyStats& other);
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+};
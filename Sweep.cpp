@@ -0,0 +1,340 @@
+#include "Sweep.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <tuple>
+#include <thread>
+
+namespace {
+
+bool sameWorkload(const SimulationConfig& a, const SimulationConfig& b) {
+    return a.numCorporate == b.numCorporate
+        && a.numPremium == b.numPremium
+        && a.numFree == b.numFree;
+}
+
+// a has no more devices and no more buffer than b (same workload)
+bool noMoreExpensive(const SimulationConfig& a, const SimulationConfig& b) {
+    return sameWorkload(a, b)
+        && a.numDevices <= b.numDevices
+        && a.bufferCapacity <= b.bufferCapacity;
+}
+
+// Columns of writeSweepCsv that only a simulated point fills, in row order
+const char* const SIMULATED_COLUMNS[] = {
+    "generated", "served", "rejected", "rejected_corporate", "rejected_premium", "rejected_free",
+    "rejection_rate", "rejection_rate_ci", "avg_wait_hours", "avg_wait_ci",
+    "mean_utilization", "mean_utilization_ci", "simulation_time",
+    "peak_utilization", "peak_rejection_rate"
+};
+const std::size_t SIMULATED_COLUMN_COUNT = sizeof(SIMULATED_COLUMNS) / sizeof(SIMULATED_COLUMNS[0]);
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// SweepRange struct
+//------------------------------------------------------------------------------
+std::vector<int> SweepRange::values() const {
+    std::vector<int> out;
+    for (int v = first; v <= last; v += step) {
+        out.push_back(v);
+    }
+    return out;
+}
+
+bool SweepRange::isSingle() const {
+    return first == last;
+}
+
+// Parse "N", "A:B" or "A:B:S"; returns false on malformed text
+bool parseSweepRange(const std::string& text, SweepRange& range) {
+    int values[3] = { 0, 0, 1 };
+    int count = 0;
+    std::size_t pos = 0;
+    for (;;) {
+        std::size_t end = text.find(':', pos);
+        std::string part = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if (count == 3 || part.empty() || part.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        values[count++] = std::atoi(part.c_str());
+        if (end == std::string::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+
+    range.first = values[0];
+    range.last = (count >= 2) ? values[1] : values[0];
+    range.step = (count == 3) ? values[2] : 1;
+    return range.step > 0 && range.last >= range.first;
+}
+
+const char* sweepStatusName(SweepStatus status) {
+    switch (status) {
+    case SweepStatus::FEASIBLE:   return "feasible";
+    case SweepStatus::INFEASIBLE: return "infeasible";
+    case SweepStatus::PRUNED:     return "pruned";
+    case SweepStatus::RULED_OUT:  return "ruled_out";
+    }
+    return "unknown";
+}
+
+//------------------------------------------------------------------------------
+// SweepRunner class
+//------------------------------------------------------------------------------
+SweepRunner::SweepRunner(const SimulationConfig& base, const SweepGrid& grid,
+    const SweepTargets& targets, int replications, int numThreads, bool prune)
+    : base_(base),
+    grid_(grid),
+    targets_(targets),
+    replications_(std::max(1, replications)),
+    numThreads_(numThreads),
+    prune_(prune)
+{
+    if (numThreads_ <= 0) {
+        numThreads_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+}
+
+// Evaluate the grid; points come back in grid order
+bool SweepRunner::run(std::vector<SweepPoint>& points, std::string& error) const {
+    points.clear();
+    for (int corporate : grid_.corporate.values()) {
+        for (int premium : grid_.premium.values()) {
+            for (int free : grid_.free.values()) {
+                for (int devices : grid_.devices.values()) {
+                    for (int buffer : grid_.buffer.values()) {
+                        SweepPoint point;
+                        point.config = base_;
+                        point.config.numCorporate = corporate;
+                        point.config.numPremium = premium;
+                        point.config.numFree = free;
+                        point.config.numDevices = devices;
+                        point.config.bufferCapacity = buffer;
+                        points.push_back(point);
+                    }
+                }
+            }
+        }
+    }
+
+    // The model costs microseconds per point: rule out the hopeless ones and
+    // find the points a clearly feasible cheaper point makes overprovisioned
+    std::vector<char> clearlyFeasible(points.size(), 0);
+    std::vector<char> deferred(points.size(), 0);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        SweepPoint& point = points[i];
+        point.analytic = analyzeConfig(point.config);
+        // A replayed trace is not the Poisson load the model assumes, nor
+        // another buffer policy or reneging the priority buffer it models
+        if (!prune_ || !point.analytic.exponential || !point.config.replayFile.empty()
+            || point.config.bufferPolicy.kind != BufferPolicyKind::PRIORITY || point.config.abandons()) {
+            continue;
+        }
+        // The margin is relative, so a zero target (the model is never
+        // exactly zero) rules nothing out
+        if ((targets_.maxRejectionRate > 0.0
+                && point.analytic.rejectionRate > targets_.maxRejectionRate * ANALYTIC_MARGIN)
+            || (targets_.maxWaitHours > 0.0
+                && point.analytic.averageWaitTime > targets_.maxWaitHours * ANALYTIC_MARGIN)) {
+            point.status = SweepStatus::RULED_OUT;
+        }
+        else if (point.analytic.rejectionRate * ANALYTIC_MARGIN <= targets_.maxRejectionRate
+            && point.analytic.averageWaitTime * ANALYTIC_MARGIN <= targets_.maxWaitHours) {
+            clearlyFeasible[i] = 1;
+        }
+    }
+    // One pass in (workload, devices, buffer) order: every point that could
+    // dominate a point comes before it, so the smallest buffer of a clearly
+    // feasible point seen so far in its workload decides
+    std::vector<std::size_t> byCost(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        byCost[i] = i;
+    }
+    std::sort(byCost.begin(), byCost.end(), [&points](std::size_t a, std::size_t b) {
+        const SimulationConfig& x = points[a].config;
+        const SimulationConfig& y = points[b].config;
+        return std::tie(x.numCorporate, x.numPremium, x.numFree, x.numDevices, x.bufferCapacity)
+            < std::tie(y.numCorporate, y.numPremium, y.numFree, y.numDevices, y.bufferCapacity);
+    });
+    int smallestBuffer = std::numeric_limits<int>::max();
+    for (std::size_t k = 0; k < byCost.size(); ++k) {
+        std::size_t i = byCost[k];
+        if (k > 0 && !sameWorkload(points[byCost[k - 1]].config, points[i].config)) {
+            smallestBuffer = std::numeric_limits<int>::max();
+        }
+        deferred[i] = smallestBuffer <= points[i].config.bufferCapacity;
+        if (clearlyFeasible[i]) {
+            smallestBuffer = std::min(smallestBuffer, points[i].config.bufferCapacity);
+        }
+    }
+
+    // Schedule cheap points first so that pruning kicks in early
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (points[i].status != SweepStatus::RULED_OUT) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&points, &deferred](std::size_t a, std::size_t b) {
+        const SimulationConfig& x = points[a].config;
+        const SimulationConfig& y = points[b].config;
+        if (deferred[a] != deferred[b]) {
+            return deferred[a] < deferred[b];
+        }
+        if (x.numDevices != y.numDevices) {
+            return x.numDevices < y.numDevices;
+        }
+        return x.bufferCapacity < y.bufferCapacity;
+    });
+
+    std::mutex feasibleMutex;
+    std::vector<SimulationConfig> feasible;
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+
+    auto worker = [&]() {
+        for (std::size_t k = next++; k < order.size() && !failed; k = next++) {
+            SweepPoint& point = points[order[k]];
+
+            if (prune_) {
+                std::lock_guard<std::mutex> lock(feasibleMutex);
+                bool dominated = std::any_of(feasible.begin(), feasible.end(),
+                    [&point](const SimulationConfig& f) { return noMoreExpensive(f, point.config); });
+                if (dominated) {
+                    point.status = SweepStatus::PRUNED;
+                    continue;
+                }
+            }
+
+            ReplicationRunner runner(point.config, 1);
+            std::vector<SimulationResults> results;
+            std::string message;
+            if (!runner.run(replications_, results, message)) {
+                std::lock_guard<std::mutex> lock(feasibleMutex);
+                if (!failed) {
+                    error = message;
+                    failed = true;
+                }
+                continue;
+            }
+            point.summary = ReplicationRunner::summarize(results, point.config.antithetic);
+
+            bool ok = point.summary.rejectionRate.mean <= targets_.maxRejectionRate
+                && point.summary.averageWaitTime.mean <= targets_.maxWaitHours;
+            point.status = ok ? SweepStatus::FEASIBLE : SweepStatus::INFEASIBLE;
+            if (ok) {
+                std::lock_guard<std::mutex> lock(feasibleMutex);
+                feasible.push_back(point.config);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    int threads = std::min<int>(numThreads_, std::max<std::size_t>(1, points.size()));
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return !failed;
+}
+
+// One CSV row per point with the printStatistics metrics
+bool writeSweepCsv(const std::vector<SweepPoint>& points, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "corporate,premium,free,devices,buffer,status,replications";
+    for (const char* column : SIMULATED_COLUMNS) {
+        out << ',' << column;
+    }
+    out << ",analytic_rejection_rate,analytic_wait_hours\n";
+    for (const SweepPoint& p : points) {
+        const SimulationConfig& c = p.config;
+        const ReplicationSummary& s = p.summary;
+        out << c.numCorporate << ',' << c.numPremium << ',' << c.numFree << ','
+            << c.numDevices << ',' << c.bufferCapacity << ','
+            << sweepStatusName(p.status) << ',' << s.replications;
+        if (p.status == SweepStatus::PRUNED || p.status == SweepStatus::RULED_OUT) {
+            // Not simulated: one empty field per simulated column
+            out << std::string(SIMULATED_COLUMN_COUNT, ',') << ',' << p.analytic.rejectionRate
+                << ',' << p.analytic.averageWaitTime << '\n';
+            continue;
+        }
+        out << ',' << s.generatedRequests.mean << ',' << s.servedRequests.mean << ','
+            << s.rejectedRequests.mean;
+        for (int pr = 0; pr < PRIORITY_COUNT; ++pr) {
+            out << ',' << s.rejectedByPriority[pr].mean;
+        }
+        out << ',' << s.rejectionRate.mean << ',' << s.rejectionRate.halfWidth
+            << ',' << s.averageWaitTime.mean << ',' << s.averageWaitTime.halfWidth
+            << ',' << s.meanUtilization.mean << ',' << s.meanUtilization.halfWidth
+            << ',' << s.simulationTime.mean
+            << ',' << s.peakUtilization.mean << ',' << s.peakRejectionRate.mean
+            << ',' << p.analytic.rejectionRate << ',' << p.analytic.averageWaitTime << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+// Print the cheapest feasible configuration of every workload
+void printSweepSummary(const std::vector<SweepPoint>& points) {
+    int simulated = 0;
+    int pruned = 0;
+    int ruledOut = 0;
+    for (const SweepPoint& p : points) {
+        if (p.status == SweepStatus::PRUNED) {
+            pruned++;
+        }
+        else if (p.status == SweepStatus::RULED_OUT) {
+            ruledOut++;
+        }
+        else {
+            simulated++;
+        }
+    }
+    std::cout << "\n--- Sweep: " << points.size() << " points, " << simulated
+        << " simulated, " << pruned << " pruned";
+    if (ruledOut > 0) {
+        std::cout << ", " << ruledOut << " ruled out by the analytic model";
+    }
+    std::cout << " ---\n";
+
+    std::vector<const SweepPoint*> best;
+    for (const SweepPoint& p : points) {
+        if (p.status != SweepStatus::FEASIBLE) {
+            continue;
+        }
+        auto it = std::find_if(best.begin(), best.end(), [&p](const SweepPoint* b) {
+            return sameWorkload(b->config, p.config);
+        });
+        if (it == best.end()) {
+            best.push_back(&p);
+        }
+        else if (p.config.numDevices < (*it)->config.numDevices
+            || (p.config.numDevices == (*it)->config.numDevices
+                && p.config.bufferCapacity < (*it)->config.bufferCapacity)) {
+            *it = &p;
+        }
+    }
+
+    if (best.empty()) {
+        std::cout << "No configuration meets the targets.\n";
+    }
+    for (const SweepPoint* p : best) {
+        std::cout << "Sources " << p->config.numCorporate << "/" << p->config.numPremium
+            << "/" << p->config.numFree << ": cheapest feasible is "
+            << p->config.numDevices << " devices, buffer " << p->config.bufferCapacity
+            << " (rejection " << (p->summary.rejectionRate.mean * 100.0)
+            << " %, wait " << (p->summary.averageWaitTime.mean * 60.0) << " min; model "
+            << (p->analytic.rejectionRate * 100.0) << " %, "
+            << (p->analytic.averageWaitTime * 60.0) << " min)\n";
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <limits>
+#include <string>
+#include <vector>
+#include "Analytic.hpp"
+#include "Replication.hpp"
+
+//------------------------------------------------------------------------------
+// Parameter sweep over sources, devices and buffer size
+//------------------------------------------------------------------------------
+
+// Inclusive integer range first:last:step
+struct SweepRange {
+    int first = 0;
+    int last = 0;
+    int step = 1;
+
+    std::vector<int> values() const;
+    bool isSingle() const;
+};
+
+// Parse "N", "A:B" or "A:B:S"; returns false on malformed text
+bool parseSweepRange(const std::string& text, SweepRange& range);
+
+// Ranges of every swept parameter
+struct SweepGrid {
+    SweepRange corporate{ 2, 2, 1 };
+    SweepRange premium{ 4, 4, 1 };
+    SweepRange free{ 6, 6, 1 };
+    SweepRange devices{ 5, 5, 1 };
+    SweepRange buffer{ BUFFER_SIZE, BUFFER_SIZE, 1 };
+};
+
+// Service levels a configuration has to meet (compared against the means)
+struct SweepTargets {
+    double maxRejectionRate = 1.0;
+    double maxWaitHours = std::numeric_limits<double>::infinity();
+};
+
+// How far the analytic model must be from a target to act on it without
+// simulating: a point is ruled out when a metric exceeds its target by at
+// least this factor, and counts as clearly feasible when it is under it by
+// this factor. A target of zero rules nothing out.
+static const double ANALYTIC_MARGIN = 2.0;
+
+enum class SweepStatus {
+    FEASIBLE,   // meets all targets
+    INFEASIBLE, // simulated, misses a target
+    PRUNED,     // not simulated: a cheaper feasible point dominates it
+    RULED_OUT   // not simulated: the analytic model misses a target by ANALYTIC_MARGIN
+};
+
+const char* sweepStatusName(SweepStatus status);
+
+// One grid point and its merged statistics
+struct SweepPoint {
+    SimulationConfig config;
+    SweepStatus status = SweepStatus::PRUNED;
+    ReplicationSummary summary;
+    AnalyticEstimate analytic; // computed for every point
+};
+
+// Runs every grid point on a pool of threads. Points that share a workload
+// (corporate/premium/free) are ordered by cost - devices first, then buffer
+// slots - and a point is skipped once a feasible point with no more devices
+// and no more buffer exists, since it cannot be the cheapest configuration.
+// With pruning on and exponential devices, the analytic model first rules
+// out hopeless points, and points that a clearly feasible cheaper point
+// dominates are queued last, so they are usually pruned before they start.
+// Those are only deferred, never skipped on the model's word alone.
+class SweepRunner {
+private:
+    SimulationConfig base_;
+    SweepGrid grid_;
+    SweepTargets targets_;
+    int replications_;
+    int numThreads_;
+    bool prune_;
+
+public:
+    SweepRunner(const SimulationConfig& base, const SweepGrid& grid,
+        const SweepTargets& targets, int replications = 1,
+        int numThreads = 0, bool prune = true);
+
+    // Evaluate the grid; points come back in grid order. False with the
+    // message of a point whose replications failed; the sweep stops there.
+    bool run(std::vector<SweepPoint>& points, std::string& error) const;
+};
+
+// One CSV row per point with the printStatistics metrics
+bool writeSweepCsv(const std::vector<SweepPoint>& points, const std::string& path);
+
+// Print the cheapest feasible configuration of every workload
+void printSweepSummary(const std::vector<SweepPoint>& points);
@@ -0,0 +1,226 @@
+#include "TimeSeries.hpp"
+#include <cstring>
+#include "Snapshot.hpp"
+
+namespace {
+
+enum class ColumnType : std::uint8_t { F64 = 0, U32 = 1 };
+
+struct ColumnInfo {
+    const char* name;
+    ColumnType type;
+};
+
+const ColumnInfo WINDOW_COLUMNS[] = {
+    { "start_hours", ColumnType::F64 },
+    { "duration_hours", ColumnType::F64 },
+    { "busy_device_hours", ColumnType::F64 },
+    { "buffer_request_hours", ColumnType::F64 },
+    { "wait_hours_sum", ColumnType::F64 },
+    { "arrivals", ColumnType::U32 },
+    { "served", ColumnType::U32 },
+    { "rejected", ColumnType::U32 },
+    { "rejected_corporate", ColumnType::U32 },
+    { "rejected_premium", ColumnType::U32 },
+    { "rejected_free", ColumnType::U32 },
+};
+const std::uint32_t WINDOW_COLUMN_COUNT = sizeof(WINDOW_COLUMNS) / sizeof(WINDOW_COLUMNS[0]);
+
+// Write one column of a block
+template <typename T, typename Get>
+void writeColumn(std::FILE* out, const std::vector<WindowMetrics>& rows, Get get) {
+    T values[WINDOW_BLOCK_ROWS];
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        values[i] = get(rows[i]);
+    }
+    std::fwrite(values, sizeof(T), rows.size(), out);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// WindowRecorder class
+//------------------------------------------------------------------------------
+WindowRecorder::WindowRecorder(double widthHours, int numDevices)
+    : width_(widthHours),
+    numDevices_(numDevices),
+    lastTime_(0.0),
+    busyDevices_(0),
+    buffered_(0),
+    windows_(0),
+    out_(nullptr)
+{
+    current_.start = 0.0;
+}
+
+WindowRecorder::~WindowRecorder() {
+    if (out_) {
+        flushBlock();
+        std::fclose(out_);
+    }
+}
+
+// Also write every closed window to a columnar file
+bool WindowRecorder::open(const std::string& path) {
+    out_ = std::fopen(path.c_str(), "wb");
+    if (!out_) {
+        return false;
+    }
+    block_.reserve(WINDOW_BLOCK_ROWS);
+
+    const char magic[8] = { 'M', 'S', 'S', 'W', 'I', 'N', '1', '\0' };
+    std::uint32_t devices = static_cast<std::uint32_t>(numDevices_);
+    std::fwrite(magic, 1, sizeof(magic), out_);
+    std::fwrite(&WINDOW_COLUMN_COUNT, sizeof(WINDOW_COLUMN_COUNT), 1, out_);
+    std::fwrite(&devices, sizeof(devices), 1, out_);
+    std::fwrite(&width_, sizeof(width_), 1, out_);
+    for (const ColumnInfo& column : WINDOW_COLUMNS) {
+        char name[31] = {};
+        std::strncpy(name, column.name, sizeof(name) - 1);
+        std::fwrite(name, 1, sizeof(name), out_);
+        std::fputc(static_cast<int>(column.type), out_);
+    }
+    return true;
+}
+
+// Integrate the current levels up to t, closing the windows in between
+void WindowRecorder::advance(double timeHours) {
+    double windowEnd = current_.start + width_;
+    while (timeHours >= windowEnd) {
+        closeWindow(windowEnd);
+        windowEnd = current_.start + width_;
+    }
+    double dt = timeHours - lastTime_;
+    current_.busyArea += busyDevices_ * dt;
+    current_.queueArea += buffered_ * dt;
+    lastTime_ = timeHours;
+}
+
+// Levels that hold until the next advance()
+void WindowRecorder::setLevels(int busyDevices, int buffered) {
+    busyDevices_ = busyDevices;
+    buffered_ = buffered;
+}
+
+void WindowRecorder::recordArrival() {
+    current_.arrivals++;
+}
+
+void WindowRecorder::recordServiceStart(double waitHours) {
+    current_.served++;
+    current_.waitSum += waitHours;
+}
+
+void WindowRecorder::recordRejection(int priority) {
+    current_.rejected++;
+    current_.rejectedByPriority[priority]++;
+}
+
+// Close the current window at `end` and start the next one
+void WindowRecorder::closeWindow(double end) {
+    double dt = end - lastTime_;
+    current_.busyArea += busyDevices_ * dt;
+    current_.queueArea += buffered_ * dt;
+    current_.duration = end - current_.start;
+    lastTime_ = end;
+
+    // A short final window only counts as a peak if it is the only one
+    bool full = current_.duration >= width_ * (1.0 - 1e-9);
+    if (windows_ == 0 || (full && utilization(current_) > utilization(peakUtilization_))) {
+        peakUtilization_ = current_;
+    }
+    if (windows_ == 0 || (full && current_.rejected > peakRejection_.rejected)) {
+        peakRejection_ = current_;
+    }
+    windows_++;
+
+    if (out_) {
+        block_.push_back(current_);
+        if (static_cast<int>(block_.size()) == WINDOW_BLOCK_ROWS) {
+            flushBlock();
+        }
+    }
+
+    current_ = WindowMetrics();
+    current_.start = end;
+}
+
+// Write the buffered windows as one columnar block
+void WindowRecorder::flushBlock() {
+    if (!out_ || block_.empty()) {
+        return;
+    }
+    std::uint32_t rows = static_cast<std::uint32_t>(block_.size());
+    std::fwrite(&rows, sizeof(rows), 1, out_);
+    writeColumn<double>(out_, block_, [](const WindowMetrics& w) { return w.start; });
+    writeColumn<double>(out_, block_, [](const WindowMetrics& w) { return w.duration; });
+    writeColumn<double>(out_, block_, [](const WindowMetrics& w) { return w.busyArea; });
+    writeColumn<double>(out_, block_, [](const WindowMetrics& w) { return w.queueArea; });
+    writeColumn<double>(out_, block_, [](const WindowMetrics& w) { return w.waitSum; });
+    writeColumn<std::uint32_t>(out_, block_, [](const WindowMetrics& w) { return w.arrivals; });
+    writeColumn<std::uint32_t>(out_, block_, [](const WindowMetrics& w) { return w.served; });
+    writeColumn<std::uint32_t>(out_, block_, [](const WindowMetrics& w) { return w.rejected; });
+    for (int p = 0; p < WINDOW_PRIORITIES; ++p) {
+        writeColumn<std::uint32_t>(out_, block_, [p](const WindowMetrics& w) { return w.rejectedByPriority[p]; });
+    }
+    block_.clear();
+}
+
+// Close the last (partial) window and the file
+void WindowRecorder::finish(double timeHours) {
+    advance(timeHours);
+    if (timeHours > current_.start) {
+        closeWindow(timeHours);
+    }
+    if (out_) {
+        flushBlock();
+        std::fclose(out_);
+        out_ = nullptr;
+    }
+}
+
+// Write the open window and the peaks to a snapshot
+void WindowRecorder::save(SnapshotWriter& out) const {
+    out.write(width_);
+    out.write(numDevices_);
+    out.write(current_);
+    out.write(lastTime_);
+    out.write(busyDevices_);
+    out.write(buffered_);
+    out.write(windows_);
+    out.write(peakUtilization_);
+    out.write(peakRejection_);
+}
+
+// Read them back into a recorder of the same width and device count
+bool WindowRecorder::load(SnapshotReader& in) {
+    double width = 0.0;
+    int numDevices = 0;
+    return in.read(width) && in.read(numDevices) && width == width_ && numDevices == numDevices_
+        && in.read(current_) && in.read(lastTime_) && in.read(busyDevices_) && in.read(buffered_)
+        && in.read(windows_) && in.read(peakUtilization_) && in.read(peakRejection_);
+}
+
+// Busy share of the devices during a window
+double WindowRecorder::utilization(const WindowMetrics& window) const {
+    if (window.duration <= 0.0 || numDevices_ == 0) {
+        return 0.0;
+    }
+    return window.busyArea / (window.duration * numDevices_);
+}
+
+const WindowMetrics& WindowRecorder::getPeakUtilization() const {
+    return peakUtilization_;
+}
+
+const WindowMetrics& WindowRecorder::getPeakRejection() const {
+    return peakRejection_;
+}
+
+int WindowRecorder::getWindowCount() const {
+    return windows_;
+}
+
+double WindowRecorder::getWidth() const {
+    return width_;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+//------------------------------------------------------------------------------
+// Per-window metrics (e.g. per simulated hour) and their columnar file
+//------------------------------------------------------------------------------
+
+// Priorities tracked per window (checked against PRIORITY_COUNT)
+static const int WINDOW_PRIORITIES = 3;
+// Windows kept in memory before a block is written out
+static const int WINDOW_BLOCK_ROWS = 1024;
+
+// Accumulators of one window
+struct WindowMetrics {
+    double start = 0.0;     // hours
+    double duration = 0.0;  // hours (the last window may be partial)
+    double busyArea = 0.0;  // integral of busy devices: device-hours
+    double queueArea = 0.0; // integral of buffered requests: request-hours
+    double waitSum = 0.0;   // hours waited by the requests that started service
+    std::uint32_t arrivals = 0;
+    std::uint32_t served = 0; // requests that started service
+    std::uint32_t rejected = 0;
+    std::uint32_t rejectedByPriority[WINDOW_PRIORITIES] = {};
+};
+
+// Splits the run into fixed windows. advance() integrates the busy-device and
+// buffer levels up to the next event and closes every window it crosses, so
+// each event costs O(1). Closed windows go to an optional columnar file:
+//
+//   header: "MSSWIN1\0", uint32 columns, uint32 devices, double width,
+//           then per column char name[31] and uint8 type (0 = f64, 1 = u32)
+//   blocks: uint32 rows, then each column's `rows` values in header order
+//
+// All values are in host byte order.
+class WindowRecorder {
+private:
+    double width_;
+    int numDevices_;
+    WindowMetrics current_;
+    double lastTime_;
+    int busyDevices_;
+    int buffered_;
+    int windows_;
+
+    WindowMetrics peakUtilization_;
+    WindowMetrics peakRejection_;
+
+    std::FILE* out_;
+    std::vector<WindowMetrics> block_;
+
+    // Close the current window at `end` and start the next one
+    void closeWindow(double end);
+    // Write the buffered windows as one columnar block
+    void flushBlock();
+
+public:
+    WindowRecorder(double widthHours, int numDevices);
+    ~WindowRecorder();
+    WindowRecorder(const WindowRecorder&) = delete;
+    WindowRecorder& operator=(const WindowRecorder&) = delete;
+
+    // Also write every closed window to a columnar file; false if it cannot be created
+    bool open(const std::string& path);
+
+    // Integrate the current levels up to t, closing the windows in between
+    void advance(double timeHours);
+    // Levels that hold until the next advance()
+    void setLevels(int busyDevices, int buffered);
+
+    void recordArrival();
+    void recordServiceStart(double waitHours);
+    void recordRejection(int priority);
+
+    // Close the last (partial) window and the file
+    void finish(double timeHours);
+
+    // Write the open window and the peaks to a snapshot. Windows already
+    // closed belong to this run's file; a restored recorder writes the
+    // windows from the snapshot on to its own file.
+    void save(SnapshotWriter& out) const;
+    // Read them back into a recorder of the same width and device count
+    bool load(SnapshotReader& in);
+
+    // Busy share of the devices during a window
+    double utilization(const WindowMetrics& window) const;
+    // Window with the highest utilization / the most rejections
+    const WindowMetrics& getPeakUtilization() const;
+    const WindowMetrics& getPeakRejection() const;
+    int getWindowCount() const;
+    double getWidth() const;
+};
@@ -0,0 +1,139 @@
+#include "Trace.hpp"
+#include <cstdarg>
+
+bool parseTraceLevel(const std::string& text, TraceLevel& level) {
+    if (text == "off") {
+        level = TraceLevel::OFF;
+    }
+    else if (text == "summary") {
+        level = TraceLevel::SUMMARY;
+    }
+    else if (text == "full") {
+        level = TraceLevel::FULL;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// TraceSink class
+//------------------------------------------------------------------------------
+TraceSink::TraceSink(TraceLevel level, std::FILE* out, std::size_t chunkSize)
+    : level_(level),
+    out_(out),
+    chunk_(chunkSize),
+    used_(0),
+    backUsed_(0),
+    pending_(false),
+    closing_(false)
+{
+}
+
+TraceSink::~TraceSink() {
+    flush();
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        changed_.notify_all();
+        thread_.join();
+    }
+}
+
+void TraceSink::setLevel(TraceLevel level) {
+    level_ = level;
+}
+
+TraceLevel TraceSink::getLevel() const {
+    return level_;
+}
+
+// Append a printf-style message to the current chunk
+void TraceSink::write(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+    va_list direct;
+    va_copy(direct, args);
+
+    std::size_t room = chunk_.size() - used_;
+    int len = std::vsnprintf(chunk_.data() + used_, room, format, args);
+    va_end(args);
+
+    if (len >= 0 && static_cast<std::size_t>(len) >= room) {
+        // Did not fit: hand the chunk off and format again at its beginning
+        if (used_ > 0) {
+            handOff();
+        }
+        room = chunk_.size();
+        len = std::vsnprintf(chunk_.data(), room, format, retry);
+        if (len >= 0 && static_cast<std::size_t>(len) >= room) {
+            // Longer than a whole chunk: write it straight through, after
+            // what the thread still has
+            drain();
+            std::vfprintf(out_, format, direct);
+            len = 0;
+        }
+    }
+    va_end(retry);
+    va_end(direct);
+
+    if (len > 0) {
+        used_ += static_cast<std::size_t>(len);
+    }
+}
+
+// Write everything buffered so far and flush the stream
+void TraceSink::flush() {
+    if (used_ > 0) {
+        handOff();
+    }
+    drain();
+    std::fflush(out_);
+}
+
+// Hand the filled chunk to the writer thread (waits for the previous one)
+void TraceSink::handOff() {
+    if (!thread_.joinable()) {
+        back_.resize(chunk_.size());
+        thread_ = std::thread(&TraceSink::writerLoop, this);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return !pending_; });
+        std::swap(chunk_, back_);
+        backUsed_ = used_;
+        pending_ = true;
+    }
+    changed_.notify_all();
+    used_ = 0;
+}
+
+// Wait until the writer thread has written every chunk handed to it
+void TraceSink::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this]() { return !pending_; });
+}
+
+void TraceSink::writerLoop() {
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return pending_ || closing_; });
+        if (!pending_) {
+            return; // closing, nothing left to write
+        }
+        lock.unlock();
+
+        // back_ is ours until pending_ is cleared
+        std::fwrite(back_.data(), 1, backUsed_, out_);
+
+        lock.lock();
+        pending_ = false;
+        lock.unlock();
+        changed_.notify_all();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Trace output of the simulation (selectable verbosity, buffered sink)
+//------------------------------------------------------------------------------
+
+// Trace verbosity levels
+enum class TraceLevel {
+    OFF,     // nothing is written from the event loop
+    SUMMARY, // one progress line per simulated hour and end-of-run notices
+    FULL     // every arrival, buffer operation and device transition
+};
+
+// Parse "off" / "summary" / "full"; returns false on unknown text
+bool parseTraceLevel(const std::string& text, TraceLevel& level);
+
+// Buffered trace sink: lines are formatted into a large in-memory chunk.
+// When it fills up, a background thread (started on the first full chunk)
+// writes it with a single fwrite while the event loop fills the other one,
+// so the loop only waits on the stream if it falls a whole chunk behind.
+class TraceSink {
+private:
+    TraceLevel level_;
+    std::FILE* out_;
+    std::vector<char> chunk_;  // filled by the event loop
+    std::size_t used_;
+    std::vector<char> back_;   // being written by thread_
+    std::size_t backUsed_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool pending_;             // back_ holds a chunk not yet written
+    bool closing_;
+
+    // Hand the filled chunk to the writer thread (waits for the previous one)
+    void handOff();
+    // Wait until the writer thread has written every chunk handed to it
+    void drain();
+    void writerLoop();
+
+public:
+    explicit TraceSink(TraceLevel level = TraceLevel::FULL,
+        std::FILE* out = stdout, std::size_t chunkSize = 1 << 16);
+    ~TraceSink();
+
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    // Check whether messages of the given level are written;
+    // call sites test this before doing any formatting
+    bool enabled(TraceLevel level) const {
+        return level_ != TraceLevel::OFF
+            && static_cast<int>(level) <= static_cast<int>(level_);
+    }
+
+    void setLevel(TraceLevel level);
+    TraceLevel getLevel() const;
+
+    // Append a printf-style message to the current chunk
+    void write(const char* format, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 2, 3)))
+#endif
+        ;
+
+    // Write everything buffered so far and flush the stream; returns once
+    // it is written, so other output to the stream can follow in order
+    void flush();
+};
@@ -0,0 +1,68 @@
+// Event-queue backend comparison (classic "hold" model).
+//
+// The queue is pre-filled with one pending completion per device; every
+// operation then pops the earliest event and schedules its successor an
+// exponential service time later, which keeps the queue depth constant -
+// the steady state of Controller::work() with all devices busy.
+//
+// Build: cmake target mss_event_queue_bench, or
+//   g++ -O2 -std=c++17 -I.. EventQueueBenchmark.cpp ../EventQueue.cpp
+
+#include "EventQueue.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const EventQueueKind ALL_KINDS[] = {
+    EventQueueKind::BINARY_HEAP,
+    EventQueueKind::QUAD_HEAP,
+    EventQueueKind::CALENDAR,
+    EventQueueKind::LADDER
+};
+
+// Average nanoseconds per hold operation (pop + push)
+double measureHold(EventQueueKind kind, int devices, const std::vector<double>& increments) {
+    std::unique_ptr<EventQueue> queue = makeEventQueue(kind);
+    for (int i = 0; i < devices; ++i) {
+        queue->push(Event{ increments[i % increments.size()], 0, EventType::REQUEST_SERVED, i + 1 });
+    }
+
+    const std::size_t operations = increments.size();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t op = 0; op < operations; ++op) {
+        Event ev = queue->pop();
+        ev.time += increments[op];
+        queue->push(ev);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / operations;
+}
+
+} // namespace
+
+int main() {
+    const double serviceRate = 1.0 / (40.0 / 60.0);
+    const std::size_t operations = 2000000;
+
+    // Pre-generated increments, so the RNG stays out of the timed loop
+    std::mt19937_64 rng(12345);
+    std::exponential_distribution<double> service(serviceRate);
+    std::vector<double> increments(operations);
+    for (double& x : increments) {
+        x = service(rng);
+    }
+
+    std::printf("%-10s %12s %12s %12s\n", "queue", "10 dev", "1000 dev", "100000 dev");
+    for (EventQueueKind kind : ALL_KINDS) {
+        std::printf("%-10s", eventQueueKindName(kind));
+        for (int devices : { 10, 1000, 100000 }) {
+            std::printf(" %9.1f ns", measureHold(kind, devices, increments));
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Google Benchmark suite for the simulator's hot paths: Buffer::addRequest,
+// the Controller's event queue, dispatch to free devices and the whole
+// work() loop with tracing off.
+//
+// Build: cmake target mss_bench, or
+//   g++ -O2 -std=c++17 -I.. SimulationBenchmark.cpp $(ls ../*.cpp | grep -v main.cpp) -lbenchmark -lpthread
+// Run:   ./a.out --benchmark_out=results.json --benchmark_out_format=json
+
+#include "Simulation.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+// A silent Controller with the given devices and buffer capacity
+SimulationConfig benchConfig(int devices, int bufferCapacity = BUFFER_SIZE) {
+    SimulationConfig config;
+    config.numDevices = devices;
+    config.bufferCapacity = bufferCapacity;
+    config.traceLevel = TraceLevel::OFF;
+    return config;
+}
+
+// Take a fresh request of the given priority from the Controller's pool
+RequestHandle newRequest(Controller& controller, Priority priority, double arrival = 0.0) {
+    int id = ++controller.getGlobalRequestIdRef();
+    return controller.getRequestPool().acquire(id, priority, arrival, 0);
+}
+
+//------------------------------------------------------------------------------
+// Buffer::addRequest
+//------------------------------------------------------------------------------
+
+// Insert into an empty buffer (the request is popped again, untimed work is tiny)
+void BM_BufferAddEmpty(benchmark::State& state) {
+    Controller controller(benchConfig(1, static_cast<int>(state.range(0))));
+    Buffer& buffer = controller.getBuffer();
+    RequestHandle req = newRequest(controller, Priority::PREMIUM);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.addRequest(req));
+        benchmark::DoNotOptimize(buffer.popRequest());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferAddEmpty)->Arg(8)->Arg(1024);
+
+// Full of CORPORATE requests: every FREE newcomer is rejected
+void BM_BufferAddFullReject(benchmark::State& state) {
+    int capacity = static_cast<int>(state.range(0));
+    Controller controller(benchConfig(1, capacity));
+    Buffer& buffer = controller.getBuffer();
+    for (int i = 0; i < capacity; ++i) {
+        buffer.addRequest(newRequest(controller, Priority::CORPORATE));
+    }
+    RequestHandle req = newRequest(controller, Priority::FREE);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.addRequest(req));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferAddFullReject)->Arg(8)->Arg(1024);
+
+// Full of FREE requests: every CORPORATE newcomer evicts one; the buffer is
+// refilled with FREE requests (untimed) once they are all gone
+void BM_BufferAddEvict(benchmark::State& state) {
+    int capacity = static_cast<int>(state.range(0));
+    Controller controller(benchConfig(1, capacity));
+    Buffer& buffer = controller.getBuffer();
+    RequestPool& pool = controller.getRequestPool();
+
+    auto refill = [&]() {
+        while (!buffer.isEmpty()) {
+            pool.release(buffer.popRequest());
+        }
+        for (int i = 0; i < capacity; ++i) {
+            buffer.addRequest(newRequest(controller, Priority::FREE));
+        }
+    };
+    std::vector<RequestHandle> newcomers(capacity);
+    auto prepare = [&]() {
+        refill();
+        for (int i = 0; i < capacity; ++i) {
+            newcomers[i] = newRequest(controller, Priority::CORPORATE);
+        }
+    };
+
+    prepare();
+    int next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.addRequest(newcomers[next]));
+        if (++next == capacity) {
+            state.PauseTiming();
+            prepare();
+            next = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferAddEvict)->Arg(64)->Arg(1024);
+
+//------------------------------------------------------------------------------
+// Controller::pushEvent / popEvent
+//------------------------------------------------------------------------------
+
+// Hold model at a constant depth: pop the earliest event, push it back later
+void BM_EventHold(benchmark::State& state) {
+    EventQueueKind kind = static_cast<EventQueueKind>(state.range(0));
+    int depth = static_cast<int>(state.range(1));
+    Controller controller(benchConfig(1));
+    controller.setEventQueue(kind);
+
+    Philox4x32 rng(1, 0);
+    std::vector<double> increments(1 << 16);
+    for (double& dt : increments) {
+        dt = rng.exponential(SERVICE_RATE);
+    }
+    for (int i = 0; i < depth; ++i) {
+        controller.pushEvent(Event{ increments[i % increments.size()], 0, EventType::REQUEST_SERVED, 1 });
+    }
+
+    std::size_t op = 0;
+    for (auto _ : state) {
+        Event ev = controller.popEvent();
+        ev.time += increments[op++ & (increments.size() - 1)];
+        controller.pushEvent(ev);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(eventQueueKindName(kind));
+}
+BENCHMARK(BM_EventHold)->ArgsProduct({
+    { static_cast<int>(EventQueueKind::BINARY_HEAP), static_cast<int>(EventQueueKind::QUAD_HEAP),
+      static_cast<int>(EventQueueKind::CALENDAR), static_cast<int>(EventQueueKind::LADDER) },
+    { 10, 1000, 100000 } });
+
+//------------------------------------------------------------------------------
+// Controller::loadRequestsToFreeDevices
+//------------------------------------------------------------------------------
+
+// Half of the devices stay busy; each iteration buffers one request,
+// dispatches it, and completes it again
+void BM_LoadRequestsToFreeDevices(benchmark::State& state) {
+    int devices = static_cast<int>(state.range(0));
+    Controller controller(benchConfig(devices));
+    Buffer& buffer = controller.getBuffer();
+
+    double now = 0.0;
+    for (int i = 0; i < devices / 2; ++i) {
+        buffer.addRequest(newRequest(controller, Priority::PREMIUM));
+        controller.loadRequestsToFreeDevices(now);
+    }
+    while (!controller.eventsEmpty()) {
+        controller.popEvent();
+    }
+
+    for (auto _ : state) {
+        now += 1e-6;
+        buffer.addRequest(newRequest(controller, Priority::PREMIUM, now));
+        controller.loadRequestsToFreeDevices(now);
+        Event done = controller.popEvent();
+        controller.handleRequestFinished(done.deviceId, now, done.request);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadRequestsToFreeDevices)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+//------------------------------------------------------------------------------
+// Controller::work
+//------------------------------------------------------------------------------
+
+// Whole runs with tracing off; reports processed events per second
+void BM_Work(benchmark::State& state) {
+    SimulationConfig config = benchConfig(static_cast<int>(state.range(0)));
+    config.maxRequests = static_cast<int>(state.range(1));
+    config.numFree = 6 * config.numDevices / 5;
+    config.numPremium = 4 * config.numDevices / 5;
+    config.numCorporate = 2 * config.numDevices / 5;
+
+    std::int64_t events = 0;
+    for (auto _ : state) {
+        Controller controller(config);
+        controller.initRequests();
+        controller.work();
+        SimulationResults results = controller.getResults();
+        // One arrival event per generated request, one completion per served one
+        events += results.generatedRequests + results.servedRequests;
+    }
+    state.counters["events/s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Work)->Args({ 5, 20000 })->Args({ 50, 100000 })->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -1,16 +1,468 @@
     #include <iostream>
-    #include "simulation.hpp"
+    #include <string>
+    #include <cstdlib>
+    #include "Simulation.hpp"
+    #include "Replication.hpp"
+    #include "Sweep.hpp"
+    #include "Config.hpp"
+    #include "Sharded.hpp"
+    #include "Instrumentation.hpp"
 
-    int main() {
+    namespace {
+
+    void printUsage(const char* program) {
+        std::cerr << "Usage: " << program
+            << " [--trace=off|summary|full] [--queue=binary|heap4|calendar|ladder]"
+            << " [--dispatch=lowest|round-robin|least-utilized] [--buffer=N]"
+            << " [--buffer-policy=priority|fifo|edf|wfq|quota|early-drop]"
+            << " [--replications=N] [--threads=N] [--seed=N] [--arrivals=FILE]\n"
+            << "       [--config=FILE.toml] [--max-requests=N] [--max-hours=H] [--precision=REL]"
+            << " [--windows=FILE] [--window=HOURS] [--event-log=FILE]\n"
+            << "       [--shards=N] [--shard-window=MIN]"
+            << " [--snapshot=FILE] [--snapshot-every=H] [--restore=FILE]\n"
+            << "       [--corporate=R] [--premium=R] [--free=R] [--devices=R] [--buffer=R]"
+            << " [--sweep=FILE.csv] [--max-rejection=P] [--max-wait=MIN] [--no-prune] [--analytic]\n"
+            << "       [--crn] [--antithetic] [--compare=FILE.toml] [--replay=FILE.trace]\n"
+            << "       [--metrics-file=FILE] [--metrics-every=SECONDS] [--metrics-format=prometheus|influx]\n"
+            << "  R is N, A:B or A:B:S; ranges other than N need --sweep\n"
+            << "  Flags apply in order: later ones override a --config file\n"
+            << "  --restore resumes a snapshot under its own seed (forks it with another --seed\n"
+            << "    or --replications)\n"
+            << "  --compare runs the config and the config with FILE applied on common random\n"
+            << "    numbers and prints the paired differences (needs --replications)\n"
+            << "  --metrics-file samples the live event loops into FILE (needs a build with\n"
+            << "    MSS_INSTRUMENTATION)\n";
+    }
+
+    // Name the problem with the command line, then print the usage; returns
+    // main's exit code
+    int rejectArguments(const char* program, const std::string& problem) {
+        std::cerr << problem << "\n";
+        printUsage(program);
+        return 1;
+    }
+
+    // If arg starts with flag, store the rest in value
+    bool matchFlag(const std::string& arg, const char* flag, std::string& value) {
+        std::string prefix = flag;
+        if (arg.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        value = arg.substr(prefix.size());
+        return true;
+    }
+
+    } // namespace
+
+    int main(int argc, char* argv[]) {
         // 2 corp, 4 prem, 6 free,
         // 5 devices, 5000 requests
-        Controller controller(2, 4, 6, 5, 5000);
+        SimulationConfig config;
+        int replications = 1;
+        int threads = 0;
+        SweepGrid grid;
+        SweepTargets targets;
+        std::string sweepPath;
+        bool prune = true;
+        bool analytic = false;
+        int shards = 0;
+        double shardWindowHours = 0.0;
+        std::string snapshotPath;
+        double snapshotHours = 0.0;
+        std::string restorePath;
+        std::string comparePath;
+        std::string metricsPath;
+        double metricsSeconds = 1.0;
+        MetricsFormat metricsFormat = MetricsFormat::PROMETHEUS;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string value;
+            bool ok = false;
+            if (matchFlag(arg, "--config=", value)) {
+                std::string error;
+                if (!loadConfigFile(value, config, error)) {
+                    std::cerr << error << "\n";
+                    return 1;
+                }
+                // The file's workload becomes the single grid point
+                grid.corporate = SweepRange{ config.numCorporate, config.numCorporate, 1 };
+                grid.premium = SweepRange{ config.numPremium, config.numPremium, 1 };
+                grid.free = SweepRange{ config.numFree, config.numFree, 1 };
+                grid.devices = SweepRange{ config.numDevices, config.numDevices, 1 };
+                grid.buffer = SweepRange{ config.bufferCapacity, config.bufferCapacity, 1 };
+                ok = true;
+            }
+            else if (matchFlag(arg, "--trace=", value)) {
+                ok = parseTraceLevel(value, config.traceLevel);
+            }
+            else if (matchFlag(arg, "--queue=", value)) {
+                ok = parseEventQueueKind(value, config.queueKind);
+            }
+            else if (matchFlag(arg, "--dispatch=", value)) {
+                ok = parseDispatchPolicy(value, config.dispatchPolicy);
+            }
+            else if (matchFlag(arg, "--buffer-policy=", value)) {
+                ok = parseBufferPolicyKind(value, config.bufferPolicy.kind);
+            }
+            else if (matchFlag(arg, "--buffer=", value)) {
+                ok = parseSweepRange(value, grid.buffer) && grid.buffer.first > 0;
+            }
+            else if (matchFlag(arg, "--corporate=", value)) {
+                ok = parseSweepRange(value, grid.corporate);
+            }
+            else if (matchFlag(arg, "--premium=", value)) {
+                ok = parseSweepRange(value, grid.premium);
+            }
+            else if (matchFlag(arg, "--free=", value)) {
+                ok = parseSweepRange(value, grid.free);
+            }
+            else if (matchFlag(arg, "--devices=", value)) {
+                ok = parseSweepRange(value, grid.devices) && grid.devices.first > 0;
+            }
+            else if (matchFlag(arg, "--sweep=", value)) {
+                sweepPath = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--max-rejection=", value)) {
+                targets.maxRejectionRate = std::atof(value.c_str());
+                ok = targets.maxRejectionRate >= 0.0;
+            }
+            else if (matchFlag(arg, "--max-wait=", value)) {
+                targets.maxWaitHours = std::atof(value.c_str()) / 60.0;
+                ok = targets.maxWaitHours >= 0.0;
+            }
+            else if (matchFlag(arg, "--max-requests=", value)) {
+                config.maxRequests = std::atoi(value.c_str());
+                ok = config.maxRequests > 0;
+            }
+            else if (matchFlag(arg, "--max-hours=", value)) {
+                config.maxTimeHours = std::atof(value.c_str());
+                ok = config.maxTimeHours > 0.0;
+            }
+            else if (matchFlag(arg, "--precision=", value)) {
+                config.targetPrecision = std::atof(value.c_str());
+                ok = config.targetPrecision > 0.0;
+            }
+            else if (matchFlag(arg, "--windows=", value)) {
+                config.windowFile = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--event-log=", value)) {
+                config.eventLogFile = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--window=", value)) {
+                config.windowHours = std::atof(value.c_str());
+                ok = config.windowHours > 0.0;
+            }
+            else if (matchFlag(arg, "--arrivals=", value)) {
+                std::vector<double> rates;
+                ok = loadRateProfile(value, rates);
+                for (ArrivalSpec& spec : config.arrivals) {
+                    spec.rates = rates;
+                }
+            }
+            else if (matchFlag(arg, "--shards=", value)) {
+                shards = std::atoi(value.c_str());
+                ok = shards > 0;
+            }
+            else if (matchFlag(arg, "--shard-window=", value)) {
+                shardWindowHours = std::atof(value.c_str()) / 60.0;
+                ok = shardWindowHours > 0.0;
+            }
+            else if (matchFlag(arg, "--snapshot=", value)) {
+                snapshotPath = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--snapshot-every=", value)) {
+                snapshotHours = std::atof(value.c_str());
+                ok = snapshotHours > 0.0;
+            }
+            else if (matchFlag(arg, "--restore=", value)) {
+                restorePath = value;
+                ok = !value.empty();
+            }
+            else if (arg == "--no-prune") {
+                prune = false;
+                ok = true;
+            }
+            else if (arg == "--analytic") {
+                analytic = true;
+                ok = true;
+            }
+            else if (arg == "--crn") {
+                config.commonRandomNumbers = true;
+                ok = true;
+            }
+            else if (arg == "--antithetic") {
+                config.antithetic = true;
+                ok = true;
+            }
+            else if (matchFlag(arg, "--replay=", value)) {
+                config.replayFile = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--compare=", value)) {
+                comparePath = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--metrics-file=", value)) {
+                metricsPath = value;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--metrics-every=", value)) {
+                metricsSeconds = std::atof(value.c_str());
+                ok = metricsSeconds > 0.0;
+            }
+            else if (matchFlag(arg, "--metrics-format=", value)) {
+                ok = parseMetricsFormat(value, metricsFormat);
+            }
+            else if (matchFlag(arg, "--replications=", value)) {
+                replications = std::atoi(value.c_str());
+                ok = replications > 0;
+            }
+            else if (matchFlag(arg, "--seed=", value)) {
+                config.seed = std::strtoull(value.c_str(), nullptr, 10);
+                config.seedGiven = true;
+                ok = !value.empty();
+            }
+            else if (matchFlag(arg, "--threads=", value)) {
+                threads = std::atoi(value.c_str());
+                ok = threads > 0;
+            }
+            if (!ok) {
+                return rejectArguments(argv[0], "Invalid argument: " + arg);
+            }
+        }
+
+        // A sharded run is one system: no sweep, replications or precision rule
+        if (shards > 0 && !sweepPath.empty()) {
+            return rejectArguments(argv[0], "--shards cannot be combined with --sweep");
+        }
+        if (shards > 0 && replications > 1) {
+            return rejectArguments(argv[0], "--shards cannot be combined with --replications");
+        }
+        if (shards > 0 && config.targetPrecision > 0.0) {
+            return rejectArguments(argv[0], "--shards cannot be combined with --precision");
+        }
+
+        // Snapshots hold one Controller: no sweep or shards; replications
+        // can fork a snapshot but not write one
+        bool snapshots = !snapshotPath.empty() || !restorePath.empty();
+        if (snapshots && !sweepPath.empty()) {
+            return rejectArguments(argv[0], "--snapshot and --restore cannot be combined with --sweep");
+        }
+        if (snapshots && shards > 0) {
+            return rejectArguments(argv[0], "--snapshot and --restore cannot be combined with --shards");
+        }
+        if (!snapshotPath.empty() && replications > 1) {
+            return rejectArguments(argv[0], "--snapshot cannot be combined with --replications (--restore can)");
+        }
+        if (snapshotHours > 0.0 && snapshotPath.empty()) {
+            return rejectArguments(argv[0], "--snapshot-every needs --snapshot");
+        }
+
+        // Antithetic pairs and paired comparisons are made of replications
+        bool compare = !comparePath.empty();
+        if (config.antithetic && replications % 2 != 0) {
+            return rejectArguments(argv[0], "--antithetic needs an even number of --replications");
+        }
+        if (config.antithetic && shards > 0) {
+            return rejectArguments(argv[0], "--antithetic cannot be combined with --shards");
+        }
+        if (compare && replications < 2) {
+            return rejectArguments(argv[0], "--compare needs --replications of at least 2");
+        }
+        if (compare && (!sweepPath.empty() || shards > 0 || snapshots || analytic)) {
+            return rejectArguments(argv[0],
+                "--compare cannot be combined with --sweep, --shards, --snapshot, --restore or --analytic");
+        }
+
+        // A trace is one arrival stream: it cannot be split over shards or modelled
+        if (!config.replayFile.empty()) {
+            ArrivalTrace trace;
+            std::string error;
+            if (shards > 0) {
+                return rejectArguments(argv[0], "a replayed trace cannot be split over --shards");
+            }
+            if (analytic) {
+                return rejectArguments(argv[0], "--analytic cannot model a replayed trace");
+            }
+            if (!trace.open(config.replayFile, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+        }
+
+        // Shards are default Controllers and move requests without their
+        // timers, and the model's split over the priorities assumes the
+        // priority buffer and requests that wait until served
+        const char* modelled = (shards > 0) ? "--shards" : "--analytic";
+        if (config.bufferPolicy.kind != BufferPolicyKind::PRIORITY && (shards > 0 || analytic)) {
+            return rejectArguments(argv[0], std::string(modelled) + " needs --buffer-policy=priority, not "
+                + bufferPolicyKindName(config.bufferPolicy.kind));
+        }
+        if (config.abandons() && (shards > 0 || analytic)) {
+            return rejectArguments(argv[0], std::string(modelled) + " does not support [patience] or [retry]");
+        }
+
+        // The model replaces one run; a sweep computes it for every point anyway
+        if (analytic && (!sweepPath.empty() || shards > 0 || snapshots || replications > 1)) {
+            return rejectArguments(argv[0],
+                "--analytic cannot be combined with --sweep, --shards, --snapshot, --restore or --replications");
+        }
+
+        // Sampled until main returns, after the last loop has finished
+        MetricsSampler sampler;
+        if (!metricsPath.empty()) {
+    #if defined(MSS_INSTRUMENTATION)
+            if (!sampler.start(metricsPath, metricsFormat, metricsSeconds)) {
+                std::cerr << "Cannot write " << metricsPath << "\n";
+                return 1;
+            }
+    #else
+            std::cerr << "--metrics-file needs a build with MSS_INSTRUMENTATION\n";
+            return 1;
+    #endif
+        }
+
+        if (!sweepPath.empty()) {
+            // Every grid point, written as one CSV row each
+            SweepRunner sweep(config, grid, targets, replications, threads, prune);
+            std::vector<SweepPoint> points;
+            std::string error;
+            if (!sweep.run(points, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            if (!writeSweepCsv(points, sweepPath)) {
+                std::cerr << "Cannot write " << sweepPath << "\n";
+                return 1;
+            }
+            printSweepSummary(points);
+            return 0;
+        }
+
+        if (!grid.corporate.isSingle() || !grid.premium.isSingle() || !grid.free.isSingle()
+            || !grid.devices.isSingle() || !grid.buffer.isSingle()) {
+            return rejectArguments(argv[0], "ranges of --corporate, --premium, --free, --devices or --buffer need --sweep");
+        }
+        config.numCorporate = grid.corporate.first;
+        config.numPremium = grid.premium.first;
+        config.numFree = grid.free.first;
+        config.numDevices = grid.devices.first;
+        config.bufferCapacity = grid.buffer.first;
+
+        if (analytic) {
+            // Closed-form estimate instead of a simulation
+            printAnalyticEstimate(analyzeConfig(config));
+            return 0;
+        }
+
+        // One mapping serves the single run or every replication
+        MappedFile snapshot;
+        if (!restorePath.empty() && !snapshot.open(restorePath)) {
+            std::cerr << "Cannot read " << restorePath << "\n";
+            return 1;
+        }
+        // Without an explicit seed a restore resumes; only another seed forks
+        if (!restorePath.empty() && !config.seedGiven
+            && !readSnapshotSeed(snapshot.data(), snapshot.size(), config.seed)) {
+            std::cerr << restorePath << ": not a snapshot of this version\n";
+            return 1;
+        }
+
+        if (compare) {
+            // Both configs on the same seeds and keyed service demands
+            config.commonRandomNumbers = true;
+            SimulationConfig alternative = config;
+            std::string error;
+            if (!loadConfigFile(comparePath, alternative, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            alternative.seed = config.seed; // the pairs must share their seeds
+            std::vector<SimulationResults> base;
+            std::vector<SimulationResults> other;
+            if (!ReplicationRunner(config, threads).run(replications, base, error)
+                || !ReplicationRunner(alternative, threads).run(replications, other, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            printReplicationComparison(compareReplications(base, other, config.antithetic));
+            return 0;
+        }
+
+        if (replications > 1) {
+            // Independent replications in parallel, merged into 95% CIs
+            ReplicationRunner runner(config, threads);
+            if (!restorePath.empty()) {
+                // Check the snapshot once before the workers fork it
+                SimulationConfig probeConfig = config;
+                probeConfig.traceLevel = TraceLevel::OFF;
+                probeConfig.windowFile.clear();
+                probeConfig.eventLogFile.clear();
+                std::string error;
+                bool fits = withController(probeConfig, [&snapshot, &error](auto& probe) {
+                    return probe.restoreSnapshot(snapshot.data(), snapshot.size(), error);
+                });
+                if (!fits) {
+                    std::cerr << restorePath << ": " << error << "\n";
+                    return 1;
+                }
+                runner.setSnapshot(&snapshot);
+            }
+            std::vector<SimulationResults> results;
+            std::string error;
+            if (!runner.run(replications, results, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            printReplicationSummary(ReplicationRunner::summarize(results, config.antithetic));
+            return 0;
+        }
+
+        if (shards > 0) {
+            // One system split over parallel shards
+            ShardedSimulation simulation(config, shards, shardWindowHours);
+            if (!simulation.getSetupError().empty()) {
+                std::cerr << simulation.getSetupError() << "\n";
+                return 1;
+            }
+            SimulationResults results = simulation.run();
+            printShardedResults(results, simulation);
+            return 0;
+        }
 
-        controller.initRequests();
+        // The Controller of the buffer policy; each has its own event loop
+        return withController(config, [&](auto& controller) {
+            if (!controller.getSetupError().empty()) {
+                std::cerr << controller.getSetupError() << "\n";
+                return 1;
+            }
+            if (!restorePath.empty()) {
+                std::string error;
+                if (!controller.restoreSnapshot(snapshot.data(), snapshot.size(), error)) {
+                    std::cerr << restorePath << ": " << error << "\n";
+                    return 1;
+                }
+            }
+            else {
+                controller.initRequests();
+            }
+            if (!snapshotPath.empty()) {
+                controller.setCheckpoint(snapshotPath, snapshotHours);
+            }
 
-        controller.work();
+            controller.work();
 
-        controller.printStatistics();
+            controller.printStatistics();
 
-        return 0;
-    }
\ No newline at end of file
+            if (!controller.getRunError().empty()) {
+                std::cerr << controller.getRunError() << "\n";
+                return 1;
+            }
+            return 0;
+        });
+    }
@@ -0,0 +1,105 @@
+/*
+ * C ABI of the simulator (library target mss_capi).
+ *
+ * A scenario is an opaque mss_config built from the defaults of the CLI,
+ * changed with scenario text in the TOML subset of Config.hpp and with
+ * integer setters for the values a search loop varies. Results come back
+ * in a plain struct. Nothing here prints or writes files, and every call is thread-safe on
+ * distinct configs; mss_run_batch runs many scenarios on its own threads.
+ *
+ * Compatibility: functions are only ever added. mss_results only grows at
+ * its end; callers set struct_size, and the library fills no more than
+ * that, so a caller built against an older header keeps working.
+ */
+#ifndef MSS_H
+#define MSS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(MSS_CAPI_BUILD)
+#define MSS_API __declspec(dllexport)
+#else
+#define MSS_API __declspec(dllimport)
+#endif
+#else
+#define MSS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped when functions or result fields are added */
+#define MSS_ABI_VERSION 2
+
+/* Priorities, in the order of every per-priority array */
+#define MSS_PRIORITIES 3 /* corporate, premium, free */
+
+typedef struct mss_config mss_config;
+
+typedef struct mss_results {
+    uint32_t struct_size;       /* set to sizeof(mss_results) before a call */
+    uint32_t precision_reached; /* 1 if stopped by the precision target */
+    int64_t generated;
+    int64_t served;
+    int64_t rejected;           /* rejected or evicted */
+    int64_t rejected_by_priority[MSS_PRIORITIES];
+    double rejection_rate;      /* rejected / generated */
+    double average_wait_hours;
+    double simulation_hours;
+    double mean_utilization;    /* over all devices, 0..1 */
+    double peak_utilization;    /* busiest window */
+    double peak_rejection_rate; /* window with the most rejections */
+    double steady_wait_hours;   /* MSER-5 truncated estimate ... */
+    double steady_wait_half_width; /* ... and its 95% half-width */
+    double wait_p50_hours[MSS_PRIORITIES];
+    double wait_p95_hours[MSS_PRIORITIES];
+    double wait_p99_hours[MSS_PRIORITIES];
+    double sojourn_mean_hours[MSS_PRIORITIES];
+    double sojourn_p95_hours[MSS_PRIORITIES];
+} mss_results;
+
+/* MSS_ABI_VERSION of the loaded library */
+MSS_API uint32_t mss_abi_version(void);
+
+/* A scenario with the CLI defaults and the trace off; NULL if out of memory */
+MSS_API mss_config* mss_config_create(void);
+MSS_API mss_config* mss_config_clone(const mss_config* config);
+MSS_API void mss_config_destroy(mss_config* config);
+
+/* Apply scenario text (the TOML subset of Config.hpp) on top of the
+ * config. The trace level and the [output] files are accepted but have no
+ * effect, since runs write nothing. Returns 0 on success; otherwise -1 and, when error is not NULL,
+ * a NUL-terminated "line N: message" truncated to error_size bytes. */
+MSS_API int mss_config_apply(mss_config* config, const char* toml, char* error, size_t error_size);
+
+/* Set one integer value: "corporate", "premium", "free" (sources per
+ * priority), "devices", "buffer", "max_requests" or "seed"; or 0/1 for
+ * "crn" (service demands keyed by request id, so scenarios with one seed
+ * see the same workload) and "antithetic" (every uniform u drawn as 1 - u).
+ * Returns 0, or -1 for an unknown key or a value out of range. */
+MSS_API int mss_config_set_int(mss_config* config, const char* key, int64_t value);
+
+/* Run one scenario to its stopping rule and fill the first struct_size
+ * bytes of results. Returns 0, or -1 on NULL arguments or a scenario that
+ * cannot be set up (a replay trace that cannot be read); mss_last_error()
+ * then says why and results are left unchanged. */
+MSS_API int mss_run(const mss_config* config, mss_results* results);
+
+/* Run count scenarios on up to threads threads (0: every hardware thread);
+ * results[i] belongs to configs[i], and each results[i].struct_size must be
+ * set. Returns 0 or -1 as mss_run; on -1 no results are filled and
+ * mss_last_error() names the first scenario that failed. */
+MSS_API int mss_run_batch(const mss_config* const* configs, size_t count, int threads, mss_results* results);
+
+/* Message of the calling thread's last mss_run or mss_run_batch that
+ * returned -1 (since ABI version 2); valid until that thread's next call. */
+MSS_API const char* mss_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MSS_H */
@@ -0,0 +1,161 @@
+"""In-process simulator runs through the C ABI of mss.h.
+
+Loads the mss_capi shared library with ctypes: set MSS_LIBRARY to its
+path, or keep it in this directory or in ../build. ctypes releases the GIL
+for the length of every call, so Python threads may run scenarios side by
+side; run_batch() runs a whole batch on the library's own threads.
+
+    import mss
+    base = mss.Scenario(devices=5, max_requests=20000)
+    base.apply('[stop]\\nprecision = 0.05\\n')
+    points = [base.copy(devices=d) for d in range(3, 9)]
+    for d, r in zip(range(3, 9), mss.run_batch(points)):
+        print(d, r.rejection_rate, r.average_wait_hours)
+"""
+
+import ctypes
+import os
+
+ABI_VERSION = 2
+PRIORITIES = 3  # corporate, premium, free
+
+
+class Results(ctypes.Structure):
+    """mss_results: the figures printStatistics prints"""
+    _fields_ = [
+        ("struct_size", ctypes.c_uint32),
+        ("precision_reached", ctypes.c_uint32),
+        ("generated", ctypes.c_int64),
+        ("served", ctypes.c_int64),
+        ("rejected", ctypes.c_int64),
+        ("rejected_by_priority", ctypes.c_int64 * PRIORITIES),
+        ("rejection_rate", ctypes.c_double),
+        ("average_wait_hours", ctypes.c_double),
+        ("simulation_hours", ctypes.c_double),
+        ("mean_utilization", ctypes.c_double),
+        ("peak_utilization", ctypes.c_double),
+        ("peak_rejection_rate", ctypes.c_double),
+        ("steady_wait_hours", ctypes.c_double),
+        ("steady_wait_half_width", ctypes.c_double),
+        ("wait_p50_hours", ctypes.c_double * PRIORITIES),
+        ("wait_p95_hours", ctypes.c_double * PRIORITIES),
+        ("wait_p99_hours", ctypes.c_double * PRIORITIES),
+        ("sojourn_mean_hours", ctypes.c_double * PRIORITIES),
+        ("sojourn_p95_hours", ctypes.c_double * PRIORITIES),
+    ]
+
+    def __init__(self):
+        super().__init__()
+        self.struct_size = ctypes.sizeof(Results)
+
+    def as_dict(self):
+        return {name: (list(value) if isinstance(value, ctypes.Array) else value)
+                for name, value in ((n, getattr(self, n)) for n, _ in self._fields_)
+                if name != "struct_size"}
+
+
+def _find_library():
+    path = os.environ.get("MSS_LIBRARY")
+    if path:
+        return path
+    here = os.path.dirname(os.path.abspath(__file__))
+    names = ("libmss_capi.so", "libmss_capi.dylib", "mss_capi.dll")
+    for directory in (here, os.path.join(here, "..", "build"), os.path.join(here, "..", "build", "Release")):
+        for name in names:
+            candidate = os.path.join(directory, name)
+            if os.path.exists(candidate):
+                return candidate
+    raise OSError("mss_capi library not found; set MSS_LIBRARY")
+
+
+def _load():
+    lib = ctypes.CDLL(_find_library())
+    config_p = ctypes.c_void_p
+    lib.mss_abi_version.restype = ctypes.c_uint32
+    lib.mss_abi_version.argtypes = []
+    lib.mss_config_create.restype = config_p
+    lib.mss_config_create.argtypes = []
+    lib.mss_config_clone.restype = config_p
+    lib.mss_config_clone.argtypes = [config_p]
+    lib.mss_config_destroy.restype = None
+    lib.mss_config_destroy.argtypes = [config_p]
+    lib.mss_config_apply.restype = ctypes.c_int
+    lib.mss_config_apply.argtypes = [config_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+    lib.mss_config_set_int.restype = ctypes.c_int
+    lib.mss_config_set_int.argtypes = [config_p, ctypes.c_char_p, ctypes.c_int64]
+    lib.mss_run.restype = ctypes.c_int
+    lib.mss_run.argtypes = [config_p, ctypes.POINTER(Results)]
+    lib.mss_run_batch.restype = ctypes.c_int
+    lib.mss_run_batch.argtypes = [ctypes.POINTER(config_p), ctypes.c_size_t, ctypes.c_int, ctypes.POINTER(Results)]
+    lib.mss_last_error.restype = ctypes.c_char_p
+    lib.mss_last_error.argtypes = []
+    if lib.mss_abi_version() < ABI_VERSION:
+        raise OSError("mss_capi is older than this module")
+    return lib
+
+
+_lib = _load()
+
+
+class Scenario:
+    """One mss_config: the CLI defaults with the trace off
+
+    Keyword arguments are the integer keys of mss_config_set_int:
+    corporate, premium, free, devices, buffer, max_requests and seed, and
+    the 0/1 switches crn and antithetic. Scenarios compared on one seed
+    with crn=1 differ only by their fleet, not by their workload.
+    """
+
+    def __init__(self, toml=None, **values):
+        self._handle = _lib.mss_config_create()
+        if not self._handle:
+            raise MemoryError()
+        if toml:
+            self.apply(toml)
+        self.set(**values)
+
+    def __del__(self):
+        handle = getattr(self, "_handle", None)
+        if handle:
+            _lib.mss_config_destroy(handle)
+            self._handle = None
+
+    def apply(self, toml):
+        """Apply scenario text in the TOML subset of Config.hpp"""
+        error = ctypes.create_string_buffer(256)
+        if _lib.mss_config_apply(self._handle, toml.encode(), error, len(error)) != 0:
+            raise ValueError(error.value.decode())
+        return self
+
+    def set(self, **values):
+        for key, value in values.items():
+            if _lib.mss_config_set_int(self._handle, key.encode(), int(value)) != 0:
+                raise ValueError("bad value %r for %s" % (value, key))
+        return self
+
+    def copy(self, **values):
+        """A clone with some integer values changed"""
+        clone = Scenario.__new__(Scenario)
+        clone._handle = _lib.mss_config_clone(self._handle)
+        if not clone._handle:
+            raise MemoryError()
+        return clone.set(**values)
+
+    def run(self):
+        """Run to the stopping rule (the GIL is released meanwhile)"""
+        results = Results()
+        if _lib.mss_run(self._handle, ctypes.byref(results)) != 0:
+            raise RuntimeError(_lib.mss_last_error().decode())
+        return results
+
+
+def run_batch(scenarios, threads=0):
+    """Run every scenario on the library's threads; results in input order"""
+    scenarios = list(scenarios)
+    handles = (ctypes.c_void_p * len(scenarios))(*(s._handle for s in scenarios))
+    results = (Results * len(scenarios))()
+    for r in results:
+        r.struct_size = ctypes.sizeof(Results)
+    if _lib.mss_run_batch(handles, len(scenarios), threads, results) != 0:
+        raise RuntimeError(_lib.mss_last_error().decode())
+    return list(results)
@@ -0,0 +1,100 @@
+// Closed-form queueing models against values computed by hand
+
+#include "Check.hpp"
+#include "Analytic.hpp"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// M/M/c/K state probabilities straight from the birth-death balance
+// equations, unscaled: fine for the small systems checked here
+std::vector<double> birthDeath(double lambda, double mu, int servers, int waitingPlaces) {
+    std::vector<double> p(servers + waitingPlaces + 1);
+    p[0] = 1.0;
+    for (std::size_t n = 1; n < p.size(); ++n) {
+        p[n] = p[n - 1] * lambda / (mu * std::min<double>(static_cast<double>(n), servers));
+    }
+    double total = 0.0;
+    for (double x : p) {
+        total += x;
+    }
+    for (double& x : p) {
+        x /= total;
+    }
+    return p;
+}
+
+} // namespace
+
+TEST_CASE(analytic, mm1k_blocking_closed_form) {
+    // M/M/1/K with K places in all: (1 - rho) rho^K / (1 - rho^(K + 1))
+    const double rho = 0.8;
+    const int places = 5; // one in service, four waiting
+    QueueMetrics m = solveMMcK(0.8, 1.0, 1, places - 1);
+    double blocking = (1.0 - rho) * std::pow(rho, places) / (1.0 - std::pow(rho, places + 1));
+    CHECK_NEAR(m.blocking, blocking, 1e-12);
+}
+
+TEST_CASE(analytic, mmck_matches_balance_equations) {
+    const double lambda = 7.0;
+    const double mu = 1.5;
+    const int servers = 4;
+    const int waiting = 6;
+    std::vector<double> p = birthDeath(lambda, mu, servers, waiting);
+
+    double meanQueue = 0.0;
+    double allBusy = 0.0;
+    double busy = 0.0;
+    for (std::size_t n = 0; n < p.size(); ++n) {
+        int inService = std::min<int>(static_cast<int>(n), servers);
+        meanQueue += p[n] * (static_cast<int>(n) - inService);
+        allBusy += (static_cast<int>(n) >= servers) ? p[n] : 0.0;
+        busy += p[n] * inService;
+    }
+    double blocking = p.back();
+
+    QueueMetrics m = solveMMcK(lambda, mu, servers, waiting);
+    CHECK_NEAR(m.blocking, blocking, 1e-12);
+    CHECK_NEAR(m.meanQueue, meanQueue, 1e-10);
+    CHECK_NEAR(m.allBusy, allBusy, 1e-12);
+    CHECK_NEAR(m.utilization, busy / servers, 1e-12);
+    // Little's law over the admitted arrivals
+    CHECK_NEAR(m.meanWait, meanQueue / (lambda * (1.0 - blocking)), 1e-10);
+}
+
+TEST_CASE(analytic, large_fleets_do_not_overflow) {
+    QueueMetrics m = solveMMcK(9500.0, 1.0, 10000, 2000);
+    CHECK(std::isfinite(m.blocking) && std::isfinite(m.meanWait));
+    CHECK(m.blocking >= 0.0 && m.blocking < 1e-6);
+    CHECK_NEAR(m.utilization, 0.95, 1e-6);
+}
+
+TEST_CASE(analytic, erlang_c) {
+    // c = 2, a = 1: (a^2 / 2!) (2 / (2 - 1)) / (1 + 1 + 1) = 1/3
+    CHECK_NEAR(erlangC(2, 1.0), 1.0 / 3.0, 1e-12);
+    // One server: the probability of waiting is the load
+    CHECK_NEAR(erlangC(1, 0.6), 0.6, 1e-12);
+    CHECK(erlangC(3, 3.0) == 1.0);
+}
+
+TEST_CASE(analytic, cobham_priority_waits) {
+    // M/M/1, mu = 1: W0 = sum of lambda_i / mu^2 = 0.5, and class k waits
+    // W0 / ((1 - sigma_(k-1)) (1 - sigma_k))
+    const double lambda[PRIORITY_COUNT] = { 0.2, 0.3, 0.0 };
+    double wait[PRIORITY_COUNT] = {};
+    priorityWaitMMc(lambda, 1.0, 1, wait);
+    CHECK_NEAR(wait[0], 0.5 / (1.0 * 0.8), 1e-12);
+    CHECK_NEAR(wait[1], 0.5 / (0.8 * 0.5), 1e-12);
+
+    // A single class is the plain M/M/1 wait rho / (mu - lambda)
+    const double single[PRIORITY_COUNT] = { 0.5, 0.0, 0.0 };
+    priorityWaitMMc(single, 1.0, 1, wait);
+    CHECK_NEAR(wait[0], 1.0, 1e-12);
+
+    const double saturated[PRIORITY_COUNT] = { 0.6, 0.6, 0.0 };
+    priorityWaitMMc(saturated, 1.0, 1, wait);
+    CHECK(std::isfinite(wait[0]));
+    CHECK(wait[1] == std::numeric_limits<double>::infinity());
+}
@@ -0,0 +1,144 @@
+// Admission, eviction and service order of the buffer policies
+
+#include "Check.hpp"
+#include "Simulation.hpp"
+
+namespace {
+
+// What a buffer counts and traces into, with the trace off
+struct BufferFixture {
+    RequestPool pool;
+    SimulationMetrics metrics;
+    TraceSink trace{ TraceLevel::OFF };
+    EventLogWriter eventLog;
+    WindowRecorder windows{ 1.0, 1 };
+
+    // A request of priority entering the buffer at time (id = its order)
+    RequestHandle make(Priority priority, double time) {
+        RequestHandle req = pool.acquire(static_cast<int>(pool.inUse()) + 1, priority, time, 0);
+        pool[req].setBufferEnterTime(time);
+        return req;
+    }
+
+    std::int64_t rejected(Priority priority) const {
+        return metrics.snapshot().byPriority[static_cast<int>(priority)].rejected;
+    }
+    std::int64_t evicted(Priority priority) const {
+        return metrics.snapshot().byPriority[static_cast<int>(priority)].evicted;
+    }
+};
+
+} // namespace
+
+TEST_CASE(buffer, priority_serves_highest_then_oldest) {
+    BufferFixture f;
+    Buffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 4);
+    RequestHandle free1 = f.make(Priority::FREE, 0.0);
+    RequestHandle premium = f.make(Priority::PREMIUM, 1.0);
+    RequestHandle corporate = f.make(Priority::CORPORATE, 2.0);
+    RequestHandle free2 = f.make(Priority::FREE, 3.0);
+    for (RequestHandle req : { free1, premium, corporate, free2 }) {
+        CHECK(buffer.addRequest(req));
+    }
+    CHECK(buffer.size() == 4);
+    CHECK(buffer.size(Priority::FREE) == 2);
+    CHECK(buffer.popRequest() == corporate);
+    CHECK(buffer.popRequest() == premium);
+    CHECK(buffer.popRequest() == free1);
+    CHECK(buffer.popRequest() == free2);
+    CHECK(buffer.isEmpty());
+    CHECK(buffer.popRequest() == INVALID_REQUEST);
+}
+
+TEST_CASE(buffer, full_priority_buffer_evicts_oldest_lower) {
+    BufferFixture f;
+    Buffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 2);
+    RequestHandle free1 = f.make(Priority::FREE, 0.0);
+    RequestHandle free2 = f.make(Priority::FREE, 1.0);
+    CHECK(buffer.addRequest(free1));
+    CHECK(buffer.addRequest(free2));
+
+    // A higher arrival pushes out the oldest of the lowest priority
+    RequestHandle evicted = INVALID_REQUEST;
+    RequestHandle corporate = f.make(Priority::CORPORATE, 2.0);
+    CHECK(buffer.addRequest(corporate, &evicted));
+    CHECK(evicted == free1);
+    CHECK(f.evicted(Priority::FREE) == 1);
+    CHECK(buffer.size() == 2);
+    f.pool.release(evicted);
+
+    // An arrival of the lowest waiting priority is turned away
+    RequestHandle free3 = f.make(Priority::FREE, 3.0);
+    CHECK(!buffer.addRequest(free3, &evicted));
+    CHECK(evicted == INVALID_REQUEST);
+    CHECK(f.rejected(Priority::FREE) == 1);
+    CHECK(buffer.popRequest() == corporate);
+    CHECK(buffer.popRequest() == free2);
+}
+
+TEST_CASE(buffer, full_fifo_buffer_rejects_and_serves_arrival_order) {
+    BufferFixture f;
+    BufferPolicySpec spec;
+    spec.kind = BufferPolicyKind::FIFO;
+    FifoBuffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 2, spec);
+    RequestHandle free = f.make(Priority::FREE, 0.0);
+    RequestHandle premium = f.make(Priority::PREMIUM, 1.0);
+    CHECK(buffer.addRequest(free));
+    CHECK(buffer.addRequest(premium));
+    CHECK(!buffer.addRequest(f.make(Priority::CORPORATE, 2.0)));
+    CHECK(f.rejected(Priority::CORPORATE) == 1);
+    CHECK(f.evicted(Priority::FREE) == 0);
+    CHECK(buffer.popRequest() == free);
+    CHECK(buffer.popRequest() == premium);
+}
+
+TEST_CASE(buffer, quota_caps_each_priority) {
+    BufferFixture f;
+    BufferPolicySpec spec;
+    spec.kind = BufferPolicyKind::QUOTA;
+    spec.quotaShare[static_cast<int>(Priority::FREE)] = 0.25;
+    QuotaBuffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 4, spec);
+    CHECK(buffer.addRequest(f.make(Priority::FREE, 0.0)));
+    CHECK(!buffer.addRequest(f.make(Priority::FREE, 1.0)));
+    CHECK(f.rejected(Priority::FREE) == 1);
+    CHECK(buffer.addRequest(f.make(Priority::PREMIUM, 2.0)));
+    CHECK(buffer.addRequest(f.make(Priority::PREMIUM, 3.0)));
+    CHECK(buffer.size() == 3);
+}
+
+TEST_CASE(buffer, deadline_serves_earliest_deadline) {
+    BufferFixture f;
+    BufferPolicySpec spec;
+    spec.kind = BufferPolicyKind::DEADLINE;
+    spec.deadlineHours[0] = 5.0;
+    spec.deadlineHours[2] = 1.0;
+    DeadlineBuffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 4, spec);
+    RequestHandle corporate = f.make(Priority::CORPORATE, 0.0); // due at 5
+    RequestHandle free = f.make(Priority::FREE, 1.0);           // due at 2
+    CHECK(buffer.addRequest(corporate));
+    CHECK(buffer.addRequest(free));
+    CHECK(buffer.popRequest() == free);
+    CHECK(buffer.popRequest() == corporate);
+}
+
+TEST_CASE(buffer, oldest_newest_and_removal) {
+    BufferFixture f;
+    Buffer buffer(f.pool, f.metrics, f.trace, f.eventLog, f.windows, 4);
+    RequestHandle a = f.make(Priority::PREMIUM, 0.0);
+    RequestHandle b = f.make(Priority::PREMIUM, 1.0);
+    RequestHandle c = f.make(Priority::PREMIUM, 2.0);
+    for (RequestHandle req : { a, b, c }) {
+        CHECK(buffer.addRequest(req));
+    }
+    CHECK(buffer.oldest(Priority::PREMIUM) == a);
+    CHECK(buffer.newest(Priority::PREMIUM) == c);
+    CHECK(buffer.oldest(Priority::FREE) == INVALID_REQUEST);
+
+    buffer.removeRequest(b);
+    CHECK(!buffer.contains(b));
+    CHECK(buffer.contains(a) && buffer.contains(c));
+    CHECK(buffer.size() == 2);
+    CHECK(buffer.popNewest(Priority::PREMIUM) == c);
+    CHECK(buffer.popRequest(Priority::PREMIUM) == a);
+    CHECK(buffer.isEmpty());
+}
@@ -0,0 +1,97 @@
+// Smoke tests of the C ABI in mss.h, linked against the mss_capi library only
+
+#include "Check.hpp"
+#include "mss.h"
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+mss_results emptyResults() {
+    mss_results results;
+    std::memset(&results, 0, sizeof(results));
+    results.struct_size = sizeof(results);
+    return results;
+}
+
+mss_config* smallScenario() {
+    mss_config* config = mss_config_create();
+    mss_config_set_int(config, "max_requests", 5000);
+    mss_config_set_int(config, "devices", 4);
+    return config;
+}
+
+} // namespace
+
+TEST_CASE(capi, version_and_config_setters) {
+    CHECK(mss_abi_version() == MSS_ABI_VERSION);
+    mss_config* config = mss_config_create();
+    CHECK(config != nullptr);
+    CHECK(mss_config_set_int(config, "devices", 7) == 0);
+    CHECK(mss_config_set_int(config, "no_such_key", 1) == -1);
+    CHECK(mss_config_set_int(config, "devices", 0) == -1);
+    CHECK(mss_config_set_int(nullptr, "devices", 7) == -1);
+
+    char error[128] = "";
+    CHECK(mss_config_apply(config, "[stop]\nmax_requests = 1000\n", error, sizeof(error)) == 0);
+    CHECK(mss_config_apply(config, "[stop]\nno_such_key = 1\n", error, sizeof(error)) == -1);
+    CHECK(std::strncmp(error, "line 2:", 7) == 0);
+    mss_config_destroy(config);
+}
+
+TEST_CASE(capi, run_is_reproducible_and_consistent) {
+    mss_config* config = smallScenario();
+    mss_results first = emptyResults();
+    mss_results second = emptyResults();
+    CHECK(mss_run(config, &first) == 0);
+    CHECK(mss_run(config, &second) == 0);
+    CHECK(first.generated == 5000);
+    CHECK(first.served + first.rejected == first.generated);
+    CHECK(first.rejected == first.rejected_by_priority[0] + first.rejected_by_priority[1]
+        + first.rejected_by_priority[2]);
+    CHECK(first.mean_utilization > 0.0 && first.mean_utilization <= 1.0);
+    CHECK(std::memcmp(&first, &second, sizeof(first)) == 0);
+
+    // A clone runs the same scenario; another seed another one
+    mss_config* clone = mss_config_clone(config);
+    mss_config_set_int(clone, "seed", 99);
+    mss_results other = emptyResults();
+    CHECK(mss_run(clone, &other) == 0);
+    CHECK(other.average_wait_hours != first.average_wait_hours);
+    mss_config_destroy(clone);
+    mss_config_destroy(config);
+}
+
+TEST_CASE(capi, older_callers_get_only_their_fields) {
+    mss_config* config = smallScenario();
+    mss_results results = emptyResults();
+    results.struct_size = offsetof(mss_results, rejection_rate);
+    results.mean_utilization = -1.0;
+    CHECK(mss_run(config, &results) == 0);
+    CHECK(results.generated == 5000);
+    CHECK(results.mean_utilization == -1.0);
+    mss_config_destroy(config);
+}
+
+TEST_CASE(capi, batch_matches_single_runs) {
+    mss_config* configs[3];
+    mss_results batch[3];
+    for (int i = 0; i < 3; ++i) {
+        configs[i] = smallScenario();
+        mss_config_set_int(configs[i], "devices", 3 + i);
+        batch[i] = emptyResults();
+    }
+    CHECK(mss_run_batch(configs, 3, 2, batch) == 0);
+    for (int i = 0; i < 3; ++i) {
+        mss_results single = emptyResults();
+        CHECK(mss_run(configs[i], &single) == 0);
+        CHECK(std::memcmp(&single, &batch[i], sizeof(single)) == 0);
+        mss_config_destroy(configs[i]);
+    }
+}
+
+TEST_CASE(capi, null_arguments_fail_with_a_message) {
+    mss_results results = emptyResults();
+    CHECK(mss_run(nullptr, &results) == -1);
+    CHECK(std::strlen(mss_last_error()) > 0);
+}
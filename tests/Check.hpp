@@ -0,0 +1,30 @@
+#pragma once
+#include <cmath>
+
+//------------------------------------------------------------------------------
+// Minimal test harness: TEST_CASE registers a function under a suite,
+// CHECK records a failure and lets the test go on (see TestMain.cpp)
+//------------------------------------------------------------------------------
+
+using TestFunction = void (*)();
+
+// Add a test to the registry; returns true, so it can run at static init
+bool registerTest(const char* suite, const char* name, TestFunction function);
+// Count a failed check of the running test and print where it is
+void reportFailure(const char* file, int line, const char* expression);
+
+#define TEST_CASE(suite, name)                                                        \
+    static void suite##_##name();                                                     \
+    static const bool suite##_##name##_registered = registerTest(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(expression)                                          \
+    do {                                                           \
+        if (!(expression)) {                                       \
+            reportFailure(__FILE__, __LINE__, #expression);        \
+        }                                                          \
+    } while (false)
+
+// |actual - expected| <= tolerance
+#define CHECK_NEAR(actual, expected, tolerance) \
+    CHECK(std::fabs((actual) - (expected)) <= (tolerance))
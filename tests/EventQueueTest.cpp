@@ -0,0 +1,82 @@
+// Every event-queue backend pops in time order
+
+#include "Check.hpp"
+#include "EventQueue.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+const EventQueueKind ALL_KINDS[] = {
+    EventQueueKind::BINARY_HEAP,
+    EventQueueKind::QUAD_HEAP,
+    EventQueueKind::CALENDAR,
+    EventQueueKind::LADDER
+};
+
+Event makeEvent(double time, int deviceId) {
+    return Event{ time, 0, EventType::REQUEST_SERVED, deviceId };
+}
+
+} // namespace
+
+TEST_CASE(event_queue, pops_a_batch_in_time_order) {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> time(0.0, 1000.0);
+    std::vector<Event> events;
+    for (int i = 0; i < 5000; ++i) {
+        events.push_back(makeEvent(time(rng), i));
+    }
+    for (EventQueueKind kind : ALL_KINDS) {
+        std::unique_ptr<EventQueue> queue = makeEventQueue(kind);
+        for (const Event& ev : events) {
+            queue->push(ev);
+        }
+        CHECK(queue->size() == events.size());
+        double last = -1.0;
+        bool ordered = true;
+        std::size_t popped = 0;
+        while (!queue->empty()) {
+            Event ev = queue->pop();
+            ordered = ordered && ev.time >= last;
+            last = ev.time;
+            popped++;
+        }
+        CHECK(ordered);
+        CHECK(popped == events.size());
+    }
+}
+
+TEST_CASE(event_queue, hold_model_stays_ordered) {
+    // The event loop's pattern: pop the earliest, push its successor later,
+    // with bursts of equal times and far-future events mixed in
+    for (EventQueueKind kind : ALL_KINDS) {
+        std::mt19937_64 rng(11);
+        std::exponential_distribution<double> increment(1.5);
+        std::unique_ptr<EventQueue> queue = makeEventQueue(kind);
+        for (int i = 0; i < 100; ++i) {
+            queue->push(makeEvent(increment(rng), i));
+        }
+        double now = 0.0;
+        bool ordered = true;
+        for (int op = 0; op < 200000; ++op) {
+            Event ev = queue->pop();
+            ordered = ordered && ev.time >= now;
+            now = ev.time;
+            ev.time = (op % 97 == 0) ? now : (op % 1009 == 0) ? now + 500.0 : now + increment(rng);
+            queue->push(ev);
+        }
+        CHECK(ordered);
+        CHECK(queue->size() == 100);
+    }
+}
+
+TEST_CASE(event_queue, names_round_trip) {
+    for (EventQueueKind kind : ALL_KINDS) {
+        EventQueueKind parsed = EventQueueKind::BINARY_HEAP;
+        CHECK(parseEventQueueKind(eventQueueKindName(kind), parsed));
+        CHECK(parsed == kind);
+    }
+    EventQueueKind unused = EventQueueKind::BINARY_HEAP;
+    CHECK(!parseEventQueueKind("splay", unused));
+}
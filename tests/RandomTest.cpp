@@ -0,0 +1,133 @@
+// Philox4x32 and VariateStream: known answers and reproducibility per (seed, stream)
+
+#include "Check.hpp"
+#include "Random.hpp"
+#include "Snapshot.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+std::vector<std::uint32_t> words(VariateStream& stream, int count) {
+    std::vector<std::uint32_t> out;
+    for (int i = 0; i < count; ++i) {
+        out.push_back(stream());
+    }
+    return out;
+}
+
+std::vector<double> exponentials(VariateStream& stream, int count) {
+    std::vector<double> out;
+    for (int i = 0; i < count; ++i) {
+        out.push_back(stream.exponential(1.0));
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE(random, philox_known_answer) {
+    // Philox4x32-10 with a zero key and counter (Random123 test vectors)
+    Philox4x32 generator(0, 0);
+    CHECK(generator() == 0x6627e8d5u);
+    CHECK(generator() == 0xe169c58du);
+    CHECK(generator() == 0xbc57ac4cu);
+    CHECK(generator() == 0x9b00dbd8u);
+}
+
+TEST_CASE(random, philox_bulk_matches_single_words) {
+    Philox4x32 single(42, streamId(StreamKind::DEVICE, 3));
+    Philox4x32 bulk(42, streamId(StreamKind::DEVICE, 3));
+    std::uint32_t block[64];
+    bulk.generate(block, 16);
+    bool same = true;
+    for (std::uint32_t word : block) {
+        same = same && single() == word;
+    }
+    CHECK(same);
+}
+
+TEST_CASE(random, streams_are_fixed_by_seed_and_stream) {
+    const std::uint64_t stream = streamId(StreamKind::SOURCE, 5);
+    VariateStream a(7, stream);
+    VariateStream b(7, stream);
+    VariateStream otherStream(7, streamId(StreamKind::SOURCE, 6));
+    VariateStream otherSeed(8, stream);
+
+    // Interleave words and exponentials across several block refills
+    std::vector<std::uint32_t> wordsA = words(a, 3 * VARIATE_BLOCK + 5);
+    std::vector<double> expA = exponentials(a, 2 * VARIATE_BLOCK + 1);
+    CHECK(wordsA == words(b, 3 * VARIATE_BLOCK + 5));
+    CHECK(expA == exponentials(b, 2 * VARIATE_BLOCK + 1));
+    CHECK(wordsA != words(otherStream, 3 * VARIATE_BLOCK + 5));
+    CHECK(wordsA != words(otherSeed, 3 * VARIATE_BLOCK + 5));
+
+    // Reseeding restarts the same sequence
+    a.seed(7, stream);
+    CHECK(words(a, 3 * VARIATE_BLOCK + 5) == wordsA);
+}
+
+TEST_CASE(random, variate_words_follow_philox) {
+    const std::uint64_t stream = streamId(StreamKind::DEVICE, 0);
+    Philox4x32 generator(3, stream);
+    VariateStream variates(3, stream);
+    VariateStream antithetic(3, stream, true);
+    bool same = true;
+    bool complemented = true;
+    for (int i = 0; i < 2 * VARIATE_BLOCK; ++i) {
+        std::uint32_t word = generator();
+        same = same && variates() == word;
+        complemented = complemented && antithetic() == ~word;
+    }
+    CHECK(same);
+    CHECK(complemented);
+    CHECK(antithetic.isAntithetic() && !variates.isAntithetic());
+}
+
+TEST_CASE(random, exponentials_have_unit_mean) {
+    VariateStream stream(1, streamId(StreamKind::CONTROLLER, 0));
+    const int count = 200000;
+    double sum = 0.0;
+    bool positive = true;
+    for (int i = 0; i < count; ++i) {
+        double x = stream.exponential(2.0);
+        positive = positive && x >= 0.0;
+        sum += x;
+    }
+    CHECK(positive);
+    CHECK_NEAR(sum / count, 0.5, 0.01);
+}
+
+TEST_CASE(random, keyed_uniforms_and_derived_seeds) {
+    double u = keyedUniform(9, streamId(StreamKind::DEMAND, 17), false);
+    CHECK(u >= 0.0 && u < 1.0);
+    CHECK(keyedUniform(9, streamId(StreamKind::DEMAND, 17), false) == u);
+    CHECK_NEAR(keyedUniform(9, streamId(StreamKind::DEMAND, 17), true), 1.0 - u, 1e-15);
+    CHECK(keyedUniform(9, streamId(StreamKind::DEMAND, 18), false) != u);
+    CHECK(replicationSeed(5, 1) == replicationSeed(5, 1));
+    CHECK(replicationSeed(5, 1) != replicationSeed(5, 2));
+    CHECK(shardSeed(5, 0) == 5);
+}
+
+TEST_CASE(random, stream_continues_after_save_and_load) {
+    const std::uint64_t stream = streamId(StreamKind::DEVICE, 2);
+    VariateStream original(4, stream);
+    words(original, VARIATE_BLOCK / 2);
+    exponentials(original, 3);
+
+    SnapshotWriter out;
+    original.save(out);
+    const char* path = "mss_test_stream.snap";
+    CHECK(out.save(path));
+    VariateStream restored;
+    {
+        MappedFile file;
+        CHECK(file.open(path));
+        SnapshotReader in(file.data(), file.size());
+        CHECK(restored.load(in));
+    }
+    std::remove(path);
+
+    CHECK(words(restored, 2 * VARIATE_BLOCK) == words(original, 2 * VARIATE_BLOCK));
+    CHECK(exponentials(restored, VARIATE_BLOCK + 3) == exponentials(original, VARIATE_BLOCK + 3));
+}
@@ -0,0 +1,69 @@
+// FIFO order and in-place cancellation (tombstones) of RequestRing
+
+#include "Check.hpp"
+#include "Simulation.hpp"
+#include <vector>
+
+TEST_CASE(request_ring, fifo_order) {
+    RequestRing ring(4);
+    CHECK(ring.isEmpty());
+    for (RequestHandle req = 0; req < 4; ++req) {
+        ring.push(req);
+    }
+    CHECK(ring.size() == 4);
+    CHECK(ring.front() == 0);
+    CHECK(ring.back() == 3);
+    CHECK(ring.popBack() == 3);
+    for (RequestHandle req = 0; req < 3; ++req) {
+        CHECK(ring.pop() == req);
+    }
+    CHECK(ring.isEmpty());
+}
+
+TEST_CASE(request_ring, cancelled_elements_are_skipped) {
+    RequestRing ring(8);
+    std::uint32_t positions[5];
+    for (RequestHandle req = 0; req < 5; ++req) {
+        positions[req] = ring.push(req);
+    }
+    CHECK(ring.holds(positions[2], 2));
+    CHECK(!ring.holds(positions[2], 3));
+
+    ring.cancel(positions[2]);
+    CHECK(!ring.holds(positions[2], 2));
+    CHECK(ring.size() == 4);
+
+    // Cancelling the head moves it past any tombstones behind it
+    ring.cancel(positions[0]);
+    ring.cancel(positions[1]);
+    CHECK(ring.size() == 2);
+    CHECK(ring.front() == 3);
+    CHECK(ring.pop() == 3);
+    CHECK(ring.pop() == 4);
+    CHECK(ring.isEmpty());
+}
+
+TEST_CASE(request_ring, grows_when_tombstones_fill_it) {
+    RequestRing ring(4);
+    std::vector<std::uint32_t> positions;
+    std::vector<RequestHandle> live;
+    // Keep at most two live elements, but cancel older ones in the middle,
+    // so the tombstones behind the head outgrow the initial capacity
+    for (RequestHandle req = 0; req < 40; ++req) {
+        positions.push_back(ring.push(req));
+        if (req % 3 == 1) {
+            ring.cancel(positions[req]);
+        }
+        else {
+            live.push_back(req);
+        }
+    }
+    CHECK(ring.size() == static_cast<int>(live.size()));
+    for (std::size_t i = 0; i < live.size(); ++i) {
+        CHECK(ring.holds(positions[live[i]], live[i]));
+    }
+    for (RequestHandle req : live) {
+        CHECK(ring.pop() == req);
+    }
+    CHECK(ring.isEmpty());
+}
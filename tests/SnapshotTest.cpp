@@ -0,0 +1,121 @@
+// A run saved and restored mid-way ends exactly as an uninterrupted one
+
+#include "Check.hpp"
+#include "Simulation.hpp"
+#include "Snapshot.hpp"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+const char* SNAPSHOT_PATH = "mss_test_run.snap";
+
+SimulationConfig testConfig() {
+    SimulationConfig config;
+    config.traceLevel = TraceLevel::OFF;
+    config.numDevices = 4;
+    config.maxRequests = 20000;
+    config.seed = 12;
+    return config;
+}
+
+template <class ControllerType>
+SimulationResults runThrough(const SimulationConfig& config) {
+    ControllerType controller(config);
+    controller.initRequests();
+    controller.work();
+    return controller.getResults();
+}
+
+// Run to half the simulated time of `full`, save, restore into a fresh
+// Controller and run on to the end
+template <class ControllerType>
+SimulationResults runInTwoHalves(const SimulationConfig& config, double stopHours, std::string& error) {
+    SimulationConfig firstHalf = config;
+    firstHalf.maxTimeHours = stopHours;
+    ControllerType first(firstHalf);
+    first.initRequests();
+    first.work();
+    if (!first.saveSnapshot(SNAPSHOT_PATH)) {
+        error = "cannot save";
+        return SimulationResults();
+    }
+
+    ControllerType second(config);
+    if (!second.restoreSnapshot(std::string(SNAPSHOT_PATH), error)) {
+        return SimulationResults();
+    }
+    second.work();
+    return second.getResults();
+}
+
+void checkSameResults(const SimulationResults& a, const SimulationResults& b) {
+    CHECK(a.generatedRequests == b.generatedRequests);
+    CHECK(a.servedRequests == b.servedRequests);
+    CHECK(a.rejectedRequests == b.rejectedRequests);
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        CHECK(a.rejectedByPriority[p] == b.rejectedByPriority[p]);
+    }
+    CHECK(a.averageWaitTime == b.averageWaitTime);
+    CHECK(a.simulationTime == b.simulationTime);
+    CHECK(a.deviceBusyTime == b.deviceBusyTime);
+}
+
+} // namespace
+
+TEST_CASE(snapshot, round_trip_resumes_exactly) {
+    SimulationConfig config = testConfig();
+    SimulationResults full = runThrough<Controller>(config);
+    CHECK(full.generatedRequests == config.maxRequests);
+
+    std::string error;
+    SimulationResults resumed = runInTwoHalves<Controller>(config, full.simulationTime / 2.0, error);
+    CHECK(error.empty());
+    checkSameResults(full, resumed);
+    std::remove(SNAPSHOT_PATH);
+}
+
+TEST_CASE(snapshot, round_trip_keeps_policy_state) {
+    // Weighted fair queuing keeps its passes between events
+    SimulationConfig config = testConfig();
+    config.bufferPolicy.kind = BufferPolicyKind::WEIGHTED_FAIR;
+    config.numDevices = 3;
+    SimulationResults full = runThrough<BasicController<WeightedFairBuffer>>(config);
+
+    std::string error;
+    SimulationResults resumed = runInTwoHalves<BasicController<WeightedFairBuffer>>(
+        config, full.simulationTime / 3.0, error);
+    CHECK(error.empty());
+    checkSameResults(full, resumed);
+    std::remove(SNAPSHOT_PATH);
+}
+
+TEST_CASE(snapshot, mismatched_or_damaged_snapshots_are_refused) {
+    SimulationConfig config = testConfig();
+    config.maxTimeHours = 10.0;
+    Controller saved(config);
+    saved.initRequests();
+    saved.work();
+    CHECK(saved.saveSnapshot(SNAPSHOT_PATH));
+
+    SimulationConfig other = testConfig();
+    other.numDevices = 5;
+    Controller mismatched(other);
+    std::string error;
+    CHECK(!mismatched.restoreSnapshot(std::string(SNAPSHOT_PATH), error));
+    CHECK(!error.empty());
+
+    {
+        MappedFile file;
+        CHECK(file.open(SNAPSHOT_PATH));
+        Controller truncated(testConfig());
+        error.clear();
+        CHECK(!truncated.restoreSnapshot(file.data(), file.size() / 2, error));
+        CHECK(!error.empty());
+
+        std::uint64_t seed = 0;
+        CHECK(readSnapshotSeed(file.data(), file.size(), seed));
+        CHECK(seed == config.seed);
+    }
+    std::remove(SNAPSHOT_PATH);
+}
@@ -0,0 +1,59 @@
+// Runs the registered tests: all of them, or those of the suite named by
+// the first argument (each suite is one ctest test). Exit status 1 if any
+// check failed or no test matched.
+
+#include "Check.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct RegisteredTest {
+    const char* suite;
+    const char* name;
+    TestFunction function;
+};
+
+// Built on first use, so registrations from any file's static init find it
+std::vector<RegisteredTest>& registry() {
+    static std::vector<RegisteredTest> tests;
+    return tests;
+}
+
+int failedChecks = 0;
+
+} // namespace
+
+bool registerTest(const char* suite, const char* name, TestFunction function) {
+    registry().push_back(RegisteredTest{ suite, name, function });
+    return true;
+}
+
+void reportFailure(const char* file, int line, const char* expression) {
+    std::printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+    failedChecks++;
+}
+
+int main(int argc, char* argv[]) {
+    const char* suite = (argc > 1) ? argv[1] : nullptr;
+    int run = 0;
+    int failedTests = 0;
+    for (const RegisteredTest& test : registry()) {
+        if (suite && std::strcmp(suite, test.suite) != 0) {
+            continue;
+        }
+        int before = failedChecks;
+        test.function();
+        run++;
+        bool passed = failedChecks == before;
+        failedTests += passed ? 0 : 1;
+        std::printf("[%s] %s.%s\n", passed ? "  OK  " : " FAIL ", test.suite, test.name);
+    }
+    if (run == 0) {
+        std::printf("No tests in suite \"%s\"\n", suite ? suite : "");
+        return 1;
+    }
+    std::printf("%d of %d tests passed\n", run - failedTests, run);
+    return (failedTests == 0) ? 0 : 1;
+}
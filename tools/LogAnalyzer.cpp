@@ -0,0 +1,236 @@
+// Offline analysis of an event log written with --event-log=FILE.
+//
+// The log is memory-mapped and scanned column by column, so the metrics of
+// printStatistics are recomputed without re-running the simulation (and
+// match it exactly for the whole run). --from/--to restrict every metric
+// to a time range, e.g. to drop the warm-up; --hourly adds a per-hour
+// table of arrivals, service starts, losses and mean wait.
+//
+// Build: cmake target mss_log
+//   mss_log events.bin [--from=H] [--to=H] [--hourly]
+
+#include "EventLog.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counters of one hour for --hourly
+struct HourRow {
+    std::uint64_t arrivals = 0;
+    std::uint64_t served = 0;
+    std::uint64_t lost = 0;
+    double waitSum = 0.0;
+};
+
+struct LogMetrics {
+    std::uint64_t generated = 0;
+    std::uint64_t served = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t rejectedByPriority[PRIORITY_COUNT] = {};
+    double totalWait = 0.0;
+    LatencyStats latency[PRIORITY_COUNT];
+    std::vector<double> deviceBusy;  // hours inside the range, by device index
+    double lastTime = 0.0;           // time of the last record
+    std::vector<HourRow> hours;
+};
+
+// Grow v so that index is valid
+template <typename T>
+void ensureIndex(std::vector<T>& v, std::size_t index) {
+    if (index >= v.size()) {
+        v.resize(index + 1 + index / 2);
+    }
+}
+
+// One pass over all blocks. Arrival and service-start times are kept by
+// request id and device, so sojourns and busy intervals that begin before
+// `from` are still measured correctly.
+LogMetrics analyze(const EventLogReader& log, double from, double to, bool hourly) {
+    LogMetrics m;
+    m.deviceBusy.assign(log.getNumDevices(), 0.0);
+    std::vector<double> arrivalTime;
+    std::vector<double> serviceStart(log.getNumDevices() + 1, 0.0);
+    std::size_t hoursSeen = 0;
+
+    for (int b = 0; b < log.getBlockCount(); ++b) {
+        const EventLogColumns& block = log.getBlock(b);
+        for (std::uint32_t i = 0; i < block.rows; ++i) {
+            double t = block.time[i];
+            std::uint32_t id = block.request[i];
+            int priority = block.priority[i] % PRIORITY_COUNT;
+            LogEventType type = static_cast<LogEventType>(block.type[i]);
+            bool inRange = t >= from && t < to;
+            if (t > m.lastTime) {
+                m.lastTime = t;
+            }
+            HourRow* hour = nullptr;
+            if (hourly && inRange) {
+                std::size_t h = static_cast<std::size_t>(t);
+                ensureIndex(m.hours, h);
+                hour = &m.hours[h];
+                hoursSeen = std::max(hoursSeen, h + 1);
+            }
+
+            switch (type) {
+            case LogEventType::ARRIVAL:
+                ensureIndex(arrivalTime, id);
+                arrivalTime[id] = t;
+                if (inRange) {
+                    m.generated++;
+                    if (hour) {
+                        hour->arrivals++;
+                    }
+                }
+                break;
+            case LogEventType::REJECTED:
+            case LogEventType::EVICTED:
+            case LogEventType::RENEGED:
+                if (inRange) {
+                    m.rejected++;
+                    m.rejectedByPriority[priority]++;
+                    if (hour) {
+                        hour->lost++;
+                    }
+                }
+                break;
+            case LogEventType::RETRY:
+                // Follows the REJECTED, EVICTED or RENEGED row it takes back
+                if (inRange) {
+                    m.rejected--;
+                    m.rejectedByPriority[priority]--;
+                    if (hour) {
+                        hour->lost--;
+                    }
+                }
+                break;
+            case LogEventType::SERVICE_START: {
+                std::size_t device = block.device[i];
+                if (device < serviceStart.size()) {
+                    serviceStart[device] = t;
+                }
+                if (inRange) {
+                    m.served++;
+                    m.totalWait += block.wait[i];
+                    m.latency[priority].wait.record(block.wait[i]);
+                    if (hour) {
+                        hour->served++;
+                        hour->waitSum += block.wait[i];
+                    }
+                }
+                break;
+            }
+            case LogEventType::SERVICE_END: {
+                std::size_t device = block.device[i];
+                if (device == 0 || device >= serviceStart.size()) {
+                    break;
+                }
+                double start = std::max(serviceStart[device], from);
+                double end = std::min(t, to);
+                if (end > start) {
+                    m.deviceBusy[device - 1] += end - start;
+                }
+                serviceStart[device] = t; // the rest of a batch ends here too
+                if (inRange && id < arrivalTime.size()) {
+                    m.latency[priority].sojourn.record(t - arrivalTime[id]);
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    m.hours.resize(hoursSeen);
+    return m;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " EVENTS.bin [--from=H] [--to=H] [--hourly]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    double from = 0.0;
+    double to = std::numeric_limits<double>::infinity();
+    bool hourly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 7, "--from=") == 0) {
+            from = std::atof(arg.c_str() + 7);
+        }
+        else if (arg.compare(0, 5, "--to=") == 0) {
+            to = std::atof(arg.c_str() + 5);
+        }
+        else if (arg == "--hourly") {
+            hourly = true;
+        }
+        else if (path.empty() && arg.compare(0, 2, "--") != 0) {
+            path = arg;
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty() || !(to > from)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    EventLogReader log;
+    std::string error;
+    if (!log.open(path, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    LogMetrics m = analyze(log, from, to, hourly);
+
+    std::cout << "\n--- Statistics from " << path << " (" << log.getRecordCount() << " records) ---\n";
+    std::cout << "Total requests generated:  " << m.generated << "\n";
+    std::cout << "Total requests served:     " << m.served << "\n";
+    std::cout << "Total rejected requests:   " << m.rejected << "\n";
+
+    std::cout << "Rejected Corporate: " << m.rejectedByPriority[static_cast<int>(Priority::CORPORATE)] << "\n";
+    std::cout << "Rejected Premium:   " << m.rejectedByPriority[static_cast<int>(Priority::PREMIUM)] << "\n";
+    std::cout << "Rejected Free:      " << m.rejectedByPriority[static_cast<int>(Priority::FREE)] << "\n";
+
+    double avgWaitTime = (m.served > 0) ? m.totalWait / static_cast<double>(m.served) : 0.0;
+    std::cout << "Average waiting time (hours): " << avgWaitTime
+        << " (~" << (avgWaitTime * 60.0) << " min)\n";
+    printLatencyStatistics(m.latency);
+
+    // Utilization over the part of the range the log covers
+    double span = std::min(to, m.lastTime) - from;
+    std::cout << "\nDevices utilization:\n";
+    for (std::size_t d = 0; d < m.deviceBusy.size(); ++d) {
+        double utilization = (span > 0.0) ? (m.deviceBusy[d] / span) : 0.0;
+        std::cout << "  Device " << (d + 1)
+            << ": busy " << m.deviceBusy[d] << " h, load "
+            << (utilization * 100.0) << " %\n";
+    }
+
+    if (hourly) {
+        std::cout << "\n    hour  arrivals    served      lost  wait (min)\n";
+        for (std::size_t h = static_cast<std::size_t>(from); h < m.hours.size(); ++h) {
+            const HourRow& row = m.hours[h];
+            double wait = (row.served > 0) ? row.waitSum / static_cast<double>(row.served) * 60.0 : 0.0;
+            char line[96];
+            std::snprintf(line, sizeof(line), "%8zu %9llu %9llu %9llu %11.2f\n", h,
+                static_cast<unsigned long long>(row.arrivals), static_cast<unsigned long long>(row.served),
+                static_cast<unsigned long long>(row.lost), wait);
+            std::cout << line;
+        }
+    }
+
+    std::cout << "\nTotal simulation time: " << m.lastTime << " hours\n";
+    return 0;
+}
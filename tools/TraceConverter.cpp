@@ -0,0 +1,186 @@
+// Converts a CSV arrival log into the trace file replayed with --replay.
+//
+// Each line is "time,priority[,demand]": the arrival time, the priority
+// (0-2 or corporate/premium/free) and optionally the service demand;
+// without one, the device draws it. --unit gives the unit of both times
+// (default hours). Times are shifted so the first row arrives at 0 and
+// must not decrease. A first line that is not a row (a header) is skipped,
+// as are empty lines and # comments.
+//
+// The log is read twice, once to count the rows and once to write them,
+// so a log of any length converts without holding it in memory.
+//
+// Build: cmake target mss_trace
+//   mss_trace arrivals.csv arrivals.trace [--unit=hours|minutes|seconds]
+
+#include "ArrivalTrace.hpp"
+#include "Simulation.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// One parsed CSV line
+struct TraceRow {
+    double time = 0.0;
+    int priority = 0;
+    double demand = 0.0;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+        << " arrivals.csv arrivals.trace [--unit=hours|minutes|seconds]\n";
+}
+
+bool parsePriority(const std::string& text, int& priority) {
+    if (text == "corporate" || text == "0") {
+        priority = static_cast<int>(Priority::CORPORATE);
+    }
+    else if (text == "premium" || text == "1") {
+        priority = static_cast<int>(Priority::PREMIUM);
+    }
+    else if (text == "free" || text == "2") {
+        priority = static_cast<int>(Priority::FREE);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end == text.c_str() + text.size();
+}
+
+// Trim spaces and a trailing \r
+std::string trim(const std::string& text) {
+    std::size_t first = text.find_first_not_of(" \t\r");
+    std::size_t last = text.find_last_not_of(" \t\r");
+    return (first == std::string::npos) ? std::string() : text.substr(first, last - first + 1);
+}
+
+// Parse "time,priority[,demand]"; false if the line is not a row
+bool parseRow(const std::string& line, TraceRow& row) {
+    std::size_t first = line.find(',');
+    if (first == std::string::npos) {
+        return false;
+    }
+    std::size_t second = line.find(',', first + 1);
+    std::string demand = (second == std::string::npos) ? std::string() : trim(line.substr(second + 1));
+    row.demand = 0.0;
+    return parseNumber(trim(line.substr(0, first)), row.time)
+        && parsePriority(trim(line.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1)), row.priority)
+        && (demand.empty() || (parseNumber(demand, row.demand) && row.demand >= 0.0));
+}
+
+// Rows of the log in order: calls visit(row, lineNumber) for each, skipping
+// blank lines, comments and a header; false at the first bad line
+template <typename Visit>
+bool readRows(const std::string& path, Visit visit, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::string line;
+    long long number = 0;
+    bool seenRow = false;
+    while (std::getline(in, line)) {
+        ++number;
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        if (trim(line).empty()) {
+            continue;
+        }
+        TraceRow row;
+        if (!parseRow(line, row)) {
+            if (!seenRow) {
+                seenRow = true; // the header
+                continue;
+            }
+            error = path + ":" + std::to_string(number) + ": expected time,priority[,demand]";
+            return false;
+        }
+        seenRow = true;
+        if (!visit(row, number)) {
+            error = path + ":" + std::to_string(number) + ": time goes backwards";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string output;
+    double hoursPerUnit = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--unit=hours" || arg == "--unit=minutes" || arg == "--unit=seconds") {
+            hoursPerUnit = (arg == "--unit=hours") ? 1.0 : (arg == "--unit=minutes") ? 1.0 / 60.0 : 1.0 / 3600.0;
+        }
+        else if (input.empty() && arg.compare(0, 2, "--") != 0) {
+            input = arg;
+        }
+        else if (output.empty() && arg.compare(0, 2, "--") != 0) {
+            output = arg;
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (input.empty() || output.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Pass 1: count the rows, find the origin and check the order
+    std::uint64_t rows = 0;
+    double origin = 0.0;
+    double last = 0.0;
+    std::string error;
+    bool counted = readRows(input, [&](const TraceRow& row, long long) {
+        if (rows == 0) {
+            origin = row.time;
+            last = row.time;
+        }
+        if (row.time < last) {
+            return false;
+        }
+        last = row.time;
+        ++rows;
+        return true;
+    }, error);
+    if (!counted) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    // Pass 2: every row straight into its columns
+    ArrivalTraceWriter writer;
+    if (!writer.open(output, rows)) {
+        std::cerr << "Cannot write " << output << "\n";
+        return 1;
+    }
+    readRows(input, [&](const TraceRow& row, long long) {
+        writer.append((row.time - origin) * hoursPerUnit, row.priority, row.demand * hoursPerUnit);
+        return true;
+    }, error);
+    if (!writer.close()) {
+        std::cerr << "Cannot write " << output << " (or " << input << " changed meanwhile)\n";
+        return 1;
+    }
+    std::cout << rows << " arrivals over " << (last - origin) * hoursPerUnit << " hours written to "
+        << output << "\n";
+    return 0;
+}